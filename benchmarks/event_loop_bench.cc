@@ -0,0 +1,277 @@
+/**
+ * @file event_loop_bench.cc
+ * @brief Thread count and context switch rate of many VHAL client objects,
+ *        thread-per-object vs. a shared EventLoop.
+ * @version 0.1
+ * @date 2021-08-11
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Usage: event_loop_bench [instances] [seconds] [loop threads]
+ *
+ * Every instance gets a VideoSink and a SensorInterface connected over Unix
+ * sockets to an in-process stand-in VHAL, which sends each sensor a control
+ * packet every 100 ms. The stand-in runs on one epoll thread in both modes,
+ * so the difference between the rows is the client side only.
+ */
+#include "event_loop.h"
+#include "sensor_interface.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+int
+ThreadCount()
+{
+    int  count = 0;
+    DIR* dir   = opendir("/proc/self/task");
+    while (struct dirent* entry = readdir(dir)) {
+        count += entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return count;
+}
+
+int
+Listen(const std::string& path)
+{
+    int                fd   = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr = {};
+    addr.sun_family         = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        ::listen(fd, 16) < 0) {
+        perror(path.c_str());
+        exit(1);
+    }
+    return fd;
+}
+
+// Accepts every client and pokes the sensor connections periodically.
+class StandInVhal
+{
+public:
+    StandInVhal(const std::string& dir, int instances)
+    {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        for (int i = 0; i < instances; i++) {
+            AddListener(dir + "/camera-socket" + std::to_string(i), false);
+            AddListener(dir + "/sensors-socket" + std::to_string(i), true);
+        }
+        thread_ = std::thread([this]() { Run(); });
+    }
+
+    ~StandInVhal()
+    {
+        running_ = false;
+        thread_.join();
+        for (auto& l : listeners_) {
+            close(l.fd);
+            unlink(l.path.c_str());
+        }
+        for (int fd : sensors_) {
+            close(fd);
+        }
+        for (int fd : cameras_) {
+            close(fd);
+        }
+        close(epoll_fd_);
+    }
+
+    size_t Connections() const { return connections_; }
+
+private:
+    struct Listener
+    {
+        std::string path;
+        int         fd;
+        bool        sensor;
+    };
+
+    void AddListener(const std::string& path, bool sensor)
+    {
+        listeners_.push_back({ path, Listen(path), sensor });
+    }
+
+    void Run()
+    {
+        for (size_t i = 0; i < listeners_.size(); i++) {
+            struct epoll_event ev = {};
+            ev.events             = EPOLLIN;
+            ev.data.u64           = i;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listeners_[i].fd, &ev);
+        }
+        auto next_poke = steady_clock::now();
+        while (running_) {
+            struct epoll_event events[64];
+            int n = epoll_wait(epoll_fd_, events, std::size(events), 100);
+            for (int i = 0; i < n; i++) {
+                auto& l  = listeners_[events[i].data.u64];
+                int   fd = ::accept4(l.fd, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd < 0) {
+                    continue;
+                }
+                (l.sensor ? sensors_ : cameras_).push_back(fd);
+                connections_++;
+            }
+            if (steady_clock::now() >= next_poke) {
+                next_poke += milliseconds(100);
+                SensorInterface::CtrlPacket packet = {
+                    SENSOR_TYPE_ACCELEROMETER, 1, 10000000
+                };
+                for (int fd : sensors_) {
+                    if (::send(fd, &packet, sizeof(packet), MSG_NOSIGNAL) < 0) {
+                        // Client went away; it will reconnect.
+                    }
+                }
+            }
+        }
+    }
+
+    int                   epoll_fd_ = -1;
+    std::vector<Listener> listeners_;
+    std::vector<int>      sensors_;
+    std::vector<int>      cameras_;
+    std::atomic<size_t>   connections_ = 0;
+    std::atomic<bool>     running_     = true;
+    std::thread           thread_;
+};
+
+struct Sample
+{
+    int    threads;
+    double csw_per_sec;
+    double cpu_percent;
+    size_t callbacks;
+};
+
+Sample
+Measure(const std::string& dir,
+        int                instances,
+        int                seconds_to_run,
+        unsigned int       loop_threads)
+{
+    StandInVhal vhal(dir, instances);
+
+    std::shared_ptr<EventLoop> loop;
+    if (loop_threads > 0) {
+        loop = std::make_shared<EventLoop>(loop_threads);
+    }
+
+    std::atomic<size_t>                           callbacks = 0;
+    std::vector<std::unique_ptr<VideoSink>>       cameras;
+    std::vector<std::unique_ptr<SensorInterface>> sensors;
+    for (int i = 0; i < instances; i++) {
+        UnixConnectionInfo info = { dir, i, loop };
+        cameras.push_back(std::make_unique<VideoSink>(
+          info, [](const VideoSink::camera_config_cmd_t&) {}));
+        sensors.push_back(std::make_unique<SensorInterface>(info));
+        sensors.back()->RegisterCallback(
+          [&callbacks](const SensorInterface::CtrlPacket&) { callbacks++; });
+    }
+    while (vhal.Connections() < size_t(instances) * 2) {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    // Let the connect storm settle before measuring.
+    std::this_thread::sleep_for(milliseconds(500));
+
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    size_t callbacks_before = callbacks;
+    auto   start            = steady_clock::now();
+    std::this_thread::sleep_for(seconds(seconds_to_run));
+    getrusage(RUSAGE_SELF, &after);
+    double elapsed = duration<double>(steady_clock::now() - start).count();
+
+    auto cpu = [](const struct rusage& r) {
+        return r.ru_utime.tv_sec + r.ru_stime.tv_sec +
+               (r.ru_utime.tv_usec + r.ru_stime.tv_usec) / 1e6;
+    };
+    Sample sample;
+    sample.threads     = ThreadCount();
+    sample.csw_per_sec = (after.ru_nvcsw + after.ru_nivcsw - before.ru_nvcsw -
+                          before.ru_nivcsw) /
+                         elapsed;
+    sample.cpu_percent = 100 * (cpu(after) - cpu(before)) / elapsed;
+    sample.callbacks   = callbacks - callbacks_before;
+    return sample;
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    int          instances    = argc > 1 ? atoi(argv[1]) : 100;
+    int          seconds      = argc > 2 ? atoi(argv[2]) : 5;
+    unsigned int loop_threads = argc > 3 ? atoi(argv[3]) : 1;
+
+    char tmpl[] = "/tmp/vhal-bench-XXXXXX";
+    if (mkdtemp(tmpl) == nullptr) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string dir = tmpl;
+
+    // Client objects print on every connect; keep the table readable.
+    std::cout.setstate(std::ios::failbit);
+    Sample threaded = Measure(dir, instances, seconds, 0);
+    Sample looped   = Measure(dir, instances, seconds, loop_threads);
+    std::cout.clear();
+
+    printf("%d instances x (VideoSink + SensorInterface), %ds\n",
+           instances,
+           seconds);
+    printf("%-22s %8s %12s %8s %10s\n",
+           "mode", "threads", "csw/s", "cpu%", "callbacks");
+    printf("%-22s %8d %12.0f %8.1f %10zu\n",
+           "thread per object",
+           threaded.threads,
+           threaded.csw_per_sec,
+           threaded.cpu_percent,
+           threaded.callbacks);
+    std::string loop_name = "EventLoop(" + std::to_string(loop_threads) + ")";
+    printf("%-22s %8d %12.0f %8.1f %10zu\n",
+           loop_name.c_str(),
+           looped.threads,
+           looped.csw_per_sec,
+           looped.cpu_percent,
+           looped.callbacks);
+
+    rmdir(dir.c_str());
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file video_sink_bench.cc
+ * @brief Per-frame cost of VideoSink::SendDataPacket() with the VHAL
+ *        replaced by an in-process loopback peer.
+ * @version 0.1
+ * @date 2021-08-13
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Usage: video_sink_bench [frames per size]
+ *
+ * A drain thread reads the peer end of the socketpair as fast as it can, so
+ * the numbers are the library and kernel socket cost only, without any
+ * Android VM in the way.
+ */
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// Reads and discards everything the sink writes.
+class Drain
+{
+public:
+    ~Drain()
+    {
+        if (fd_ >= 0) {
+            ::shutdown(fd_, SHUT_RDWR);
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    void Start(int fd)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fd_     = fd;
+        thread_ = std::thread([fd]() {
+            std::vector<uint8_t> buf(1 << 20);
+            while (::recv(fd, buf.data(), buf.size(), 0) > 0) {
+            }
+        });
+        cv_.notify_all();
+    }
+
+    void WaitStarted()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return fd_ >= 0; });
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    int                     fd_ = -1;
+    std::thread             thread_;
+};
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+
+    Drain drain;
+    // Client objects print on every connect; keep the table readable.
+    std::cout.setstate(std::ios::failbit);
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(
+                     [&drain](int fd) { drain.Start(fd); }),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    drain.WaitStarted();
+    while (!sink.IsConnected()) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    printf("%-12s %10s %12s %10s\n", "frame bytes", "frames", "us/frame", "MB/s");
+    for (size_t size : { 4096, 65536, 460800, 3110400 }) {
+        std::vector<uint8_t> frame(size, 0x80);
+        auto                 start = steady_clock::now();
+        for (int i = 0; i < frames; i++) {
+            sink.SendDataPacket(frame.data(), frame.size());
+        }
+        double elapsed = duration<double>(steady_clock::now() - start).count();
+        printf("%-12zu %10d %12.2f %10.1f\n",
+               size,
+               frames,
+               1e6 * elapsed / frames,
+               size * frames / elapsed / 1e6);
+    }
+    std::cout.clear();
+    return 0;
+}
@@ -62,6 +62,11 @@ main(int argc, char** argv)
     atomic<bool>            stop     = false;
     thread                  file_src_thread;
     shared_ptr<VideoSink>   video_sink;
+    auto                    codec = VideoSink::VideoCodecType::kH264;
+    if (filename.size() > 5 &&
+        filename.compare(filename.size() - 5, 5, ".h265") == 0) {
+        codec = VideoSink::VideoCodecType::kH265;
+    }
 
     UnixConnectionInfo conn_info = { socket_path, instance_id };
     try {
@@ -92,16 +97,14 @@ main(int argc, char** argv)
                         }
                         cout << "Will start reading from file: " << filename
                              << '\n';
-                        const size_t av_input_buffer_padding_size = 64;
-                        const size_t inbuf_size                   = 4 * 1024;
-                        array<uint8_t, inbuf_size + av_input_buffer_padding_size>
-                          inbuf;
+                        const size_t inbuf_size = 4 * 1024;
+                        array<uint8_t, inbuf_size> inbuf;
                         while (!stop) {
                             istrm.read(reinterpret_cast<char*>(inbuf.data()),
                                        inbuf_size); // binary input
-                            if (!istrm.gcount() or istrm.eof()) {
-                                //   istrm.clear();
-                                //   istrm.seekg(0);
+                            if (!istrm.gcount()) {
+                                // Send the last picture before starting over.
+                                video_sink->FlushAccessUnits();
                                 istrm.close();
                                 istrm.open(filename, istrm.binary | istrm.in);
                                 if (!istrm.is_open()) {
@@ -112,18 +115,15 @@ main(int argc, char** argv)
                                      << "\n";
                                 continue;
                             }
-                            // Send payload
-                            if (auto [sent, error_msg] =
-                                  video_sink->SendDataPacket(inbuf.data(), inbuf_size);
+                            // The file is cut into whole pictures, each sent
+                            // on its own 30 fps deadline.
+                            if (auto [sent, error_msg] = video_sink->SendAccessUnits(
+                                  inbuf.data(), istrm.gcount());
                                 sent < 0) {
                                 cout << "Error in writing payload to Camera VHal: "
                                      << error_msg << "\n";
                                 exit(1);
                             }
-                            cout << "[rate=30fps] Sent " << istrm.gcount()
-                                 << " bytes to Camera VHal.\n";
-                            // sleep for 33ms to maintain 30 fps
-                            this_thread::sleep_for(33ms);
                         }
                     });
                     break;
@@ -145,6 +145,9 @@ main(int argc, char** argv)
         exit(1);
     }
 
+    video_sink->SetFrameCodec(codec);
+    video_sink->SetFrameRate(30);
+
     cout << "Waiting Camera Open callback..\n";
 
     while (!video_sink->IsConnected())
@@ -155,7 +158,7 @@ main(int argc, char** argv)
     std::vector<VideoSink::camera_info_t> camera_info(NUM_OF_CAMERAS_REQUESTED);
 
     for (int i = 0; i < NUM_OF_CAMERAS_REQUESTED; i++) {
-        camera_info[i].codec_type = VideoSink::VideoCodecType::kH264;
+        camera_info[i].codec_type = codec;
         camera_info[i].resolution = VideoSink::FrameResolution::k1080p;
     }
     cout << "Calling SetCameraCapabilty..\n";
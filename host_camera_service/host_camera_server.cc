@@ -76,7 +76,6 @@ AVPacket *pkt;
 int v4l2_format = VideoSink::VideoCodecType::kMJPEG; 
 #define BUF_COUNT 4
 unsigned int buf_count = 0;
-unsigned char *buf_list[BUF_COUNT];
 
 pthread_mutex_t mMainLock = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t mSignalMain = PTHREAD_COND_INITIALIZER;
@@ -265,16 +264,31 @@ int open_camera()
 
 void* InitCamera(void *arg)
 {
+    // Once negotiated, the library renegotiates by itself on reconnect.
+    video_sink->EnableSessionResume([](const VideoSink::ResumeEvent& event) {
+        cout << "[Stream] session resumed, camera info "
+             << (event.acked ? "acknowledged" : "not acknowledged")
+             << (event.camera_open ? ", camera still open\n" : "\n");
+    });
     while(true) {
         video_sink->ResetCameraCapabilty();
         cout <<"[Stream] start capabilty exchange";
-        video_sink->GetCameraCapabilty();
+        auto capability = video_sink->GetCameraCapabilty();
+        if (!capability) {
+            cout << "[Stream] no capability from Camera VHal\n";
+        }
         std::vector<VideoSink::camera_info_t> camera_info(NUM_OF_CAMERAS_REQUESTED);
         for (int i = 0; i < NUM_OF_CAMERAS_REQUESTED; i++) {
             camera_info[i].codec_type = (VideoSink::VideoCodecType)v4l2_format;
             camera_info[i].resolution = VideoSink::FrameResolution::k1080p;
+            // Frame timestamps, if the VHal understands them.
+            camera_info[i].features =
+              capability ? capability->features & VideoSink::kFeatureFrameMetadata : 0;
+        }
+        if (video_sink->SetCameraCapabilty(camera_info)) {
+            return NULL;
         }
-        video_sink->SetCameraCapabilty(camera_info);
+        cout << "[Stream] camera info not acknowledged by Camera VHal\n";
     }
 }
 
@@ -315,8 +329,9 @@ int main(int argc, char** argv)
     pkt = av_packet_alloc();
     av_init_packet(pkt);
     buf_count = 0;
-    //create buffer
+    //create buffers, reused across camera open/close
     const size_t inbuf_size = width * height * 1.5;
+    FrameBufferPool frame_pool(inbuf_size, BUF_COUNT);
     
     VsockConnectionInfo conn_info = { instance_id };
     try {
@@ -336,8 +351,6 @@ int main(int argc, char** argv)
                   pthread_mutex_unlock(&thread_lock);
 
 		  this_thread::sleep_for(100ms);
-                  for(int count = 0; count < BUF_COUNT; count++)
-                      free(buf_list[count]);
 
 		  avformat_close_input(&stream_ctx->ifmt_ctx);
                   avformat_close_input(&stream_ctx->ofmt_ctx);
@@ -349,33 +362,32 @@ int main(int argc, char** argv)
 		  }
                   pthread_mutex_lock(&thread_lock);
                   stop = false;
-                  for(int count = 0; count < BUF_COUNT; count++)
-                      buf_list[count] = (unsigned char*)calloc(1, inbuf_size);
                   open_camera();
                   open_close_count++;
                   file_src_thread = thread([&stop,
                                             &video_sink,
-                                            &device_index]() {
-
-                     const size_t inbuf_size = width * height * 1.5;
-		     struct timeval tval_before, tval_after, tval_result;
+                                            &device_index,
+                                            &frame_pool]() {
 
                       while (!stop) {
-                          gettimeofday(&tval_before, NULL);
-		      
                           if(av_read_frame(stream_ctx->ifmt_ctx, pkt) < 0)
                               cout << "[Stream] Fail to read frame";
                           //dumpFrame(pkt->data, pkt->size);
 			  if(v4l2_format == VideoSink::VideoCodecType::kI420) {
-                              yuyv422_to_yuv420sp(pkt->data, buf_list[buf_count                                  % BUF_COUNT], width, height, false);
-                        
-			      // Write payload
-                              if (auto [sent, error_msg] =
-                                  video_sink->SendDataPacket(buf_list[buf_count                                      % BUF_COUNT],
-                                     inbuf_size);
-                                  sent < 0) {
-                                        cout <<"[Stream] closing camera as pack                                            et send failed: "
-                                            << error_msg << "\n";
+                              // Buffers go back to the pool once sent.
+                              FrameBuffer frame = frame_pool.Acquire();
+                              if (!frame) {
+                                  cout << "[Stream] no free frame buffer, frame dropped\n";
+                              } else {
+                                  yuyv422_to_yuv420sp(pkt->data, frame.Data(), width, height, false);
+
+                                  // Write payload
+                                  if (auto [sent, error_msg] =
+                                      video_sink->SendDataPacket(std::move(frame));
+                                      sent < 0) {
+                                            cout <<"[Stream] closing camera as pack                                            et send failed: "
+                                                << error_msg << "\n";
+                                  }
                               }
 			 
 		          }else {
@@ -388,18 +400,8 @@ int main(int argc, char** argv)
                                  }
                           }
                           buf_count++;
-			  gettimeofday(&tval_after, NULL);
-timersub(&tval_after, &tval_before, &tval_result);
-unsigned int sleep_time = (33 - (tval_result.tv_usec /1000));
-    std::chrono::duration<double, std::milli> elapsed = (std::chrono::duration<double, std::milli>)sleep_time;
-                          
-                          
-//this_thread::sleep_for(33ms);
 			  av_packet_unref(pkt);
                           av_new_packet(pkt, 0);
-
-//if(sleep_time > 1)
-this_thread::sleep_for(32ms);
                       }
 		      cout <<"camera thread exit "<<"\n";
                       pthread_cond_signal(&thread_running);
@@ -414,10 +416,19 @@ this_thread::sleep_for(32ms);
                   pthread_cond_wait(&thread_running, &thread_lock);
                   pthread_mutex_unlock(&thread_lock);
 		  this_thread::sleep_for(100ms);
-                  for(int count = 0; count < BUF_COUNT; count++)
-                      free(buf_list[count]);
 
                   cout << "[Stream] Received Close command from Camera VHal\n";
+                  {
+                      auto stats = video_sink->GetStats();
+                      cout << "[Stream] sent " << stats.frames_sent << " frames, "
+                           << stats.send_errors << " errors, send p50/p99/max "
+                           << stats.send_latency.p50.count() / 1000 << "/"
+                           << stats.send_latency.p99.count() / 1000 << "/"
+                           << stats.send_latency.max.count() / 1000 << " us, blocked "
+                           << chrono::duration_cast<chrono::milliseconds>(
+                                stats.send_blocked).count()
+                           << " ms, " << stats.reconnects << " reconnects\n";
+                  }
 		  avformat_close_input(&stream_ctx->ifmt_ctx);
                   avformat_close_input(&stream_ctx->ofmt_ctx);
                   free(stream_ctx);
@@ -436,6 +447,13 @@ this_thread::sleep_for(32ms);
                   break;
           }
       });
+        // Capture must keep the V4L2 pace even if the guest stalls: queue
+        // frames and let the VHAL always get the newest one.
+        video_sink->EnableAsyncSend(2, SendQueuePolicy::kLatestOnly);
+        // Encoded frames are then dropped GOP by GOP rather than one by one.
+        video_sink->SetFrameCodec((VideoSink::VideoCodecType)v4l2_format);
+        // The sender thread releases frames on 30 fps deadlines.
+        video_sink->SetFrameRate(30);
 
     } catch (const std::exception& ex) {
         cout << "VideoSink creation error :"
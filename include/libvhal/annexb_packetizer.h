@@ -0,0 +1,111 @@
+#ifndef ANNEXB_PACKETIZER_H
+#define ANNEXB_PACKETIZER_H
+/**
+ * @file annexb_packetizer.h
+ * @brief Splits an Annex-B H.264/H.265 byte stream into access units.
+ * @version 0.1
+ * @date 2021-08-24
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "video_sink.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Cuts an elementary stream, fed in pieces of any size, into whole
+ * access units (one picture with its parameter sets and SEI).
+ *
+ * Start codes are found with memchr(), which is vectorized in libc, so the
+ * scan costs a small fraction of a copy of the stream. Only NAL unit
+ * headers and the first bit of each slice header are decoded: an access
+ * unit ends before an AUD, parameter set, prefix SEI or the first slice of
+ * the next picture (ITU-T H.264 7.4.1.2.3, H.265 7.4.2.4.4).
+ *
+ * @code
+ * vhal::client::AnnexBPacketizer packetizer(VideoSink::VideoCodecType::kH264);
+ * while (auto n = read(fd, buf, sizeof(buf)); n > 0) {
+ *     packetizer.Push(buf, n, [&](const uint8_t* au, size_t size) {
+ *         video_sink->SendDataPacket(au, size);
+ *     });
+ * }
+ * packetizer.Flush(...);
+ * @endcode
+ *
+ * Not thread-safe.
+ */
+class AnnexBPacketizer
+{
+public:
+    /**
+     * @brief Receives one complete access unit. The pointer is valid for
+     * the duration of the call only.
+     */
+    using AccessUnitCallback =
+      std::function<void(const uint8_t* access_unit, size_t size)>;
+
+    /**
+     * @param codec kH264 or kH265. Throws std::invalid_argument otherwise.
+     */
+    explicit AnnexBPacketizer(VideoSink::VideoCodecType codec);
+    ~AnnexBPacketizer();
+
+    AnnexBPacketizer(const AnnexBPacketizer&) = delete;
+    AnnexBPacketizer& operator=(const AnnexBPacketizer&) = delete;
+
+    VideoSink::VideoCodecType Codec() const;
+
+    /**
+     * @brief Append data to the stream and hand out every access unit it
+     * completes. The last access unit stays buffered until the next one
+     * starts or Flush() is called.
+     *
+     * @return Number of access units emitted.
+     */
+    size_t Push(const uint8_t*            data,
+                size_t                    size,
+                const AccessUnitCallback& emit);
+
+    /**
+     * @brief End of stream: hand out the buffered access unit, if any, and
+     * start over.
+     *
+     * @return Number of access units emitted, 0 or 1.
+     */
+    size_t Flush(const AccessUnitCallback& emit);
+
+    /**
+     * @brief Discard buffered data, e.g. before seeking.
+     */
+    void Reset();
+
+    /**
+     * @brief Bytes buffered for the access unit in progress.
+     */
+    size_t Buffered() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* ANNEXB_PACKETIZER_H */
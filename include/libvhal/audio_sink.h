@@ -52,6 +52,19 @@ public:
      */
     AudioSink(TcpConnectionInfo tcp_conn_info);
 
+    /**
+     * @brief Construct a AudioSink on an already created socket client, e.g. a
+     *        LoopbackStreamSocketClient in tests and benchmarks. The
+     *        client is connected and reconnected by the AudioSink.
+     *        Throws std::invalid_argument excpetion.
+     *
+     * @param socket_client Transport to the VHAL, must not be null.
+     * @param event_loop Shared event loop, nullptr for a talker thread.
+     *
+     */
+    AudioSink(std::unique_ptr<IStreamSocketClient> socket_client,
+              std::shared_ptr<EventLoop>           event_loop = nullptr);
+
     /**
      * @brief Destroy the AudioSink object
      *
@@ -81,6 +94,27 @@ public:
      */
     IOResult SendDataPacket(const uint8_t* packet, size_t size);
 
+    /**
+     * @brief Sends raw pcm audio held in several buffers to VHAL with a
+     *        single syscall. Useful when the pcm data wraps around the end
+     *        of a ring buffer.
+     *
+     * @param iov Array of pcm buffers to be sent in order.
+     * @param iovcnt Number of entries in iov.
+     *
+     * @return IOResult tuple<ssize_t, std::string>.
+     *         ssize_t No of bytes sent and -1 incase of failure
+     *         string is the status message.
+     */
+    IOResult SendDataPacket(const struct iovec* iov, int iovcnt);
+
+    /**
+     * @brief Allocation-free variants of SendDataPacket(): return the number
+     *        of bytes sent, or -1 with ec set.
+     */
+    ssize_t SendDataPacket(const uint8_t* packet, size_t size, std::error_code& ec);
+    ssize_t SendDataPacket(const struct iovec* iov, int iovcnt, std::error_code& ec);
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
@@ -59,6 +59,19 @@ public:
      */
     AudioSource(TcpConnectionInfo tcp_conn_info);
 
+    /**
+     * @brief Construct a AudioSource on an already created socket client, e.g. a
+     *        LoopbackStreamSocketClient in tests and benchmarks. The
+     *        client is connected and reconnected by the AudioSource.
+     *        Throws std::invalid_argument excpetion.
+     *
+     * @param socket_client Transport to the VHAL, must not be null.
+     * @param event_loop Shared event loop, nullptr for a talker thread.
+     *
+     */
+    AudioSource(std::unique_ptr<IStreamSocketClient> socket_client,
+                std::shared_ptr<EventLoop>           event_loop = nullptr);
+
     /**
      * @brief Destroy the AudioSource object
      *
@@ -0,0 +1,81 @@
+/**
+ * @file event_loop.h
+ *
+ * @brief Shared epoll reactor for the VHAL client objects.
+ *
+ * @version 1.0
+ *
+ * @date 2021-08-11
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <memory>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief A fixed pool of epoll threads that serves the connections of any
+ * number of VideoSink, AudioSink, AudioSource, SensorInterface and
+ * VirtualGpsReceiver objects.
+ *
+ * By default every one of those objects runs its own talker thread. When a
+ * process hosts many Android instances, create one EventLoop and pass it in
+ * the connection info instead:
+ *
+ * @code
+ * auto loop = std::make_shared<vhal::client::EventLoop>(2);
+ * vhal::client::UnixConnectionInfo conn_info = { socket_dir, instance_id, loop };
+ * @endcode
+ *
+ * Each object is pinned to one of the loop threads, so its callbacks are
+ * never invoked concurrently. Callbacks run on the loop thread and should
+ * return quickly: a slow callback delays every object on that thread.
+ * Objects keep the loop alive; it stops once the last reference is gone, so
+ * the last object (or shared_ptr) must not be destroyed from a callback.
+ */
+class EventLoop
+{
+public:
+    /**
+     * @brief Start the loop threads.
+     *
+     * @param num_threads Number of epoll threads, at least one is started.
+     */
+    explicit EventLoop(unsigned int num_threads = 1);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Number of threads serving this loop.
+     */
+    unsigned int ThreadCount() const;
+
+    class Impl;
+
+private:
+    friend class VhalTalker;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace client
+} // namespace vhal
+
+#endif /* EVENT_LOOP_H */
@@ -0,0 +1,153 @@
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+/**
+ * @file frame_buffer.h
+ * @brief Owned frame memory that can be handed to the library.
+ * @version 0.1
+ * @date 2021-08-26
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Move-only handle to a frame's memory. Whoever holds it owns the
+ * memory; the release hook runs exactly once, when the last holder lets
+ * go. Handing a FrameBuffer to VideoSink::SendDataPacket() therefore lets
+ * the library keep the frame past the call, e.g. in the async send queue
+ * or until the kernel is done with a zero-copy send, without a copy.
+ *
+ * @code
+ * vhal::client::FrameBufferPool pool(width * height * 3 / 2, 4);
+ * while (streaming) {
+ *     auto frame = pool.Acquire();
+ *     if (!frame) {
+ *         continue; // every buffer is still queued or on the wire
+ *     }
+ *     Render(frame.Data());
+ *     video_sink->SendDataPacket(std::move(frame));
+ * }
+ * @endcode
+ */
+class FrameBuffer
+{
+public:
+    /**
+     * @brief Gives data back to its owner. It may run on any thread,
+     * including the library's sender and talker threads.
+     */
+    using ReleaseCallback = std::function<void(uint8_t* data)>;
+
+    FrameBuffer() = default;
+
+    /**
+     * @param data Frame memory.
+     * @param capacity Bytes at data; Size() starts out the same.
+     * @param release Called with data once the buffer is released, may be
+     *        null for memory that needs no release.
+     */
+    FrameBuffer(uint8_t* data, size_t capacity, ReleaseCallback release);
+
+    /**
+     * @brief Heap buffer of capacity bytes, freed on release.
+     */
+    static FrameBuffer Allocate(size_t capacity);
+
+    ~FrameBuffer();
+
+    FrameBuffer(FrameBuffer&& other) noexcept;
+    FrameBuffer& operator=(FrameBuffer&& other) noexcept;
+
+    FrameBuffer(const FrameBuffer&) = delete;
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+    uint8_t* Data() const { return data_; }
+
+    /**
+     * @brief Bytes of frame data, what the library sends.
+     */
+    size_t Size() const { return size_; }
+
+    size_t Capacity() const { return capacity_; }
+
+    /**
+     * @brief Set the frame size, e.g. after encoding into the buffer.
+     * Clamped to Capacity().
+     */
+    void SetSize(size_t size);
+
+    /**
+     * @brief Release the memory now; the handle becomes empty.
+     */
+    void Reset();
+
+    explicit operator bool() const { return data_ != nullptr; }
+
+private:
+    uint8_t*        data_     = nullptr;
+    size_t          size_     = 0;
+    size_t          capacity_ = 0;
+    ReleaseCallback release_;
+};
+
+/**
+ * @brief Fixed set of equally sized buffers, allocated once. A released
+ * FrameBuffer goes back to the pool instead of the heap, so a capture loop
+ * allocates nothing per frame. Buffers may outlive the pool; the memory is
+ * freed once the pool and every buffer are gone.
+ *
+ * Thread-safe.
+ */
+class FrameBufferPool
+{
+public:
+    /**
+     * @param buffer_size Capacity of each buffer.
+     * @param count Number of buffers.
+     */
+    FrameBufferPool(size_t buffer_size, size_t count);
+    ~FrameBufferPool();
+
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+    /**
+     * @brief Take a free buffer, Size() == buffer_size.
+     *
+     * @return An empty FrameBuffer if all buffers are in use.
+     */
+    FrameBuffer Acquire();
+
+    /**
+     * @brief Buffers free right now.
+     */
+    size_t Available() const;
+
+    size_t BufferSize() const;
+
+private:
+    class Impl;
+    // Shared with the buffers handed out, see FrameBufferPool::Impl.
+    Impl* impl_;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* FRAME_BUFFER_H */
@@ -0,0 +1,120 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+/**
+ * @file frame_pacer.h
+ * @brief Deadline-based frame pacing for camera producers.
+ * @version 0.1
+ * @date 2021-08-18
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Releases one frame per 1/fps on absolute CLOCK_MONOTONIC
+ * deadlines.
+ *
+ * Deadline n is start + n / fps, computed from the frame count rather than
+ * by adding up sleeps, so time spent reading, converting or sending a frame
+ * never accumulates into drift. The wait is a
+ * clock_nanosleep(TIMER_ABSTIME), which also survives EINTR without losing
+ * time.
+ *
+ * A caller that misses a whole frame period does not get a burst of
+ * catch-up frames: the missed deadlines are skipped and WaitNextFrame()
+ * says so, so the caller can drop the stale frame.
+ *
+ * @code
+ * vhal::client::FramePacer pacer(30);
+ * while (streaming) {
+ *     auto frame = Capture();
+ *     if (pacer.WaitNextFrame()) {
+ *         video_sink->SendDataPacket(frame.data(), frame.size());
+ *     }
+ * }
+ * @endcode
+ *
+ * WaitNextFrame() is meant for one producer thread; the other methods may
+ * be called from any thread.
+ */
+class FramePacer
+{
+public:
+    /**
+     * @brief Jitter is how far the actual release of a frame was from its
+     * deadline.
+     */
+    struct Stats
+    {
+        // Frames released by WaitNextFrame().
+        uint64_t frames = 0;
+        // Deadlines skipped because the caller was late.
+        uint64_t skipped = 0;
+        std::chrono::nanoseconds last_jitter = {};
+        std::chrono::nanoseconds max_jitter  = {};
+        std::chrono::nanoseconds mean_jitter = {};
+    };
+
+    /**
+     * @param fps Frames per second, 0 disables pacing: WaitNextFrame()
+     *            returns true right away.
+     */
+    explicit FramePacer(uint32_t fps = 30);
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    /**
+     * @brief Change the rate, e.g. once the camera is opened. The schedule
+     * restarts with the next frame.
+     */
+    void SetFrameRate(uint32_t fps);
+
+    uint32_t GetFrameRate() const;
+
+    /**
+     * @brief Sleep until the deadline of the next frame. The first call
+     * after construction, SetFrameRate() or Reset() starts the schedule and
+     * returns immediately.
+     *
+     * @return true The frame is on time (or early), send it.
+     * @return false The caller missed at least one whole frame period. The
+     *         missed deadlines were skipped; dropping the frame at hand
+     *         keeps latency down.
+     */
+    bool WaitNextFrame();
+
+    /**
+     * @brief Start a new schedule with the next frame, e.g. after the
+     * stream was paused.
+     */
+    void Reset();
+
+    Stats GetStats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* FRAME_PACER_H */
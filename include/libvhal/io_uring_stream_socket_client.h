@@ -0,0 +1,123 @@
+/**
+ * @file io_uring_stream_socket_client.h
+ *
+ * @brief Stream socket client that performs its I/O through io_uring.
+ *
+ * @version 1.0
+ *
+ * @date 2021-08-04
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef IO_URING_STREAM_SOCKET_CLIENT_H
+#define IO_URING_STREAM_SOCKET_CLIENT_H
+
+#include "istream_socket_client.h"
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief IStreamSocketClient backed by io_uring. Only available when the
+ * library is configured with -DENABLE_IO_URING=ON (requires liburing).
+ *
+ * Vectored sends are queued as one linked SQE per buffer and submitted with
+ * a single io_uring_enter(). Buffers handed to RegisterBuffers() are pinned
+ * once and then sent/received with the *_FIXED opcodes, which saves the
+ * per-call page pinning of regular socket I/O for large camera frames.
+ */
+class IoUringStreamSocketClient final : public IStreamSocketClient
+{
+public:
+    /**
+     * @brief Unix domain socket endpoint.
+     */
+    IoUringStreamSocketClient(const std::string&   remote_server_path,
+                              const SocketOptions& options = {});
+
+    /**
+     * @brief TCP endpoint.
+     */
+    IoUringStreamSocketClient(const std::string&   remote_server_ip,
+                              const int            port,
+                              const SocketOptions& options = {});
+
+    /**
+     * @brief vSock endpoint.
+     */
+    IoUringStreamSocketClient(const int            android_vm_cid,
+                              const unsigned int   port,
+                              const SocketOptions& options = {});
+
+    ~IoUringStreamSocketClient();
+
+    ConnectionResult Connect() override;
+    bool             Connected() const override;
+    int              GetNativeSocketFd() const override;
+    IOResult         Send(const uint8_t* data, size_t size) override;
+    IOResult         SendV(const struct iovec* iov, int iovcnt) override;
+    IOResult         SendAll(const uint8_t* data,
+                             size_t         size,
+                             int            timeout_ms = -1) override;
+    IOResult         SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms = -1) override;
+    IOResult         Recv(uint8_t* data, size_t size, int flag = 0) override;
+    ssize_t          Send(const uint8_t*   data,
+                          size_t           size,
+                          std::error_code& ec) override;
+    ssize_t          SendV(const struct iovec* iov,
+                           int                 iovcnt,
+                           std::error_code&    ec) override;
+    ssize_t          SendAll(const uint8_t*   data,
+                             size_t           size,
+                             int              timeout_ms,
+                             std::error_code& ec) override;
+    ssize_t          SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms,
+                             std::error_code&    ec) override;
+    ssize_t          Recv(uint8_t*         data,
+                          size_t           size,
+                          int              flag,
+                          std::error_code& ec) override;
+    void             Close() override;
+
+    /**
+     * @brief Register long-lived buffers (e.g. a frame pool) with the ring.
+     * Any later Send/Recv whose data lies entirely inside one of them uses
+     * IORING_OP_WRITE_FIXED/READ_FIXED. Replaces previously registered
+     * buffers. The memory must stay valid until the next call or until the
+     * client is destroyed.
+     *
+     * @param bufs Buffers to register.
+     * @param nr Number of entries in bufs, 0 unregisters all.
+     * @return IOResult
+     *         <Number of buffers registered, Empty string> on Success
+     *         <-1, Error message> on Failure
+     */
+    IOResult RegisterBuffers(const struct iovec* bufs, unsigned int nr);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+} // namespace client
+} // namespace vhal
+
+#endif /* IO_URING_STREAM_SOCKET_CLIENT_H */
@@ -28,7 +28,9 @@
 
 #include "libvhal_common.h"
 #include <cstdint>
+#include <system_error>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <tuple>
 
 namespace vhal {
@@ -91,6 +93,54 @@ public:
      */
     virtual IOResult Send(const uint8_t* data, size_t size) = 0;
 
+    /**
+     * @brief Send scattered buffers to server with a single syscall
+     *        (sendmsg), e.g. a packet header and its payload without copying
+     *        them into one contiguous buffer first.
+     *
+     * @param iov Array of buffers to be sent in order.
+     * @param iovcnt Number of entries in iov.
+     * @return IOResult
+     *         <Number of bytes sent, Empty string> on Success
+     *         <Error number, Error message on Failure> on Failure
+     */
+    virtual IOResult SendV(const struct iovec* iov, int iovcnt) = 0;
+
+    /**
+     * @brief Send all of data to server. Unlike Send(), short writes, EINTR
+     *        and EAGAIN are retried until every byte is written, so a large
+     *        frame can never be cut in the middle of the stream framing.
+     *
+     * @param data
+     * @param size
+     * @param timeout_ms -1 (default) blocks until all data is written.
+     *                   >= 0 is a deadline for the whole call. The socket is
+     *                   then written non-blocking and poll() waits for it to
+     *                   become writable within the remaining time.
+     * @return IOResult
+     *         <Number of bytes sent (== size), Empty string> on Success
+     *         <-1, Error message> on Failure. If the deadline expired after
+     *         part of the data was sent, the stream is out of sync and the
+     *         connection should be re-established.
+     */
+    virtual IOResult SendAll(const uint8_t* data,
+                             size_t         size,
+                             int            timeout_ms = -1) = 0;
+
+    /**
+     * @brief Vectored variant of SendAll(), see SendV().
+     *
+     * @param iov Array of buffers to be sent in order.
+     * @param iovcnt Number of entries in iov.
+     * @param timeout_ms Same as SendAll(const uint8_t*, size_t, int).
+     * @return IOResult
+     *         <Number of bytes sent, Empty string> on Success
+     *         <-1, Error message> on Failure
+     */
+    virtual IOResult SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms = -1) = 0;
+
     /**
      * @brief
      *
@@ -99,17 +149,76 @@ public:
      * @param flag - default value is 0 which is equivalent to read
      *               please refer to recv flags and how to use them
      *               https://man7.org/linux/man-pages/man2/recv.2.html
+     *               Passed through unchanged, so MSG_WAITALL and
+     *               MSG_DONTWAIT work on every transport.
      *
      * @return IOResult
      *         <Number of bytes received, Empty string> on Success
      *         <Error number, Error message on Failure> on Failure
      */
-    virtual IOResult Recv(uint8_t* data, size_t size, uint8_t flag = 0) = 0;
+    virtual IOResult Recv(uint8_t* data, size_t size, int flag = 0) = 0;
+
+    /**
+     * @brief Allocation-free variants of Send(), SendV(), SendAll() and
+     * Recv() for per-packet paths. Instead of an error string they return -1
+     * (or, for a TCP Recv(), the bytes received so far) and set ec; no
+     * message is formatted unless the caller asks ec.message() for it.
+     *
+     * The library's clients implement these directly. The defaults forward
+     * to the IOResult overloads so that other implementations keep working;
+     * their errors are reported as std::errc::io_error.
+     */
+    virtual ssize_t Send(const uint8_t* data, size_t size, std::error_code& ec)
+    {
+        return FromIOResult(Send(data, size), ec);
+    }
+
+    virtual ssize_t SendV(const struct iovec* iov,
+                          int                 iovcnt,
+                          std::error_code&    ec)
+    {
+        return FromIOResult(SendV(iov, iovcnt), ec);
+    }
+
+    virtual ssize_t SendAll(const uint8_t*   data,
+                            size_t           size,
+                            int              timeout_ms,
+                            std::error_code& ec)
+    {
+        return FromIOResult(SendAll(data, size, timeout_ms), ec);
+    }
+
+    virtual ssize_t SendAll(const struct iovec* iov,
+                            int                 iovcnt,
+                            int                 timeout_ms,
+                            std::error_code&    ec)
+    {
+        return FromIOResult(SendAll(iov, iovcnt, timeout_ms), ec);
+    }
+
+    virtual ssize_t Recv(uint8_t*         data,
+                         size_t           size,
+                         int              flag,
+                         std::error_code& ec)
+    {
+        return FromIOResult(Recv(data, size, flag), ec);
+    }
 
     /**
      * @brief Closes socket connection.
      */
     virtual void Close() = 0;
+
+private:
+    static ssize_t FromIOResult(const IOResult& result, std::error_code& ec)
+    {
+        if (std::get<1>(result).empty()) {
+            ec.clear();
+        } else {
+            ec = std::make_error_code(std::errc::io_error);
+        }
+        return std::get<0>(result);
+    }
 };
 } // namespace client
 } // namespace vhal
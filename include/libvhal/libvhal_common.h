@@ -17,11 +17,62 @@
  *
  */
 
+#include <memory>
 #include <string>
 
 namespace vhal {
 namespace client {
 
+class EventLoop;
+
+/**
+ * @brief Optional tuning applied to every socket a client creates, before it
+ * connects. Defaults leave the kernel settings alone. Options that do not
+ * apply to the transport (TCP_* on Unix/vsock) are ignored; options the
+ * kernel rejects (e.g. SO_PRIORITY > 6 without CAP_NET_ADMIN) are logged and
+ * do not fail the connect.
+ *
+ * Typical settings: small buffers and tcp_nodelay for sensor/input traffic,
+ * a send buffer of a few frames for camera streaming.
+ */
+struct SocketOptions
+{
+    // SO_SNDBUF / SO_RCVBUF in bytes, 0 keeps the default. The kernel
+    // doubles the value and caps it at net.core.[wr]mem_max.
+    int send_buffer_size = 0;
+    int recv_buffer_size = 0;
+    // TCP_NODELAY: disable Nagle's algorithm.
+    bool tcp_nodelay = false;
+    // TCP_QUICKACK: ack immediately. The kernel clears it again on its own,
+    // so it is re-armed after every receive.
+    bool tcp_quickack = false;
+    // SO_PRIORITY, -1 keeps the default.
+    int priority = -1;
+    // SO_BUSY_POLL in microseconds, 0 keeps the default.
+    int busy_poll_us = 0;
+    // Default deadline for SendAll() when the caller passes none, and
+    // SO_SNDTIMEO for plain Send()/SendV(). -1: block.
+    int send_timeout_ms = -1;
+};
+
+/**
+ * @brief What a full asynchronous send queue does with another frame, see
+ * VideoSink::EnableAsyncSend().
+ */
+enum class SendQueuePolicy
+{
+    // Wait for the sender thread to make room, like a synchronous send with
+    // some slack.
+    kBlock,
+    // Discard the oldest queued frame.
+    kDropOldest,
+    // Discard the new frame.
+    kDropNewest,
+    // Discard every queued frame on each new one, so at most the newest
+    // frame waits behind the one being sent.
+    kLatestOnly,
+};
+
 /**
  * @brief TCP connection info to the Android instance
  *
@@ -36,6 +87,11 @@ struct TcpConnectionInfo
      * default.
      */
     uint16_t port = 0;
+    // Shared event loop to serve this connection on, see event_loop.h.
+    // nullptr: the object runs its own talker thread.
+    std::shared_ptr<EventLoop> event_loop = nullptr;
+    // Tuning for the socket(s) of this connection.
+    SocketOptions socket_options = {};
 };
 
 /**
@@ -49,6 +105,16 @@ struct UnixConnectionInfo
     // specifies the Instance/Session id of the Android instance, if valid.
     // In K8S-like environments(1 instance per pod), this can be omitted.
     int android_instance_id = -1;
+    // Shared event loop to serve this connection on, see event_loop.h.
+    // nullptr: the object runs its own talker thread.
+    std::shared_ptr<EventLoop> event_loop = nullptr;
+    // Tuning for the socket(s) of this connection.
+    SocketOptions socket_options = {};
+    // Connect with SOCK_SEQPACKET instead of SOCK_STREAM, so every packet
+    // travels as one message (see unix_seqpacket_socket_client.h). The VHAL
+    // must listen on a SOCK_SEQPACKET socket. Used by VideoSink and
+    // SensorInterface, ignored by the other objects.
+    bool seqpacket = false;
 };
 
 /**
@@ -59,6 +125,11 @@ struct VsockConnectionInfo
 {
     // Specifies the Context identifier of the Android VM instance.
     int android_vm_cid = -1;
+    // Shared event loop to serve this connection on, see event_loop.h.
+    // nullptr: the object runs its own talker thread.
+    std::shared_ptr<EventLoop> event_loop = nullptr;
+    // Tuning for the socket(s) of this connection.
+    SocketOptions socket_options = {};
 };
 
 /**
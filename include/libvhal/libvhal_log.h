@@ -0,0 +1,110 @@
+#ifndef LIBVHAL_LOG_H
+#define LIBVHAL_LOG_H
+/**
+ * @file libvhal_log.h
+ * @brief Where the library's log messages go, and how many of them.
+ * @version 0.1
+ * @date 2021-09-01
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace vhal {
+namespace client {
+
+enum class LogLevel : int
+{
+    kDebug   = 0,
+    kInfo    = 1,
+    kWarning = 2,
+    kError   = 3,
+    // SetLevel(kNone) turns logging off.
+    kNone = 4,
+};
+
+/**
+ * @brief One message, as handed to the LogSink.
+ */
+struct LogRecord
+{
+    LogLevel                              level = LogLevel::kInfo;
+    std::chrono::system_clock::time_point time;
+    // Kernel thread id of the caller.
+    int32_t     thread_id = 0;
+    const char* function  = "";
+    int         line      = 0;
+    std::string message;
+    // Messages of the same call site dropped by the rate limit since the
+    // previous one that got through.
+    uint64_t suppressed = 0;
+};
+
+/**
+ * @brief Receives every message that passes the level and the rate limit,
+ * always on the logger's own thread, one at a time.
+ */
+using LogSink = std::function<void(const LogRecord& record)>;
+
+/**
+ * @brief Process-wide settings of the library's logger.
+ *
+ * Logging costs the calling thread a level check, formatting the message
+ * and a lock-free push into an in-memory ring; a background thread drains
+ * the ring into the sink, so a slow terminal never holds up a send.
+ * Messages below the level, over the per-call-site rate limit, or that find
+ * the ring full are dropped. Calls below LIBVHAL_LOG_MIN_LEVEL, a build
+ * option, are compiled out.
+ *
+ * Thread-safe.
+ */
+class Log
+{
+public:
+    /**
+     * @brief Lowest level that is logged, kInfo by default.
+     */
+    static void     SetLevel(LogLevel level);
+    static LogLevel GetLevel();
+
+    /**
+     * @brief Messages per second any one call site may log, 20 by
+     * default; 0 for no limit.
+     */
+    static void SetRateLimit(uint32_t per_second);
+
+    /**
+     * @brief Replace the sink. nullptr restores the default one, which
+     * writes to stdout (logcat on Android).
+     */
+    static void SetSink(LogSink sink);
+
+    /**
+     * @brief Wait until every message logged so far reached the sink.
+     */
+    static void Flush();
+
+    /**
+     * @brief Messages lost because the ring was full.
+     */
+    static uint64_t Dropped();
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* LIBVHAL_LOG_H */
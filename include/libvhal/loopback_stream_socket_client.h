@@ -0,0 +1,94 @@
+/**
+ * @file loopback_stream_socket_client.h
+ * @brief In-process IStreamSocketClient for tests and benchmarks.
+ * @version 0.1
+ * @date 2021-08-13
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef LOOPBACK_STREAM_SOCKET_CLIENT_H
+#define LOOPBACK_STREAM_SOCKET_CLIENT_H
+
+#include "istream_socket_client.h"
+#include <functional>
+#include <memory>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Stream client whose remote end lives in the same process.
+ *
+ * Every Connect() creates a fresh AF_UNIX socketpair and hands the peer end
+ * to the PeerCallback, which plays the VHAL: it owns the fd from then on
+ * and reads/writes it like the Android side would. Combined with the
+ * injectable constructors of VideoSink, SensorInterface, AudioSink and
+ * AudioSource this measures the library without a running Android VM.
+ *
+ * The callback runs on whichever thread calls Connect(), i.e. the talker
+ * or event loop thread of the owning object.
+ */
+class LoopbackStreamSocketClient final : public IStreamSocketClient
+{
+public:
+    /**
+     * @param peer_fd Peer end of the new connection, owned by the callee.
+     */
+    using PeerCallback = std::function<void(int peer_fd)>;
+
+    LoopbackStreamSocketClient(PeerCallback         on_connect,
+                               const SocketOptions& options = {});
+    ~LoopbackStreamSocketClient();
+
+    ConnectionResult Connect() override;
+    bool             Connected() const override;
+    int              GetNativeSocketFd() const override;
+    IOResult         Send(const uint8_t* data, size_t size) override;
+    IOResult         SendV(const struct iovec* iov, int iovcnt) override;
+    IOResult         SendAll(const uint8_t* data,
+                             size_t         size,
+                             int            timeout_ms = -1) override;
+    IOResult         SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms = -1) override;
+    IOResult         Recv(uint8_t* data, size_t size, int flag = 0) override;
+    ssize_t          Send(const uint8_t*   data,
+                          size_t           size,
+                          std::error_code& ec) override;
+    ssize_t          SendV(const struct iovec* iov,
+                           int                 iovcnt,
+                           std::error_code&    ec) override;
+    ssize_t          SendAll(const uint8_t*   data,
+                             size_t           size,
+                             int              timeout_ms,
+                             std::error_code& ec) override;
+    ssize_t          SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms,
+                             std::error_code&    ec) override;
+    ssize_t          Recv(uint8_t*         data,
+                          size_t           size,
+                          int              flag,
+                          std::error_code& ec) override;
+    void             Close() override;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+} // namespace client
+} // namespace vhal
+
+#endif /* LOOPBACK_STREAM_SOCKET_CLIENT_H */
@@ -155,6 +155,19 @@ public:
      */
     SensorInterface(UnixConnectionInfo unix_conn_info);
 
+    /**
+     * @brief Construct a SensorInterface on an already created socket client, e.g. a
+     *        LoopbackStreamSocketClient in tests and benchmarks. The
+     *        client is connected and reconnected by the SensorInterface.
+     *        Throws std::invalid_argument excpetion.
+     *
+     * @param socket_client Transport to the VHAL, must not be null.
+     * @param event_loop Shared event loop, nullptr for a talker thread.
+     *
+     */
+    SensorInterface(std::unique_ptr<IStreamSocketClient> socket_client,
+                    std::shared_ptr<EventLoop>           event_loop = nullptr);
+
     /**
      * @brief Destroy the SensorInterface object
      *
@@ -183,6 +196,13 @@ public:
      */
     IOResult SendDataPacket(const SensorDataPacket *event);
 
+    /**
+     * @brief Allocation-free variant of SendDataPacket(): returns the number
+     *        of bytes sent, or -1 with ec set. 0 with
+     *        std::errc::not_connected while the VHAL is not connected.
+     */
+    ssize_t SendDataPacket(const SensorDataPacket* event, std::error_code& ec);
+
     /**
      * @brief Get supported sensor list in bitmap format.
      *        Supported sensor's bit gets set using respective
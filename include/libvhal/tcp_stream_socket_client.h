@@ -24,6 +24,7 @@
 #define TCP_STREAM_SOCKET_CLIENT_H
 
 #include "istream_socket_client.h"
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -34,16 +35,92 @@ namespace client {
 class TcpStreamSocketClient final : public IStreamSocketClient
 {
 public:
-    TcpStreamSocketClient(const std::string& remote_server_ip, const int port);
+    TcpStreamSocketClient(const std::string&   remote_server_ip,
+                          const int            port,
+                          const SocketOptions& options = {});
     ~TcpStreamSocketClient();
 
     ConnectionResult Connect() override;
     bool             Connected() const override;
     int              GetNativeSocketFd() const override;
     IOResult         Send(const uint8_t* data, size_t size) override;
-    IOResult         Recv(uint8_t* data, size_t size, uint8_t flag = 0) override;
+    IOResult         SendV(const struct iovec* iov, int iovcnt) override;
+    IOResult         SendAll(const uint8_t* data,
+                             size_t         size,
+                             int            timeout_ms = -1) override;
+    IOResult         SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms = -1) override;
+    IOResult         Recv(uint8_t* data, size_t size, int flag = 0) override;
+    ssize_t          Send(const uint8_t*   data,
+                          size_t           size,
+                          std::error_code& ec) override;
+    ssize_t          SendV(const struct iovec* iov,
+                           int                 iovcnt,
+                           std::error_code&    ec) override;
+    ssize_t          SendAll(const uint8_t*   data,
+                             size_t           size,
+                             int              timeout_ms,
+                             std::error_code& ec) override;
+    ssize_t          SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms,
+                             std::error_code&    ec) override;
+    ssize_t          Recv(uint8_t*         data,
+                          size_t           size,
+                          int              flag,
+                          std::error_code& ec) override;
     void             Close() override;
 
+    /**
+     * @brief Request MSG_ZEROCOPY transmission for SendAllZeroCopy(). The
+     *        request sticks across reconnects; SO_ZEROCOPY is applied to the
+     *        current socket and to every socket created by Connect().
+     *
+     * @return true if the current socket accepted SO_ZEROCOPY, or no socket
+     *         exists yet.
+     * @return false Kernel does not support zero-copy on this socket.
+     */
+    bool EnableZeroCopy();
+
+    /**
+     * @brief Whether the current connection sends with MSG_ZEROCOPY.
+     */
+    bool ZeroCopyEnabled() const;
+
+    /**
+     * @brief Completion id the kernel will assign to the next successful
+     *        zero-copy sendmsg() on the current connection. Ids restart at 0
+     *        on every Connect().
+     */
+    uint32_t NextZeroCopyId() const;
+
+    /**
+     * @brief Like SendAll(), but the kernel transmits straight from the
+     *        caller's pages. The buffers must not be modified or freed until
+     *        ReadZeroCopyCompletions() reported every id this call consumed,
+     *        i.e. [NextZeroCopyId() before the call, NextZeroCopyId() after
+     *        the call). Falls back to a copying SendAll() when zero-copy is
+     *        not enabled.
+     */
+    IOResult SendAllZeroCopy(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms = -1);
+    ssize_t  SendAllZeroCopy(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms,
+                             std::error_code&    ec);
+
+    /**
+     * @brief Drain zero-copy completion notifications from the socket error
+     *        queue. Never blocks.
+     *
+     * @param on_complete Called with each completed, inclusive id range.
+     * @return Number of notifications read, -1 on error.
+     */
+    int ReadZeroCopyCompletions(
+      const std::function<void(uint32_t lo, uint32_t hi)>& on_complete);
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
@@ -0,0 +1,106 @@
+/**
+ * @file unix_seqpacket_socket_client.h
+ *
+ * @brief
+ *
+ * @version 1.0
+ *
+ * @date 2021-08-16
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef UNIX_SEQPACKET_SOCKET_CLIENT_H
+#define UNIX_SEQPACKET_SOCKET_CLIENT_H
+
+#include "istream_socket_client.h"
+#include <memory>
+#include <string>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Unix domain client on a SOCK_SEQPACKET socket.
+ *
+ * Connection-oriented like UnixStreamSocketClient, but the kernel keeps
+ * message boundaries: every Send()/SendV()/SendAll() call is delivered as
+ * one message, and one Recv() returns at most one message. A packet header
+ * and its payload handed over in one SendAll(iov) therefore always arrive
+ * together and a short read can never desync the framing.
+ *
+ * Each message must fit the socket send buffer; larger ones fail with
+ * EMSGSIZE (see SocketOptions::send_buffer_size). A Recv() buffer smaller
+ * than the message fails with std::errc::message_size and the message is
+ * dropped.
+ *
+ * The VHAL must listen on a SOCK_SEQPACKET socket.
+ */
+class UnixSeqpacketSocketClient final : public IStreamSocketClient
+{
+public:
+    UnixSeqpacketSocketClient(const std::string&   remote_server_path,
+                              const SocketOptions& options = {});
+    ~UnixSeqpacketSocketClient();
+
+    ConnectionResult Connect() override;
+    bool             Connected() const override;
+    int              GetNativeSocketFd() const override;
+    IOResult         Send(const uint8_t* data, size_t size) override;
+    IOResult         SendV(const struct iovec* iov, int iovcnt) override;
+    IOResult         SendAll(const uint8_t* data,
+                             size_t         size,
+                             int            timeout_ms = -1) override;
+    IOResult         SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms = -1) override;
+    IOResult         Recv(uint8_t* data, size_t size, int flag = 0) override;
+    ssize_t          Send(const uint8_t*   data,
+                          size_t           size,
+                          std::error_code& ec) override;
+    ssize_t          SendV(const struct iovec* iov,
+                           int                 iovcnt,
+                           std::error_code&    ec) override;
+    ssize_t          SendAll(const uint8_t*   data,
+                             size_t           size,
+                             int              timeout_ms,
+                             std::error_code& ec) override;
+    ssize_t          SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms,
+                             std::error_code&    ec) override;
+    ssize_t          Recv(uint8_t*         data,
+                          size_t           size,
+                          int              flag,
+                          std::error_code& ec) override;
+    void             Close() override;
+
+    /**
+     * @brief Send iov as one message and pass fd to the peer with
+     * SCM_RIGHTS.
+     *
+     * @return IOResult
+     *         <Number of bytes sent, Empty string> on Success
+     *         <-1, Error message> on Failure
+     */
+    IOResult SendFd(const struct iovec* iov, int iovcnt, int fd);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+} // namespace client
+} // namespace vhal
+
+#endif /* UNIX_SEQPACKET_SOCKET_CLIENT_H */
@@ -37,16 +37,51 @@ namespace client {
 class UnixStreamSocketClient final : public IStreamSocketClient
 {
 public:
-    UnixStreamSocketClient(const std::string& remote_server_path);
+    UnixStreamSocketClient(const std::string&   remote_server_path,
+                           const SocketOptions& options = {});
     ~UnixStreamSocketClient();
 
     ConnectionResult Connect() override;
     bool             Connected() const override;
     int              GetNativeSocketFd() const override;
     IOResult         Send(const uint8_t* data, size_t size) override;
-    IOResult         Recv(uint8_t* data, size_t size, uint8_t flag = 0) override;
+    IOResult         SendV(const struct iovec* iov, int iovcnt) override;
+    IOResult         SendAll(const uint8_t* data,
+                             size_t         size,
+                             int            timeout_ms = -1) override;
+    IOResult         SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms = -1) override;
+    IOResult         Recv(uint8_t* data, size_t size, int flag = 0) override;
+    ssize_t          Send(const uint8_t*   data,
+                          size_t           size,
+                          std::error_code& ec) override;
+    ssize_t          SendV(const struct iovec* iov,
+                           int                 iovcnt,
+                           std::error_code&    ec) override;
+    ssize_t          SendAll(const uint8_t*   data,
+                             size_t           size,
+                             int              timeout_ms,
+                             std::error_code& ec) override;
+    ssize_t          SendAll(const struct iovec* iov,
+                             int                 iovcnt,
+                             int                 timeout_ms,
+                             std::error_code&    ec) override;
+    ssize_t          Recv(uint8_t*         data,
+                          size_t           size,
+                          int              flag,
+                          std::error_code& ec) override;
     void             Close() override;
 
+    /**
+     * @brief Write iov in full and pass fd to the peer with SCM_RIGHTS.
+     *
+     * @return IOResult
+     *         <Number of bytes sent, Empty string> on Success
+     *         <-1, Error message> on Failure
+     */
+    IOResult SendFd(const struct iovec* iov, int iovcnt, int fd);
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
@@ -21,13 +21,18 @@
  * limitations under the License.
  *
  */
+#include "frame_buffer.h"
+#include "frame_pacer.h"
 #include "istream_socket_client.h"
 #include "libvhal_common.h"
+#include <chrono>
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <sys/types.h>
 #include <tuple>
+#include <vector>
 
 namespace vhal {
 namespace client {
@@ -62,6 +67,10 @@ public:
         CAMERA_DATA = 3,
         ACK = 4,
         CAMERA_INFO = 5,
+        CAMERA_SHM_RING = 6, // camera_shm_ring_info_t + memfd (SCM_RIGHTS)
+        CAMERA_SHM_DATA = 7, // camera_shm_slot_desc_t
+        CAMERA_STREAM_DATA = 8, // camera_stream_chunk_t + chunk bytes
+        CAMERA_DATA_EXT = 9, // camera_frame_metadata_t + frame bytes
     };
 
     /**
@@ -123,7 +132,8 @@ public:
         VideoCodecType codec_type = VideoCodecType::kH264;
         FrameResolution resolution = FrameResolution::k480p;
         uint32_t maxNumberOfCameras;
-        uint32_t reserved[5];
+        uint32_t features = 0; // CameraFeature bits the VHAL supports
+        uint32_t reserved[4];
     };
 
     /**
@@ -136,7 +146,48 @@ public:
         FrameResolution resolution;
         SensorOrientation sensorOrientation;
         CameraFacing facing;  // '0' for back camera and '1' for front camera
-        uint32_t reserved[3];
+        uint32_t features;    // CameraFeature bits the client wants to use
+        uint32_t reserved[2];
+    };
+
+    /**
+     * @brief Optional protocol features, negotiated through
+     * camera_capability_t::features and camera_info_t::features. A feature
+     * is in use once the VHAL advertised it and acknowledged camera info
+     * asking for it; the old reserved fields are zero, so a VHAL or client
+     * that knows nothing about features never gets one.
+     */
+    enum CameraFeature : uint32_t {
+        // CAMERA_DATA_EXT instead of CAMERA_DATA, see
+        // camera_frame_metadata_t.
+        kFeatureFrameMetadata = 0x01,
+    };
+
+    /**
+     * @brief Flags of camera_frame_metadata_t.
+     */
+    enum FrameFlags : uint32_t {
+        // Decoding can start at this frame (IDR/IRAP).
+        kFrameKeyframe = 0x01,
+        // Frames before this one were lost: first frame on a connection,
+        // or earlier frames were dropped or failed to send.
+        kFrameDiscontinuity = 0x02,
+    };
+
+    /**
+     * @brief Payload header of CAMERA_DATA_EXT: the frame follows, its
+     * length is camera_header_t::size - sizeof(camera_frame_metadata_t).
+     * Timestamps are CLOCK_MONOTONIC nanoseconds of the host, the clock of
+     * V4L2 buffer timestamps; send - capture is the time the frame spent
+     * in the host, the VHAL can compare consecutive capture timestamps
+     * against its own clock to spot frames that arrive late.
+     */
+    struct camera_frame_metadata_t {
+        uint64_t capture_timestamp_ns;
+        uint64_t send_timestamp_ns;  // stamped right before the write
+        uint64_t sequence;           // +1 per submitted frame, never reused
+        uint32_t flags;              // FrameFlags
+        uint32_t reserved;
     };
 
     /**
@@ -150,6 +201,105 @@ public:
         uint32_t reserved[5];
     };
 
+    /**
+     * @brief Shared-memory frame ring layout, see EnableSharedMemoryRing().
+     *
+     * The memfd passed with CAMERA_SHM_RING starts with this struct, followed
+     * by slot_count uint32_t slot states (camera_shm_slot_state_t). Slot i
+     * starts at data_offset + i * slot_stride and holds up to slot_size
+     * bytes. Slot states are accessed with atomic load/store by both sides.
+     */
+    struct camera_shm_ring_info_t {
+        uint32_t magic;       // kShmRingMagic
+        uint32_t version;     // kShmRingVersion
+        uint32_t slot_count;
+        uint32_t slot_size;
+        uint32_t slot_stride;
+        uint32_t data_offset;
+        uint32_t reserved[2];
+    };
+
+    static constexpr uint32_t kShmRingMagic   = 0x52534856; // "VHSR"
+    static constexpr uint32_t kShmRingVersion = 1;
+
+    /**
+     * @brief Ownership of a shared-memory slot. Client moves FREE ->
+     * WRITING -> READY and sends a camera_shm_slot_desc_t; VHAL sets the
+     * slot back to FREE once it has consumed the frame.
+     */
+    enum camera_shm_slot_state_t : uint32_t {
+        SHM_SLOT_FREE = 0,
+        SHM_SLOT_WRITING = 1,
+        SHM_SLOT_READY = 2,
+    };
+
+    /**
+     * @brief Payload of CAMERA_SHM_DATA, a frame is ready in slot.
+     */
+    struct camera_shm_slot_desc_t {
+        uint32_t slot;
+        uint32_t size;
+    };
+
+    /**
+     * @brief Payload header of CAMERA_STREAM_DATA, see OpenCameraStream().
+     * Frames of a CameraStream are cut into chunks so that the frames of
+     * several cameras interleave on the socket; the chunk length is
+     * camera_header_t::size - sizeof(camera_stream_chunk_t). Chunks of one
+     * camera arrive in order, a frame is complete once
+     * offset + chunk length == frame_size. A new connection discards any
+     * partial frame.
+     */
+    struct camera_stream_chunk_t {
+        uint32_t cameraId;
+        uint32_t frame_size;
+        uint32_t offset;
+        uint32_t reserved;
+    };
+
+    static constexpr size_t kStreamChunkSize = 64 * 1024;
+
+    /**
+     * @brief Memory layout of a frame passed to SendRawFrame(). The bytes
+     * go out as they are, so the VHAL has to expect the same layout;
+     * camera_info_t can only announce kI420.
+     */
+    enum class PixelFormat : uint32_t {
+        kI420, // Y, U and V planes
+        kNV12, // Y plane, interleaved UV plane
+        kNV21, // Y plane, interleaved VU plane
+    };
+
+    /**
+     * @brief One plane of a RawFrame: rows are stride bytes apart, which
+     * may be more than the row holds, e.g. for padded decoder output.
+     */
+    struct RawFramePlane {
+        const uint8_t* data = nullptr;
+        size_t stride = 0;
+    };
+
+    /**
+     * @brief 4:2:0 frame as planes, see SendRawFrame(). Only planes[0]
+     * and planes[1] are used for kNV12/kNV21.
+     */
+    struct RawFrame {
+        PixelFormat format = PixelFormat::kI420;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        RawFramePlane planes[3] = {};
+    };
+
+    /**
+     * @brief Writable shared-memory slot handed out by
+     * AcquireSharedFrameSlot().
+     */
+    struct SharedFrameSlot {
+        uint32_t index = 0;
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+    };
+
     /**
      * @brief encapsulated structure to exchange both data and control
      *
@@ -197,6 +347,128 @@ public:
      */
     using CameraCallback = std::function<void(const camera_config_cmd_t& ctrl_msg)>;
 
+    /**
+     * @brief Type of the callback through which SendDataPacketZeroCopy()
+     * hands a packet buffer back once the library and the kernel no longer
+     * reference it. It may run on the caller's thread or on the library's
+     * talker thread.
+     *
+     */
+    using PacketReleaseCallback = std::function<void(const uint8_t* packet)>;
+
+    /**
+     * @brief Completion of RequestCameraCapability(): the capability, or
+     * nullptr if the request failed, timed out or the connection was reset.
+     *
+     */
+    using CapabilityCallback =
+      std::function<void(std::shared_ptr<camera_capability_t> capability)>;
+
+    /**
+     * @brief Completion of SendCameraInfo(): true if the Camera VHAL
+     * acknowledged the camera info with ACK_CONFIG.
+     *
+     */
+    using AckCallback = std::function<void(bool acked)>;
+
+    /**
+     * @brief Deadline of the blocking capability calls.
+     *
+     */
+    static constexpr std::chrono::milliseconds kNegotiationTimeout{ 5000 };
+
+    /**
+     * @brief Outcome of replaying the negotiation on a new connection, see
+     * EnableSessionResume().
+     */
+    struct ResumeEvent
+    {
+        // The VHAL acknowledged the replayed camera info.
+        bool acked = false;
+        // What the new VHAL answered the capability request with, nullptr
+        // if it didn't.
+        std::shared_ptr<camera_capability_t> capability;
+        // A camera was open (CMD_OPEN without a CMD_CLOSE) when the
+        // connection dropped, and the config it was opened with.
+        bool            camera_open   = false;
+        camera_config_t camera_config = {};
+    };
+
+    using ResumeCallback = std::function<void(const ResumeEvent& event)>;
+
+    /**
+     * @brief Distribution of a latency. Percentiles come from a
+     * log-linear histogram and are at most 12.5% high.
+     */
+    struct LatencySummary
+    {
+        uint64_t                 count = 0;
+        std::chrono::nanoseconds p50   = {};
+        std::chrono::nanoseconds p99   = {};
+        std::chrono::nanoseconds max   = {};
+        std::chrono::nanoseconds mean  = {};
+    };
+
+    /**
+     * @brief Snapshot returned by GetStats(). Frames are those sent with
+     * SendDataPacket(), SendDataPacketZeroCopy() and
+     * CommitSharedFrameSlot(); CameraStream traffic only counts towards
+     * send_blocked.
+     */
+    struct Stats
+    {
+        // Data packets written to the socket and their payload bytes.
+        uint64_t frames_sent = 0;
+        uint64_t bytes_sent  = 0;
+        // Data packets whose write failed and reset the connection.
+        uint64_t send_errors = 0;
+        // See GetDroppedFrameCount().
+        uint64_t frames_dropped = 0;
+        // Frames waiting in the async send queue right now.
+        size_t queue_depth = 0;
+        // Connections made after the first one.
+        uint64_t reconnects = 0;
+        // Time to write one data packet, waiting for other writers
+        // included. Pacing and queueing are not part of it.
+        LatencySummary send_latency;
+        // Total time spent in socket writes, data and control messages.
+        // Much of it next to little traffic points at a guest that does
+        // not read.
+        std::chrono::nanoseconds send_blocked = {};
+        // RequestCameraCapability() to its answer, answered requests only.
+        LatencySummary capability_rtt;
+    };
+
+    /**
+     * @brief Send backlog over one interval, passed to the
+     * CongestionCallback, see EnableCongestionMonitor().
+     */
+    struct CongestionReport
+    {
+        // Bytes written but not read by the VHAL yet (SIOCOUTQ), 0 where
+        // the transport can't tell.
+        size_t socket_backlog = 0;
+        // Time spent in socket writes during the interval.
+        std::chrono::nanoseconds send_blocked = {};
+        // Async send queue fill; both 0 without EnableAsyncSend().
+        size_t queue_depth    = 0;
+        size_t queue_capacity = 0;
+        // Data packet payload written during the interval.
+        uint64_t throughput_bps = 0;
+        // Whether any of the above says frames are backing up.
+        bool congested = false;
+        // What the encoder should aim for: below the measured throughput
+        // while congested, raised step by step once it clears. 0 until
+        // something has been sent.
+        uint64_t target_bitrate_bps = 0;
+        // The frame rate (see SetFrameRate(), else the highest measured)
+        // scaled like the bitrate, 0 if unknown.
+        uint32_t target_frame_rate = 0;
+    };
+
+    using CongestionCallback =
+      std::function<void(const CongestionReport& report)>;
+
     /**
      * @brief Construct a default VideoSink object from the Android instance id.
      *        Throws std::invalid_argument excpetion.
@@ -218,6 +490,32 @@ public:
 
     VideoSink(VsockConnectionInfo vsock_conn_info, CameraCallback callback);
 
+    /**
+     * @brief Construct a default VideoSink object from the Android instance
+     *        ip address. Port 0 selects the default camera port (1982).
+     *        Throws std::invalid_argument excpetion.
+     *
+     * @param tcp_conn_info Information needed to connect to the tcp vhal socket.
+     *
+     */
+    VideoSink(TcpConnectionInfo tcp_conn_info, CameraCallback callback);
+
+    /**
+     * @brief Construct a VideoSink on an already created socket client, e.g. a
+     *        LoopbackStreamSocketClient in tests and benchmarks. The
+     *        client is connected and reconnected by the VideoSink.
+     *        Throws std::invalid_argument excpetion.
+     *
+     * @param socket_client Transport to the VHAL, must not be null.
+     * @param callback Camera callback function object or lambda or function
+     * pointer.
+     * @param event_loop Shared event loop, nullptr for a talker thread.
+     *
+     */
+    VideoSink(std::unique_ptr<IStreamSocketClient> socket_client,
+              CameraCallback                       callback,
+              std::shared_ptr<EventLoop>           event_loop = nullptr);
+
     /**
      * @brief Destroy the VideoSink object
      *
@@ -236,10 +534,11 @@ public:
      * @brief Send an encoded Camera packet to VHAL.
      *
      * This function sends data packet with the header containing size of the data
-     * packet. It's call is equivalent to the following 2 calls of SendRawPacket:
+     * packet. Header and packet are written with a single vectored send, which
+     * is equivalent to the following 2 calls of SendRawPacket:
      *
      * \code
-     * SendRawPacket((uint8_t*)&size, sizeof(size));
+     * SendRawPacket((uint8_t*)&header, sizeof(header));
      * SendRawPacket(packet, size);
      * \endcode
      *
@@ -250,9 +549,93 @@ public:
      * @return IOResult tuple<ssize_t, std::string>.
      *         ssize_t No of bytes sent and -1 incase of failure
      *         string is the status message.
+     *         In async mode the bytes queued, 0 if the frame was dropped.
      */
     IOResult SendDataPacket(const uint8_t* packet, size_t size);
 
+    /**
+     * @brief Allocation-free variant of SendDataPacket() for the per-frame
+     *        path: returns the payload bytes sent, or -1 with ec set.
+     *        std::errc::no_buffer_space means the shared-memory ring had no
+     *        free slot; any other error has reset the connection.
+     *        In async mode (see EnableAsyncSend()) the bytes queued, or 0
+     *        with std::errc::no_buffer_space when the frame was dropped.
+     */
+    ssize_t SendDataPacket(const uint8_t* packet, size_t size, std::error_code& ec);
+
+    /**
+     * @brief SendDataPacket() with the frame's capture time. Once
+     *        kFeatureFrameMetadata is negotiated every data packet goes
+     *        out as CAMERA_DATA_EXT with a camera_frame_metadata_t;
+     *        the other overloads stamp the time of the call as capture
+     *        time. Sequence numbers are taken here, so frames the async
+     *        queue drops show up as gaps. kFrameKeyframe is set for
+     *        keyframes of the SetFrameCodec() codec, kFrameDiscontinuity
+     *        after a gap or a reconnect. Without the feature the metadata
+     *        is not sent, and neither is it for shared-memory frames.
+     *
+     * @param capture_timestamp_ns CLOCK_MONOTONIC time of capture, e.g.
+     *        the V4L2 buffer timestamp.
+     * @param flags FrameFlags to add to the ones set by the library.
+     */
+    IOResult SendDataPacket(const uint8_t* packet,
+                            size_t         size,
+                            uint64_t       capture_timestamp_ns,
+                            uint32_t       flags = 0);
+
+    /**
+     * @brief SendDataPacket() that takes ownership of the frame instead of
+     *        copying it. In async mode the buffer itself is queued; it is
+     *        released once it has been written or dropped, on the sender
+     *        thread. Otherwise it is released before the call returns.
+     *
+     * @param frame Frame.Size() bytes are sent.
+     *
+     * @return IOResult as for SendDataPacket(const uint8_t*, size_t).
+     */
+    IOResult SendDataPacket(FrameBuffer frame);
+
+    /**
+     * @brief SendDataPacket(FrameBuffer) with the frame's capture time, see
+     *        kFeatureFrameMetadata.
+     */
+    IOResult SendDataPacket(FrameBuffer frame,
+                            uint64_t    capture_timestamp_ns,
+                            uint32_t    flags = 0);
+
+    /**
+     * @brief Whether data packets carry camera_frame_metadata_t on the
+     *        current connection, see kFeatureFrameMetadata.
+     */
+    bool IsFrameMetadataEnabled() const;
+
+    /**
+     * @brief Send an Annex-B H.264/H.265 elementary stream read in pieces
+     *        of any size, e.g. from a file. The bytes are cut into whole
+     *        access units (see AnnexBPacketizer) and every complete one
+     *        goes out through SendDataPacket(), so the VHAL gets exactly
+     *        one picture per packet. The codec is the one set with
+     *        SetFrameCodec().
+     *
+     * @param data Next piece of the stream.
+     * @param size Size of data.
+     *
+     * @return IOResult tuple<ssize_t, std::string>.
+     *         ssize_t size once the piece is taken, -1 if the codec is not
+     *         kH264/kH265 or sending an access unit failed.
+     *         string is the status message.
+     */
+    IOResult SendAccessUnits(const uint8_t* data, size_t size);
+
+    /**
+     * @brief End of stream for SendAccessUnits(): send the last buffered
+     *        access unit.
+     *
+     * @return IOResult tuple<ssize_t, std::string>.
+     *         ssize_t Bytes sent, 0 if nothing was buffered, -1 on failure.
+     */
+    IOResult FlushAccessUnits();
+
     /**
      * @brief Send an raw Camera packet to VHAL for cases like I420
      *        where data is fixed always. when using this api both
@@ -268,10 +651,209 @@ public:
      */
     IOResult SendRawPacket(const uint8_t* packet, size_t size);
 
+    /**
+     * @brief Send a raw frame straight from its planes: header and rows go
+     *        out in one vectored write, without packing the planes into a
+     *        contiguous buffer first. On the wire it is a data packet of
+     *        width * height * 3 / 2 bytes, tightly packed, like a
+     *        SendDataPacket() of the packed frame.
+     *
+     *        Once the VHAL has opened the camera (or acknowledged camera
+     *        info) the frame has to match that FrameResolution. The frame
+     *        is written on the caller's thread, also in async mode, and is
+     *        not paced. With the shared-memory ring the rows are copied
+     *        into a slot; on a seqpacket socket a frame with more rows than
+     *        IOV_MAX is packed first.
+     *
+     * @param frame Planes and geometry; width and height must be even.
+     *
+     * @return IOResult tuple<ssize_t, std::string>.
+     *         ssize_t Payload bytes sent and -1 incase of failure
+     *         string is the status message.
+     */
+    IOResult SendRawFrame(const RawFrame& frame);
+
+    /**
+     * @brief SendRawFrame() with the frame's capture time, see
+     *        kFeatureFrameMetadata.
+     */
+    IOResult SendRawFrame(const RawFrame& frame,
+                          uint64_t        capture_timestamp_ns,
+                          uint32_t        flags = 0);
+
+    /**
+     * @brief Send an encoded or raw Camera packet without copying it into
+     *        the kernel (MSG_ZEROCOPY). Wire format is the same as
+     *        SendDataPacket().
+     *
+     * The packet buffer must stay valid and unmodified until release(packet)
+     * is called. Only the TCP transport supports zero-copy; on other
+     * transports, or when the kernel refuses SO_ZEROCOPY, the packet is
+     * copied and release is called before this function returns. Zero-copy
+     * pays off for large frames (e.g. kI420 at 1080p), not for small
+     * encoded packets.
+     *
+     * @param packet Camera packet.
+     * @param size Size of the Camera packet.
+     * @param release Called exactly once when the buffer may be reused.
+     *
+     * @return IOResult tuple<ssize_t, std::string>.
+     *         ssize_t No of bytes sent and -1 incase of failure
+     *         string is the status message.
+     */
+    IOResult SendDataPacketZeroCopy(const uint8_t*        packet,
+                                    size_t                size,
+                                    PacketReleaseCallback release);
+
+    /**
+     * @brief SendDataPacketZeroCopy() of a FrameBuffer: the buffer is
+     *        released when the kernel is done with it. On transports
+     *        without zero-copy this is SendDataPacket(FrameBuffer).
+     */
+    IOResult SendDataPacketZeroCopy(FrameBuffer frame);
+
+    /**
+     * @brief Bound the time SendDataPacket()/SendRawPacket() may block on a
+     *        stalled Camera VHAL. Packets are always written completely or
+     *        not at all from the caller's point of view; when the timeout
+     *        expires mid-packet the connection is reset and re-established so
+     *        the stream framing stays intact.
+     *
+     * @param timeout_ms Timeout per packet in milliseconds, -1 (default)
+     *                   blocks until the packet is written.
+     */
+    void SetSendTimeout(int timeout_ms);
+
+    /**
+     * @brief Decouple SendDataPacket() from the socket: frames are copied
+     *        into a queue of depth entries and written by a sender thread,
+     *        so a stalled Camera VHAL no longer stalls the capture loop.
+     *        What happens when the queue is full is up to policy; with
+     *        SendQueuePolicy::kLatestOnly the VHAL always gets the newest
+     *        frame next. Call once, before streaming starts.
+     *
+     *        Only SendDataPacket() is queued; SendRawPacket(),
+     *        SendDataPacketZeroCopy() and the shared-memory slot calls keep
+     *        writing directly.
+     *
+     * @param depth Max number of queued frames.
+     * @param policy See SendQueuePolicy.
+     *
+     * @return true Sender thread started.
+     * @return false Async mode already enabled or depth is 0.
+     */
+    bool EnableAsyncSend(size_t depth, SendQueuePolicy policy);
+
+    /**
+     * @brief Frames SendDataPacket() accepted in async mode that never
+     *        reached the Camera VHAL: dropped by the queue policy or failed
+     *        to send.
+     */
+    uint64_t GetDroppedFrameCount() const;
+
+    /**
+     * @brief Counters and latencies since construction. Collecting them
+     *        costs a few relaxed atomic adds per packet; taking the
+     *        snapshot does not stop senders.
+     */
+    Stats GetStats() const;
+
+    /**
+     * @brief Watch the send backlog and report it every interval, so an
+     *        encoder can lower its bitrate or frame rate before frames back
+     *        up instead of finding out from a blocking SendDataPacket().
+     *        The backlog is sampled from the socket (SIOCOUTQ), the time
+     *        spent blocked in writes and the async queue depth.
+     *
+     * @param interval Time between reports.
+     * @param max_bitrate_bps Highest target to suggest, e.g. the encoder's
+     *        configured bitrate. 0: the highest throughput seen so far.
+     * @param callback Called with every report, on a thread of its own.
+     *
+     * @return true Monitor started.
+     * @return false Already running, interval is not positive or callback
+     *         is null.
+     */
+    bool EnableCongestionMonitor(std::chrono::milliseconds interval,
+                                 uint64_t                  max_bitrate_bps,
+                                 CongestionCallback        callback);
+
+    /**
+     * @brief Tell the async queue what SendDataPacket() frames are. With
+     *        kH264 or kH265 (Annex-B, one access unit per call) a full
+     *        queue drops whole non-reference frames first, then everything
+     *        up to the next IDR/IRAP, and never sends a frame whose
+     *        reference was dropped. Other codecs are dropped by the plain
+     *        queue policy.
+     *
+     * @param codec Codec of the frames, as announced in camera_info_t.
+     */
+    void SetFrameCodec(VideoCodecType codec);
+
+    /**
+     * @brief Pace SendDataPacket() to fps frames per second: each frame
+     *        leaves on its own CLOCK_MONOTONIC deadline (see FramePacer),
+     *        on the caller's thread or, in async mode, on the sender
+     *        thread. A frame that missed its deadline is sent right away
+     *        and the schedule skips ahead; encoded frames are never dropped
+     *        here because the decoder needs every one of them.
+     *
+     * @param fps Frames per second, 0 (default) sends as fast as called.
+     */
+    void SetFrameRate(uint32_t fps);
+
+    /**
+     * @brief Frames paced, deadlines skipped and jitter since
+     *        SetFrameRate() was first called.
+     */
+    FramePacer::Stats GetPacingStats() const;
+
+    /**
+     * @brief Switch frame transport to a shared-memory ring (Unix transport
+     *        only). A memfd holding slot_count slots is created and passed to
+     *        the Camera VHAL with SCM_RIGHTS on every (re)connect. From then
+     *        on only a camera_shm_slot_desc_t travels on the socket per frame.
+     *        SendDataPacket() copies into a free slot; use
+     *        AcquireSharedFrameSlot()/CommitSharedFrameSlot() to render into
+     *        the slot directly and avoid any copy.
+     *
+     * @param slot_count Number of frame slots.
+     * @param slot_size Max frame size in bytes.
+     *
+     * @return true Ring created.
+     * @return false Transport is not Unix, ring already enabled or memfd
+     *         could not be created.
+     */
+    bool EnableSharedMemoryRing(uint32_t slot_count, size_t slot_size);
+
+    /**
+     * @brief Claim a free slot of the shared-memory ring.
+     *
+     * @param slot Filled with the slot index, address and capacity.
+     *
+     * @return true Slot claimed, it must be handed back with
+     *         CommitSharedFrameSlot().
+     * @return false Ring not enabled or all slots are in use by the VHAL.
+     */
+    bool AcquireSharedFrameSlot(SharedFrameSlot& slot);
+
+    /**
+     * @brief Publish a frame written into slot to the Camera VHAL.
+     *
+     * @param slot Slot returned by AcquireSharedFrameSlot().
+     * @param size Frame size, 0 returns the slot without sending anything.
+     *
+     * @return IOResult tuple<ssize_t, std::string>.
+     *         ssize_t Frame size and -1 incase of failure
+     *         string is the status message.
+     */
+    IOResult CommitSharedFrameSlot(const SharedFrameSlot& slot, size_t size);
+
     /**
      * @brief GetCameraCapabilty
      *        api is called to get vhal capability
      *        client should call this api after successful connection 
+     *        Blocks for at most kNegotiationTimeout.
      *
      * @return camera_capability_t which provides vhal capabilites
      * @return NULL on failure
@@ -281,26 +863,175 @@ public:
     /**
      * @brief SetCameraCapability() API is called to set client
      *        requested capability to camera vHAL
+     *        Blocks for at most kNegotiationTimeout.
      *
      * @param camera_info_t
      *
-     * @return true libvhal able to send camera info
-     * @return false libvhal failed to send camera info
+     * @return true camera vHAL acknowledged the camera info
+     * @return false libvhal failed to send camera info, or it was refused
+     *         or not acknowledged in time
      */
     bool SetCameraCapabilty(std::vector<camera_info_t> camera_info);
 
     /**
      * @brief ResetCameraCapability() API is called to Reset client
      *        requested capability to camera vHAL
+     *        Waits until the library has (re)connected to camera vHAL
+     *        since the previous call returned; the first call returns as
+     *        soon as there is a connection. A reconnect that happens
+     *        before the call is not missed.
      *
      *
      * @return NULL
      */
     void ResetCameraCapabilty();
+
+    /**
+     * @brief Same as ResetCameraCapabilty() with a deadline.
+     *
+     * @return false no new connection within timeout
+     */
+    bool WaitForReconnect(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Ask camera vHAL for its capability without blocking.
+     *        Requests are answered in order; one that gets no reply
+     *        within timeout, or whose connection is reset, completes with
+     *        nullptr. done runs on a library thread, or on the caller's
+     *        thread if the request cannot be sent; it must not wait for
+     *        another capability request.
+     *
+     * @param timeout Deadline counted from this call.
+     * @param done Completion callback.
+     */
+    void RequestCameraCapability(std::chrono::milliseconds timeout,
+                                 CapabilityCallback        done);
+
+    /**
+     * @brief Future flavour of RequestCameraCapability().
+     */
+    std::future<std::shared_ptr<camera_capability_t>> RequestCameraCapability(
+      std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Send camera info without blocking; see
+     *        RequestCameraCapability() for ordering, deadline and threads.
+     *
+     * @param camera_info One entry per camera.
+     * @param timeout Deadline counted from this call.
+     * @param done Completion callback, true on ACK_CONFIG.
+     */
+    void SendCameraInfo(std::vector<camera_info_t>  camera_info,
+                        std::chrono::milliseconds   timeout,
+                        AckCallback                 done);
+
+    /**
+     * @brief Future flavour of SendCameraInfo().
+     */
+    std::future<bool> SendCameraInfo(std::vector<camera_info_t> camera_info,
+                                     std::chrono::milliseconds  timeout);
+
+    /**
+     * @brief Last capability camera vHAL sent on any connection, so that a
+     *        client can renegotiate after a reconnect without waiting for
+     *        a round trip.
+     *
+     * @return The capability, nullptr if none was received yet.
+     */
+    std::shared_ptr<camera_capability_t> GetCachedCameraCapability() const;
+
+    /**
+     * @brief Renegotiate by itself after every reconnect. The library
+     *        remembers the last camera info the VHAL acknowledged and, on
+     *        a new connection, requests the capability and sends that info
+     *        again right away, instead of the application looping on
+     *        ResetCameraCapabilty(), GetCameraCapabilty() and
+     *        SetCameraCapabilty(). The open state is carried over too:
+     *        if a camera was open when the connection dropped, SendRawFrame()
+     *        keeps checking against its resolution.
+     *
+     *        Nothing is replayed until camera info has been acknowledged
+     *        once.
+     *
+     * @param callback Called once per reconnect with the outcome, on a
+     *        library thread; it must not wait for a capability request.
+     */
+    void EnableSessionResume(ResumeCallback callback);
+
+    class CameraStream;
+
+    /**
+     * @brief Open a data channel for one of the cameras announced with
+     *        SetCameraCapabilty(). Each stream has its own frame queue,
+     *        sender thread and pacing; frames of all streams share the
+     *        socket in chunks of at most kStreamChunkSize bytes, taken in
+     *        turns, so a large frame of one camera never holds up the
+     *        others for longer than one chunk.
+     *
+     * @param camera_id cameraId of the camera_info_t / camera_config_t.
+     * @param depth Max number of queued frames of this stream.
+     * @param policy What a full queue does, see SendQueuePolicy.
+     *
+     * @return The stream; it must be destroyed before the VideoSink.
+     *         nullptr if a stream for camera_id is open already.
+     */
+    std::unique_ptr<CameraStream> OpenCameraStream(
+      uint32_t        camera_id,
+      size_t          depth  = 2,
+      SendQueuePolicy policy = SendQueuePolicy::kLatestOnly);
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
 };
+
+/**
+ * @brief Per-camera data channel of a VideoSink, see
+ * VideoSink::OpenCameraStream().
+ */
+class VideoSink::CameraStream
+{
+public:
+    ~CameraStream();
+
+    uint32_t CameraId() const;
+
+    /**
+     * @brief Queue an encoded or raw frame of this camera. The frame is
+     *        copied; the stream's sender thread writes it as
+     *        CAMERA_STREAM_DATA chunks.
+     *
+     * @return IOResult tuple<ssize_t, std::string>.
+     *         ssize_t Bytes queued, 0 if the frame was dropped by the queue
+     *         policy. string is the status message.
+     */
+    IOResult SendDataPacket(const uint8_t* packet, size_t size);
+
+    /**
+     * @brief Pace this stream to fps frames per second, 0 (default) sends
+     *        as fast as frames come in. See VideoSink::SetFrameRate().
+     */
+    void SetFrameRate(uint32_t fps);
+
+    /**
+     * @brief Codec of this stream's frames, see VideoSink::SetFrameCodec().
+     */
+    void SetFrameCodec(VideoCodecType codec);
+
+    /**
+     * @brief Frames dropped by the queue policy or failed to send.
+     */
+    uint64_t GetDroppedFrameCount() const;
+
+    FramePacer::Stats GetPacingStats() const;
+
+    class Impl;
+
+private:
+    friend class VideoSink;
+    explicit CameraStream(std::unique_ptr<Impl> impl);
+    std::unique_ptr<Impl> impl_;
+};
 } // namespace client
 } // namespace vhal
 #endif /* VIDEO_SINK_H */
@@ -10,6 +10,8 @@
 namespace vhal {
 namespace client {
 
+class VhalTalker;
+
 enum
 {
     GPS_CMD_QUIT  = 0, // GPS quit
@@ -92,7 +94,7 @@ public:
 
 private:
     IOResult Read(uint8_t* buf, size_t len);
-    void     workThreadProc();
+    bool     OnSocketEvent(short revents);
 
 public:
     enum Command
@@ -113,9 +115,9 @@ private:
     int                          mSockGps       = -1;
     static const char*           kGpsSock;
     volatile Command             mCommand;
-    std::unique_ptr<std::thread> mWorkThread;
     std::mutex                   mMutex;
     bool                         mStop = false;
+    std::unique_ptr<VhalTalker>  mTalker;
 };
 
 } // namespace client
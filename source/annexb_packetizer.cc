@@ -0,0 +1,66 @@
+/**
+ * @file annexb_packetizer.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-24
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "annexb_packetizer.h"
+#include "annexb_packetizer_impl.h"
+
+namespace vhal {
+namespace client {
+
+AnnexBPacketizer::AnnexBPacketizer(VideoSink::VideoCodecType codec)
+  : impl_{ std::make_unique<Impl>(codec) }
+{}
+
+AnnexBPacketizer::~AnnexBPacketizer() = default;
+
+VideoSink::VideoCodecType
+AnnexBPacketizer::Codec() const
+{
+    return impl_->Codec();
+}
+
+size_t
+AnnexBPacketizer::Push(const uint8_t*            data,
+                       size_t                    size,
+                       const AccessUnitCallback& emit)
+{
+    return impl_->Push(data, size, emit);
+}
+
+size_t
+AnnexBPacketizer::Flush(const AccessUnitCallback& emit)
+{
+    return impl_->Flush(emit);
+}
+
+void
+AnnexBPacketizer::Reset()
+{
+    impl_->Reset();
+}
+
+size_t
+AnnexBPacketizer::Buffered() const
+{
+    return impl_->Buffered();
+}
+
+} // namespace client
+} // namespace vhal
@@ -0,0 +1,165 @@
+#ifndef ANNEXB_PACKETIZER_IMPL_H
+#define ANNEXB_PACKETIZER_IMPL_H
+/**
+ * @file annexb_packetizer_impl.h
+ * @brief
+ * @version 0.1
+ * @date 2021-08-24
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "annexb_packetizer.h"
+#include "nal_classifier.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace vhal {
+namespace client {
+
+class AnnexBPacketizer::Impl
+{
+public:
+    explicit Impl(VideoSink::VideoCodecType codec) : codec_{ codec }
+    {
+        if (codec != VideoSink::VideoCodecType::kH264 &&
+            codec != VideoSink::VideoCodecType::kH265) {
+            throw std::invalid_argument("Annex-B needs kH264 or kH265");
+        }
+    }
+
+    VideoSink::VideoCodecType Codec() const { return codec_; }
+
+    size_t Push(const uint8_t*            data,
+                size_t                    size,
+                const AccessUnitCallback& emit)
+    {
+        buffer_.insert(buffer_.end(), data, data + size);
+
+        const uint8_t* base     = buffer_.data();
+        const uint8_t* end      = base + buffer_.size();
+        const uint8_t* au_start = base;
+        const uint8_t* p        = base + scan_;
+        // NAL header plus the first byte of a slice header.
+        const ptrdiff_t header  = codec_ == VideoSink::kH264 ? 2 : 3;
+        size_t          emitted = 0;
+        for (;;) {
+            const uint8_t* nal = NextAnnexBNalUnit(p, end);
+            if (nal == end) {
+                // A start code may straddle the next Push(), or end with
+                // the last byte we have.
+                p = std::max(p, end - std::min<ptrdiff_t>(end - base, 3));
+                break;
+            }
+            if (end - nal < header) {
+                // Find this start code again once its header is in.
+                p = nal - 3;
+                break;
+            }
+
+            bool vcl    = false;
+            bool new_au = StartsAccessUnit(nal, vcl);
+            if (new_au && au_has_vcl_) {
+                const uint8_t* au_end = nal - 3;
+                // The zero of a 4-byte start code belongs to the next unit.
+                if (au_end > au_start && au_end[-1] == 0) {
+                    au_end--;
+                }
+                emit(au_start, size_t(au_end - au_start));
+                emitted++;
+                au_start    = au_end;
+                au_has_vcl_ = false;
+            }
+            au_has_vcl_ |= vcl;
+            p = nal;
+        }
+
+        scan_ = size_t(p - au_start);
+        buffer_.erase(buffer_.begin(), buffer_.begin() + (au_start - base));
+        return emitted;
+    }
+
+    size_t Flush(const AccessUnitCallback& emit)
+    {
+        size_t emitted = 0;
+        if (au_has_vcl_) {
+            emit(buffer_.data(), buffer_.size());
+            emitted++;
+        }
+        Reset();
+        return emitted;
+    }
+
+    void Reset()
+    {
+        buffer_.clear();
+        scan_       = 0;
+        au_has_vcl_ = false;
+    }
+
+    size_t Buffered() const { return buffer_.size(); }
+
+private:
+    // Whether the NAL unit whose header is at nal may open an access unit;
+    // vcl is set for slices.
+    bool StartsAccessUnit(const uint8_t* nal, bool& vcl) const
+    {
+        if (codec_ == VideoSink::kH264) {
+            uint8_t type = nal[0] & 0x1f;
+            switch (type) {
+                case 1: // non-IDR slice
+                case 2: // slice data partition A
+                case 5: // IDR slice
+                    vcl = true;
+                    // first_mb_in_slice is ue(v): a leading 1 bit means 0.
+                    return nal[1] & 0x80;
+                case 3: // partitions B and C never start a picture
+                case 4:
+                    vcl = true;
+                    return false;
+                case 6: // SEI
+                case 7: // SPS
+                case 8: // PPS
+                case 9: // AUD
+                    return true;
+                default:
+                    return type >= 14 && type <= 18;
+            }
+        }
+
+        uint8_t type = (nal[0] >> 1) & 0x3f;
+        if (type <= 31) {
+            vcl = true;
+            // first_slice_segment_in_pic_flag.
+            return nal[2] & 0x80;
+        }
+        // VPS, SPS, PPS, AUD, prefix SEI and the reserved prefix types.
+        return (type >= 32 && type <= 35) || type == 39 ||
+               (type >= 41 && type <= 44) || (type >= 48 && type <= 55);
+    }
+
+    const VideoSink::VideoCodecType codec_;
+
+    // Access unit in progress plus bytes not scanned yet.
+    std::vector<uint8_t> buffer_;
+    // Where the next start code search begins, relative to buffer_.
+    size_t scan_       = 0;
+    bool   au_has_vcl_ = false;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* ANNEXB_PACKETIZER_IMPL_H */
@@ -22,6 +22,7 @@
  */
 #include "audio_sink.h"
 #include "audio_sink_impl.h"
+#include "socket_io.h"
 #include "tcp_stream_socket_client.h"
 #include <functional>
 #include <memory>
@@ -37,8 +38,19 @@ AudioSink::AudioSink(TcpConnectionInfo tcp_conn_info)
 {
     auto tcp_sock_client =
       std::make_unique<TcpStreamSocketClient>(tcp_conn_info.ip_addr,
-      LIBVHAL_AUDIO_RECORD_PORT);
-    impl_ = std::make_unique<Impl>(std::move(tcp_sock_client));
+      LIBVHAL_AUDIO_RECORD_PORT, tcp_conn_info.socket_options);
+    impl_ = std::make_unique<Impl>(std::move(tcp_sock_client),
+                                   tcp_conn_info.event_loop);
+}
+
+AudioSink::AudioSink(std::unique_ptr<IStreamSocketClient> socket_client,
+                      std::shared_ptr<EventLoop>           event_loop)
+{
+    if (!socket_client) {
+        throw std::invalid_argument("Please set a valid socket_client");
+    }
+    impl_ = std::make_unique<Impl>(std::move(socket_client),
+                                   std::move(event_loop));
 }
 
 AudioSink::~AudioSink() {}
@@ -50,7 +62,30 @@ bool AudioSink::RegisterCallback(AudioCallback callback)
 
 IOResult AudioSink::SendDataPacket(const uint8_t* packet, size_t size)
 {
-    return impl_->SendDataPacket(packet, size);
+    std::error_code ec;
+    ssize_t         sent = impl_->SendDataPacket(packet, size, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t AudioSink::SendDataPacket(const uint8_t*   packet,
+                                  size_t           size,
+                                  std::error_code& ec)
+{
+    return impl_->SendDataPacket(packet, size, ec);
+}
+
+IOResult AudioSink::SendDataPacket(const struct iovec* iov, int iovcnt)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendDataPacket(iov, iovcnt, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t AudioSink::SendDataPacket(const struct iovec* iov,
+                                  int                 iovcnt,
+                                  std::error_code&    ec)
+{
+    return impl_->SendDataPacket(iov, iovcnt, ec);
 }
 
 } // namespace audio
@@ -24,12 +24,14 @@
  *
  */
 
+#include "framed_reader.h"
 #include "istream_socket_client.h"
+#include "vhal_log.h"
+#include "vhal_talker.h"
 #include "audio_sink.h"
 #include <atomic>
 #include <chrono>
 #include <functional>
-#include <iostream>
 #include <memory>
 #include <string>
 #include <system_error>
@@ -52,74 +54,18 @@ namespace audio {
 class AudioSink::Impl
 {
 public:
-    Impl(unique_ptr<IStreamSocketClient> socket_client)
-      : socket_client_{ move(socket_client) }
+    Impl(unique_ptr<IStreamSocketClient> socket_client,
+         std::shared_ptr<EventLoop>      event_loop = nullptr)
+      : socket_client_{ move(socket_client) },
+        reader_{ *socket_client_ },
+        talker_{ TalkerOps(), move(event_loop) }
     {
-        vhal_talker_thread_ = thread([this]() {
-            while (should_continue_) {
-                if (not socket_client_->Connected()) {
-                    auto [connected, error_msg] = socket_client_->Connect();
-                    if (!connected) {
-                        cout << "AudioSink Failed to connect to VHal: "
-                             << error_msg
-                             << ". Retry after 3ms...\n";
-                        this_thread::sleep_for(3ms);
-                        continue;
-                    }
-                }
-                // connected ...
-                cout << "Connected to Audio VHal (sink)!\n";
-
-                struct pollfd fds[1];
-                const int     timeout_ms = 1 * 1000; // 1 sec timeout
-                int           ret;
-
-                // watch socket for input
-                fds[0].fd     = socket_client_->GetNativeSocketFd();
-                fds[0].events = POLLIN;
-
-                do {
-                    ret = poll(fds, std::size(fds), timeout_ms);
-                    if (ret == -1) {
-                        throw system_error(errno, system_category());
-                    }
-                    if (!ret) {
-                        continue;
-                    }
-                    if (fds[0].revents & POLLIN) {
-                        CtrlMessage ctrl_msg;
-                        auto [received, recv_err_msg] =
-                            socket_client_->Recv(
-                            reinterpret_cast<uint8_t*>(&ctrl_msg),
-                            sizeof(ctrl_msg));
-                        if (received != sizeof(CtrlMessage)) {
-                            cout << "Failed to read message from AudioSink: "
-                                 << recv_err_msg
-                                 << ", going to disconnect and reconnect.\n";
-                            socket_client_->Close();
-                            break;
-                        }
-                        // success, invoke client callback
-                        callback_(cref(ctrl_msg));
-                    } else {
-                        if (fds[0].revents & (POLLERR|POLLHUP)) {
-                            cout << "AudioSink Poll Fail event: "
-                                << fds[0].revents
-                                << ", reconnect\n";
-                            socket_client_->Close();
-                            break;
-                        }
-                        cout << "AudioSink : Poll revents " << fds[0].revents << "\n";
-                    }
-                } while (should_continue_);
-            }
-        });
+        talker_.Start();
     }
 
     ~Impl()
     {
-        should_continue_ = false;
-        vhal_talker_thread_.join();
+        talker_.Stop();
     }
 
     bool RegisterCallback(AudioCallback callback)
@@ -128,20 +74,72 @@ public:
         return true;
     }
 
-    IOResult SendDataPacket(const uint8_t* packet, size_t size)
+    ssize_t SendDataPacket(const uint8_t* packet, size_t size, std::error_code& ec)
     {
-        auto [sent, error_msg] = socket_client_->Send(reinterpret_cast<const uint8_t*>(packet), size);
-        if (sent == -1)
-            return { sent, error_msg };
-        // success
-        return { size, "" };
+        return socket_client_->SendAll(packet, size, -1, ec);
+    }
+
+    ssize_t SendDataPacket(const struct iovec* iov, int iovcnt, std::error_code& ec)
+    {
+        return socket_client_->SendAll(iov, iovcnt, -1, ec);
     }
 
 private:
     AudioCallback                   callback_ = nullptr;
     unique_ptr<IStreamSocketClient> socket_client_;
-    thread                          vhal_talker_thread_;
-    atomic<bool>                    should_continue_ = true;
+    FramedReader                    reader_;
+
+    // Declared last: its callbacks use every member above.
+    VhalTalker talker_;
+
+    VhalTalker::Ops TalkerOps()
+    {
+        VhalTalker::Ops ops;
+        ops.connect   = [this]() { return socket_client_->Connect(); };
+        ops.connected = [this]() { return socket_client_->Connected(); };
+        ops.fd        = [this]() { return socket_client_->GetNativeSocketFd(); };
+        ops.close     = [this]() { socket_client_->Close(); };
+        ops.on_connected = [this]() {
+            VHAL_LOG(kInfo) << "Connected to Audio VHal (sink)!";
+            reader_.Reset();
+        };
+        ops.on_connect_failed = [](const std::string& error_msg,
+                                   std::chrono::milliseconds retry_in) {
+            VHAL_LOG(kWarning)
+              << "AudioSink Failed to connect to VHal: " << error_msg
+              << ". Retry in " << retry_in.count() << "ms...";
+        };
+        ops.on_event = [this](short revents) { return OnVhalEvent(revents); };
+        return ops;
+    }
+
+    // Handle poll() events of the VHal socket, false to reconnect.
+    bool OnVhalEvent(short revents)
+    {
+        if (revents & POLLIN) {
+            auto [received, recv_err_msg] = reader_.Fill();
+            if (received <= 0) {
+                VHAL_LOG(kError) << "Failed to read message from AudioSink: "
+                                 << recv_err_msg
+                                 << ", going to disconnect and reconnect.";
+                return false;
+            }
+            CtrlMessage ctrl_msg;
+            while (reader_.Next(ctrl_msg)) {
+                // success, invoke client callback
+                callback_(cref(ctrl_msg));
+            }
+        } else {
+            if (revents & (POLLERR|POLLHUP)) {
+                VHAL_LOG(kError) << "AudioSink Poll Fail event: "
+                                 << revents
+                                 << ", reconnect";
+                return false;
+            }
+            VHAL_LOG(kDebug) << "AudioSink : Poll revents " << revents;
+        }
+        return true;
+    }
 };
 
 } // namespace audio
@@ -37,8 +37,19 @@ AudioSource::AudioSource(TcpConnectionInfo tcp_conn_info)
 {
     auto tcp_sock_client =
       std::make_unique<TcpStreamSocketClient>(tcp_conn_info.ip_addr,
-      LIBVHAL_AUDIO_PLAYBACK_PORT);
-    impl_ = std::make_unique<Impl>(std::move(tcp_sock_client));
+      LIBVHAL_AUDIO_PLAYBACK_PORT, tcp_conn_info.socket_options);
+    impl_ = std::make_unique<Impl>(std::move(tcp_sock_client),
+                                   tcp_conn_info.event_loop);
+}
+
+AudioSource::AudioSource(std::unique_ptr<IStreamSocketClient> socket_client,
+                          std::shared_ptr<EventLoop>           event_loop)
+{
+    if (!socket_client) {
+        throw std::invalid_argument("Please set a valid socket_client");
+    }
+    impl_ = std::make_unique<Impl>(std::move(socket_client),
+                                   std::move(event_loop));
 }
 
 AudioSource::~AudioSource() {}
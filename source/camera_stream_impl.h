@@ -0,0 +1,110 @@
+#ifndef CAMERA_STREAM_IMPL_H
+#define CAMERA_STREAM_IMPL_H
+/**
+ * @file camera_stream_impl.h
+ * @brief
+ * @version 0.1
+ * @date 2021-08-19
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "frame_pacer.h"
+#include "frame_queue.h"
+#include "nal_classifier.h"
+#include "stream_mux.h"
+#include "vhal_log.h"
+#include "video_sink.h"
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace vhal {
+namespace client {
+
+class VideoSink::CameraStream::Impl
+{
+public:
+    // camera_id must have been registered with mux.
+    Impl(StreamMux&      mux,
+         uint32_t        camera_id,
+         size_t          depth,
+         SendQueuePolicy policy)
+      : mux_{ mux },
+        camera_id_{ camera_id },
+        queue_{ depth, policy },
+        sender_{ [this]() { SenderLoop(); } }
+    {}
+
+    ~Impl()
+    {
+        queue_.Close();
+        sender_.join();
+        mux_.Unregister(camera_id_);
+    }
+
+    uint32_t CameraId() const { return camera_id_; }
+
+    IOResult SendDataPacket(const uint8_t* packet, size_t size)
+    {
+        FrameClass frame_class = ClassifyAnnexBFrame(
+          VideoCodecType(frame_codec_.load()), packet, size);
+        if (!queue_.Push(packet, size, frame_class)) {
+            return { 0, "Send queue full, frame dropped" };
+        }
+        return { size, "" };
+    }
+
+    void SetFrameRate(uint32_t fps) { pacer_.SetFrameRate(fps); }
+
+    void SetFrameCodec(VideoCodecType codec) { frame_codec_ = codec; }
+
+    uint64_t GetDroppedFrameCount() const
+    {
+        return queue_.Dropped() + send_failures_;
+    }
+
+    FramePacer::Stats GetPacingStats() const { return pacer_.GetStats(); }
+
+private:
+    void SenderLoop()
+    {
+        std::vector<uint8_t> frame;
+        std::error_code      ec;
+        while (queue_.Pop(frame)) {
+            pacer_.WaitNextFrame();
+            if (mux_.SendFrame(camera_id_, frame.data(), frame.size(), ec) ==
+                -1) {
+                VHAL_LOG(kError) << "Camera " << camera_id_
+                                 << ": failed to send frame: " << ec.message();
+                send_failures_++;
+            }
+        }
+    }
+
+    StreamMux&             mux_;
+    const uint32_t         camera_id_;
+    FramePacer             pacer_{ 0 };
+    FrameQueue             queue_;
+    std::atomic<uint64_t>  send_failures_ = 0;
+    std::atomic<uint32_t>  frame_codec_   = 0;
+
+    // Declared last: the thread uses every member above.
+    std::thread sender_;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* CAMERA_STREAM_IMPL_H */
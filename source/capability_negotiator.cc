@@ -0,0 +1,261 @@
+/**
+ * @file capability_negotiator.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-20
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "capability_negotiator.h"
+#include <algorithm>
+#include <utility>
+
+namespace vhal {
+namespace client {
+
+using namespace std::chrono;
+
+CapabilityNegotiator::CapabilityNegotiator(Ops ops)
+  : ops_{ std::move(ops) }
+{}
+
+CapabilityNegotiator::~CapabilityNegotiator()
+{
+    std::vector<std::function<void()>> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        while (!queue_.empty()) {
+            done.push_back(Complete(0, nullptr, false));
+        }
+    }
+    changed_.notify_all();
+    if (watchdog_.joinable()) {
+        watchdog_.join();
+    }
+    for (auto& report : done) {
+        report();
+    }
+}
+
+void
+CapabilityNegotiator::RequestCapability(milliseconds       timeout,
+                                        CapabilityCallback done)
+{
+    Request request;
+    request.kind          = Kind::kCapability;
+    request.deadline      = steady_clock::now() + timeout;
+    request.on_capability = std::move(done);
+    Submit(std::move(request));
+}
+
+void
+CapabilityNegotiator::SendCameraInfo(
+  std::vector<VideoSink::camera_info_t> camera_info,
+  milliseconds                          timeout,
+  AckCallback                           done)
+{
+    Request request;
+    request.kind        = Kind::kCameraInfo;
+    request.camera_info = std::move(camera_info);
+    request.deadline    = steady_clock::now() + timeout;
+    request.on_ack      = std::move(done);
+    Submit(std::move(request));
+}
+
+void
+CapabilityNegotiator::Submit(Request request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        request.id = next_id_++;
+        queue_.push_back(std::move(request));
+        if (!watchdog_.joinable()) {
+            watchdog_ = std::thread([this]() { Watchdog(); });
+        }
+    }
+    changed_.notify_all();
+    Pump();
+}
+
+void
+CapabilityNegotiator::Pump()
+{
+    for (;;) {
+        uint64_t                              id;
+        Kind                                  kind;
+        std::vector<VideoSink::camera_info_t> camera_info;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty() || queue_.front().sent) {
+                return;
+            }
+            Request& head = queue_.front();
+            head.sent     = true;
+            id            = head.id;
+            kind          = head.kind;
+            camera_info   = head.camera_info;
+        }
+
+        // Not under mutex_: the reply may be handled before this returns.
+        bool sent = kind == Kind::kCapability
+                      ? ops_.request_capability()
+                      : ops_.send_camera_info(camera_info);
+        if (sent) {
+            return;
+        }
+
+        std::function<void()> report;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            report = Complete(id, nullptr, false);
+        }
+        changed_.notify_all();
+        report();
+    }
+}
+
+std::function<void()>
+CapabilityNegotiator::Complete(uint64_t                    id,
+                               std::shared_ptr<Capability> capability,
+                               bool                        acked)
+{
+    if (queue_.empty() || (id != 0 && queue_.front().id != id)) {
+        return []() {};
+    }
+    Request request = std::move(queue_.front());
+    queue_.pop_front();
+    return Report(std::move(request), std::move(capability), acked);
+}
+
+std::function<void()>
+CapabilityNegotiator::Report(Request                     request,
+                             std::shared_ptr<Capability> capability,
+                             bool                        acked)
+{
+    if (request.kind == Kind::kCapability) {
+        return [done = std::move(request.on_capability), capability]() {
+            if (done) {
+                done(capability);
+            }
+        };
+    }
+    return [done = std::move(request.on_ack), acked]() {
+        if (done) {
+            done(acked);
+        }
+    };
+}
+
+void
+CapabilityNegotiator::OnCapability(const Capability& capability)
+{
+    auto                  received = std::make_shared<Capability>(capability);
+    std::function<void()> report   = []() {};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cached_ = received;
+        // Unsolicited, or the reply to a request that timed out: only
+        // refresh the cache.
+        if (!queue_.empty() && queue_.front().sent &&
+            queue_.front().kind == Kind::kCapability) {
+            report = Complete(queue_.front().id, received, false);
+        }
+    }
+    changed_.notify_all();
+    report();
+    Pump();
+}
+
+void
+CapabilityNegotiator::OnAck(VideoSink::CameraAck ack)
+{
+    std::function<void()> report = []() {};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!queue_.empty() && queue_.front().sent &&
+            queue_.front().kind == Kind::kCameraInfo) {
+            report = Complete(
+              queue_.front().id, nullptr, ack == VideoSink::ACK_CONFIG);
+        }
+    }
+    changed_.notify_all();
+    report();
+    Pump();
+}
+
+void
+CapabilityNegotiator::OnConnected()
+{
+    std::function<void()> report = []() {};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!queue_.empty() && queue_.front().sent) {
+            report = Complete(queue_.front().id, nullptr, false);
+        }
+    }
+    changed_.notify_all();
+    report();
+    Pump();
+}
+
+std::shared_ptr<CapabilityNegotiator::Capability>
+CapabilityNegotiator::CachedCapability() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cached_;
+}
+
+void
+CapabilityNegotiator::Watchdog()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (queue_.empty()) {
+            changed_.wait(lock);
+            continue;
+        }
+        auto deadline = queue_.front().deadline;
+        for (const auto& request : queue_) {
+            deadline = std::min(deadline, request.deadline);
+        }
+        changed_.wait_until(lock, deadline);
+
+        // Expire everything past its deadline, on the wire or not.
+        auto                               now = steady_clock::now();
+        std::vector<std::function<void()>> done;
+        std::deque<Request>                pending;
+        for (auto& request : queue_) {
+            if (request.deadline <= now) {
+                done.push_back(Report(std::move(request), nullptr, false));
+            } else {
+                pending.push_back(std::move(request));
+            }
+        }
+        queue_.swap(pending);
+        if (done.empty()) {
+            continue;
+        }
+        lock.unlock();
+        for (auto& report : done) {
+            report();
+        }
+        Pump();
+        lock.lock();
+    }
+}
+
+} // namespace client
+} // namespace vhal
@@ -0,0 +1,149 @@
+#ifndef CAPABILITY_NEGOTIATOR_H
+#define CAPABILITY_NEGOTIATOR_H
+/**
+ * @file capability_negotiator.h
+ * @brief Request/response state machine for the Camera VHAL capability
+ *        exchange.
+ * @version 0.1
+ * @date 2021-08-20
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "video_sink.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Serializes REQUST_CAPABILITY and CAMERA_INFO requests and matches
+ * them with the CAPABILITY and ACK messages of the VHAL.
+ *
+ * The protocol has no request ids, so requests are queued and only the
+ * oldest one is on the wire: it completes with the next response of its
+ * type, a failed send, a new connection, or its deadline, whichever comes
+ * first; then the next one is sent. Deadlines are enforced by a watchdog
+ * thread that only exists once a request has been made. A reply that comes
+ * after its request timed out is taken for the reply to the next request
+ * of the same type, if one is on the wire by then.
+ *
+ * Completion callbacks run on whichever thread completes the request: the
+ * talker thread, the watchdog, or the caller if the send fails. They must
+ * not block on another request of the same negotiator.
+ *
+ * The last capability received is kept across reconnects.
+ */
+class CapabilityNegotiator
+{
+public:
+    using Capability         = VideoSink::camera_capability_t;
+    using CapabilityCallback = VideoSink::CapabilityCallback;
+    using AckCallback        = VideoSink::AckCallback;
+
+    struct Ops
+    {
+        // Write the request; false if it could not be sent.
+        std::function<bool()> request_capability;
+        std::function<bool(const std::vector<VideoSink::camera_info_t>&)>
+          send_camera_info;
+    };
+
+    explicit CapabilityNegotiator(Ops ops);
+    // Fails whatever is still pending.
+    ~CapabilityNegotiator();
+
+    CapabilityNegotiator(const CapabilityNegotiator&) = delete;
+    CapabilityNegotiator& operator=(const CapabilityNegotiator&) = delete;
+
+    void RequestCapability(std::chrono::milliseconds timeout,
+                           CapabilityCallback        done);
+
+    void SendCameraInfo(std::vector<VideoSink::camera_info_t> camera_info,
+                        std::chrono::milliseconds             timeout,
+                        AckCallback                           done);
+
+    // VHAL messages, from the talker thread.
+    void OnCapability(const Capability& capability);
+    void OnAck(VideoSink::CameraAck ack);
+
+    /**
+     * @brief A new connection: the request on the wire, if any, will never
+     * be answered. Fail it and start the next one.
+     */
+    void OnConnected();
+
+    /**
+     * @brief Last capability the VHAL sent, nullptr if none yet.
+     */
+    std::shared_ptr<Capability> CachedCapability() const;
+
+private:
+    enum class Kind
+    {
+        kCapability,
+        kCameraInfo,
+    };
+
+    struct Request
+    {
+        uint64_t                              id;
+        Kind                                  kind;
+        std::vector<VideoSink::camera_info_t> camera_info;
+        std::chrono::steady_clock::time_point deadline;
+        CapabilityCallback                    on_capability;
+        AckCallback                           on_ack;
+        bool                                  sent = false;
+    };
+
+    void Submit(Request request);
+
+    // Send the oldest request unless it is on the wire already.
+    void Pump();
+
+    // Pop the oldest request if it is id (any kind if id is 0) and return
+    // the callback that reports result to its owner. mutex_ held.
+    std::function<void()> Complete(uint64_t                    id,
+                                   std::shared_ptr<Capability> capability,
+                                   bool                        acked);
+
+    // The callback that reports result to the owner of request.
+    static std::function<void()> Report(Request                     request,
+                                        std::shared_ptr<Capability> capability,
+                                        bool                        acked);
+
+    void Watchdog();
+
+    const Ops ops_;
+
+    mutable std::mutex          mutex_;
+    std::condition_variable     changed_;
+    std::deque<Request>         queue_;
+    uint64_t                    next_id_ = 1;
+    std::shared_ptr<Capability> cached_;
+    bool                        stop_ = false;
+    std::thread                 watchdog_;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* CAPABILITY_NEGOTIATOR_H */
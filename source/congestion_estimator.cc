@@ -0,0 +1,86 @@
+/**
+ * @file congestion_estimator.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-30
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "latency_histogram.h"
+#include <algorithm>
+#include "congestion_estimator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace vhal {
+namespace client {
+
+CongestionEstimator::CongestionEstimator(uint64_t max_bitrate_bps)
+  : max_bitrate_bps_{ max_bitrate_bps }
+{}
+
+VideoSink::CongestionReport
+CongestionEstimator::Update(const Sample& sample)
+{
+    VideoSink::CongestionReport report;
+    report.socket_backlog = sample.socket_backlog;
+    report.send_blocked   = sample.send_blocked;
+    report.queue_depth    = sample.queue_depth;
+    report.queue_capacity = sample.queue_capacity;
+
+    double seconds = std::chrono::duration<double>(sample.interval).count();
+    double fps     = 0;
+    if (seconds > 0) {
+        report.throughput_bps = uint64_t(sample.bytes * 8 / seconds);
+        fps                   = sample.frames / seconds;
+    }
+    peak_fps_ = std::max(peak_fps_, fps);
+
+    report.congested =
+      sample.send_blocked * 10 > sample.interval ||
+      (sample.queue_capacity > 0 &&
+       sample.queue_depth * 2 >= sample.queue_capacity) ||
+      sample.socket_backlog >
+        std::max<uint64_t>(kMinBacklog, sample.bytes / 2);
+
+    ceiling_bps_ = max_bitrate_bps_
+                     ? max_bitrate_bps_
+                     : std::max(ceiling_bps_, report.throughput_bps);
+    if (target_bps_ == 0) {
+        target_bps_ = ceiling_bps_;
+    }
+    if (report.congested) {
+        clear_intervals_ = 0;
+        // Whatever got through is what the link can take right now.
+        uint64_t base = report.throughput_bps > 0
+                          ? std::min(target_bps_, report.throughput_bps)
+                          : target_bps_;
+        target_bps_ = base / 20 * 17;
+    } else if (++clear_intervals_ >= kClearIntervals) {
+        target_bps_ += ceiling_bps_ / 20;
+    }
+    target_bps_ = std::clamp(target_bps_, ceiling_bps_ / 10, ceiling_bps_);
+    report.target_bitrate_bps = target_bps_;
+
+    double base_fps = sample.frame_rate ? sample.frame_rate : peak_fps_;
+    if (base_fps > 0 && ceiling_bps_ > 0) {
+        report.target_frame_rate = std::max<uint32_t>(
+          1, uint32_t(std::ceil(base_fps * target_bps_ / ceiling_bps_)));
+    }
+    return report;
+}
+
+} // namespace client
+} // namespace vhal
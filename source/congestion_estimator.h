@@ -0,0 +1,82 @@
+#ifndef CONGESTION_ESTIMATOR_H
+#define CONGESTION_ESTIMATOR_H
+/**
+ * @file congestion_estimator.h
+ * @brief Turns send backlog samples into a suggested encoder rate.
+ * @version 0.1
+ * @date 2021-08-30
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "video_sink.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Backs a VideoSink congestion monitor, one Update() per interval.
+ *
+ * An interval is congested if a tenth of it was spent blocked in writes,
+ * if the async queue is at least half full, or if the socket holds more
+ * than half of what was written during the interval (and at least
+ * kMinBacklog). The target bitrate then drops to 85% of the measured
+ * throughput; after kClearIntervals clear intervals in a row it climbs
+ * back by a twentieth of the ceiling per interval. It never goes below a
+ * tenth of the ceiling.
+ *
+ * Not thread-safe.
+ */
+class CongestionEstimator
+{
+public:
+    struct Sample
+    {
+        size_t                   socket_backlog = 0;
+        std::chrono::nanoseconds send_blocked   = {};
+        size_t                   queue_depth    = 0;
+        size_t                   queue_capacity = 0;
+        // Payload bytes and data packets written during the interval.
+        uint64_t bytes  = 0;
+        uint64_t frames = 0;
+        std::chrono::nanoseconds interval = {};
+        // Paced frame rate, 0 if not pacing.
+        uint32_t frame_rate = 0;
+    };
+
+    static constexpr size_t kMinBacklog     = 64 * 1024;
+    static constexpr int    kClearIntervals = 3;
+
+    /**
+     * @param max_bitrate_bps Ceiling of the target, 0 for the highest
+     *        throughput seen.
+     */
+    explicit CongestionEstimator(uint64_t max_bitrate_bps);
+
+    VideoSink::CongestionReport Update(const Sample& sample);
+
+private:
+    const uint64_t max_bitrate_bps_;
+    uint64_t       ceiling_bps_     = 0;
+    uint64_t       target_bps_      = 0;
+    double         peak_fps_        = 0;
+    int            clear_intervals_ = 0;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* CONGESTION_ESTIMATOR_H */
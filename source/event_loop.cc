@@ -0,0 +1,40 @@
+/**
+ * @file event_loop.cc
+ * @brief
+ * @version 1.0
+ * @date 2021-08-11
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "event_loop.h"
+#include "event_loop_impl.h"
+
+namespace vhal {
+namespace client {
+
+EventLoop::EventLoop(unsigned int num_threads)
+  : impl_{ std::make_unique<Impl>(num_threads) }
+{}
+
+EventLoop::~EventLoop() = default;
+
+unsigned int
+EventLoop::ThreadCount() const
+{
+    return impl_->ThreadCount();
+}
+
+} // namespace client
+} // namespace vhal
@@ -0,0 +1,288 @@
+#ifndef EVENT_LOOP_IMPL_H
+#define EVENT_LOOP_IMPL_H
+/**
+ * @file event_loop_impl.h
+ * @brief
+ * @version 1.0
+ * @date 2021-08-11
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "event_loop.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+extern "C"
+{
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+}
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief One epoll thread of an EventLoop.
+ *
+ * Post() and RunSync() may be called from any thread. Everything else must
+ * run on the loop thread, i.e. from a handler, a timer or a posted task.
+ */
+class EventLoopWorker
+{
+public:
+    using Handler = std::function<void(uint32_t events)>;
+    using Task    = std::function<void()>;
+
+    EventLoopWorker()
+    {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+        wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wake_fd_ < 0) {
+            close(epoll_fd_);
+            throw std::system_error(errno, std::system_category());
+        }
+        struct epoll_event ev = {};
+        ev.events             = EPOLLIN;
+        ev.data.u64           = kWakeId;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+        thread_ = std::thread([this]() { Run(); });
+    }
+
+    ~EventLoopWorker()
+    {
+        Post([this]() { running_ = false; });
+        thread_.join();
+        close(wake_fd_);
+        close(epoll_fd_);
+    }
+
+    bool InLoopThread() const
+    {
+        return std::this_thread::get_id() == thread_.get_id();
+    }
+
+    void Post(Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0) {
+            // Counter overflow only, the loop is awake already.
+        }
+    }
+
+    // Run task on the loop thread and wait for it to finish.
+    void RunSync(Task task)
+    {
+        if (InLoopThread()) {
+            task();
+            return;
+        }
+        std::promise<void> done;
+        Post([&task, &done]() {
+            task();
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+
+    // Returns a watch id for Unwatch(), 0 on failure.
+    uint64_t Watch(int fd, uint32_t events, Handler handler)
+    {
+        uint64_t           id = next_id_++;
+        struct epoll_event ev = {};
+        ev.events             = events;
+        ev.data.u64           = id;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            return 0;
+        }
+        watches_[id] = { fd, std::make_shared<Handler>(std::move(handler)) };
+        return id;
+    }
+
+    // Must be called before fd is closed.
+    void Unwatch(uint64_t id)
+    {
+        auto it = watches_.find(id);
+        if (it == watches_.end()) {
+            return;
+        }
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        watches_.erase(it);
+    }
+
+    uint64_t RunAfter(std::chrono::milliseconds delay, Task task)
+    {
+        uint64_t id = next_id_++;
+        timer_queue_.emplace(std::chrono::steady_clock::now() + delay, id);
+        timers_[id] = std::move(task);
+        return id;
+    }
+
+    void CancelTimer(uint64_t id) { timers_.erase(id); }
+
+    // Number of objects pinned to this worker, for load balancing.
+    std::atomic<unsigned int> users = 0;
+
+private:
+    static constexpr uint64_t kWakeId    = 0;
+    static constexpr int      kMaxEvents = 64;
+
+    struct Watched
+    {
+        int                      fd;
+        std::shared_ptr<Handler> handler;
+    };
+
+    void Run()
+    {
+        struct epoll_event events[kMaxEvents];
+        while (running_) {
+            int n = epoll_wait(epoll_fd_, events, kMaxEvents, NextTimeout());
+            if (n < 0 && errno != EINTR) {
+                throw std::system_error(errno, std::system_category());
+            }
+            for (int i = 0; i < n; i++) {
+                if (events[i].data.u64 == kWakeId) {
+                    RunTasks();
+                    continue;
+                }
+                // Earlier handlers in this batch may have removed the watch;
+                // ids are never reused, so stale events just drop out here.
+                auto it = watches_.find(events[i].data.u64);
+                if (it == watches_.end()) {
+                    continue;
+                }
+                auto handler = it->second.handler;
+                (*handler)(events[i].events);
+            }
+            RunTimers();
+        }
+    }
+
+    void RunTasks()
+    {
+        uint64_t count;
+        if (read(wake_fd_, &count, sizeof(count)) < 0) {
+            // Nothing to drain.
+        }
+        std::vector<Task> tasks;
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex_);
+            tasks.swap(tasks_);
+        }
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+
+    void RunTimers()
+    {
+        auto now = std::chrono::steady_clock::now();
+        while (!timer_queue_.empty() && timer_queue_.begin()->first <= now) {
+            uint64_t id = timer_queue_.begin()->second;
+            timer_queue_.erase(timer_queue_.begin());
+            auto it = timers_.find(id);
+            if (it == timers_.end()) {
+                continue; // cancelled
+            }
+            Task task = std::move(it->second);
+            timers_.erase(it);
+            task();
+        }
+    }
+
+    int NextTimeout()
+    {
+        // Drop cancelled timers so they do not cause spurious wakeups.
+        while (!timer_queue_.empty() &&
+               timers_.count(timer_queue_.begin()->second) == 0) {
+            timer_queue_.erase(timer_queue_.begin());
+        }
+        if (timer_queue_.empty()) {
+            return -1;
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          timer_queue_.begin()->first - std::chrono::steady_clock::now());
+        // Round up so that we never wake up just before the deadline.
+        return std::max<int>(0, left.count() + 1);
+    }
+
+    int               epoll_fd_ = -1;
+    int               wake_fd_  = -1;
+    std::thread       thread_;
+    bool              running_ = true;
+    std::mutex        tasks_mutex_;
+    std::vector<Task> tasks_;
+    uint64_t          next_id_ = 1;
+
+    std::unordered_map<uint64_t, Watched>                       watches_;
+    std::multimap<std::chrono::steady_clock::time_point, uint64_t> timer_queue_;
+    std::unordered_map<uint64_t, Task>                          timers_;
+};
+
+class EventLoop::Impl
+{
+public:
+    Impl(unsigned int num_threads)
+    {
+        num_threads = std::max(1u, num_threads);
+        for (unsigned int i = 0; i < num_threads; i++) {
+            workers_.push_back(std::make_unique<EventLoopWorker>());
+        }
+    }
+
+    unsigned int ThreadCount() const { return workers_.size(); }
+
+    // Pin a new object to the least busy worker.
+    EventLoopWorker* Acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::min_element(
+          workers_.begin(), workers_.end(), [](auto& a, auto& b) {
+              return a->users < b->users;
+          });
+        (*it)->users++;
+        return it->get();
+    }
+
+    void Release(EventLoopWorker* worker) { worker->users--; }
+
+private:
+    std::mutex                                    mutex_;
+    std::vector<std::unique_ptr<EventLoopWorker>> workers_;
+};
+
+} // namespace client
+} // namespace vhal
+
+#endif /* EVENT_LOOP_IMPL_H */
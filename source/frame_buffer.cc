@@ -0,0 +1,119 @@
+/**
+ * @file frame_buffer.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-26
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "frame_buffer.h"
+#include "frame_buffer_impl.h"
+#include <algorithm>
+#include <utility>
+
+namespace vhal {
+namespace client {
+
+FrameBuffer::FrameBuffer(uint8_t* data, size_t capacity, ReleaseCallback release)
+  : data_{ data }
+  , size_{ capacity }
+  , capacity_{ capacity }
+  , release_{ std::move(release) }
+{}
+
+FrameBuffer
+FrameBuffer::Allocate(size_t capacity)
+{
+    return FrameBuffer(new uint8_t[capacity], capacity, [](uint8_t* data) {
+        delete[] data;
+    });
+}
+
+FrameBuffer::~FrameBuffer()
+{
+    Reset();
+}
+
+FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept
+  : data_{ std::exchange(other.data_, nullptr) }
+  , size_{ std::exchange(other.size_, 0) }
+  , capacity_{ std::exchange(other.capacity_, 0) }
+  , release_{ std::move(other.release_) }
+{
+    other.release_ = nullptr;
+}
+
+FrameBuffer&
+FrameBuffer::operator=(FrameBuffer&& other) noexcept
+{
+    if (this != &other) {
+        Reset();
+        data_     = std::exchange(other.data_, nullptr);
+        size_     = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+        release_  = std::move(other.release_);
+        other.release_ = nullptr;
+    }
+    return *this;
+}
+
+void
+FrameBuffer::SetSize(size_t size)
+{
+    size_ = std::min(size, capacity_);
+}
+
+void
+FrameBuffer::Reset()
+{
+    uint8_t*        data    = std::exchange(data_, nullptr);
+    ReleaseCallback release = std::move(release_);
+    release_  = nullptr;
+    size_     = 0;
+    capacity_ = 0;
+    if (data != nullptr && release) {
+        release(data);
+    }
+}
+
+FrameBufferPool::FrameBufferPool(size_t buffer_size, size_t count)
+  : impl_{ new Impl(buffer_size, count) }
+{}
+
+FrameBufferPool::~FrameBufferPool()
+{
+    impl_->Unref();
+}
+
+FrameBuffer
+FrameBufferPool::Acquire()
+{
+    return impl_->Acquire();
+}
+
+size_t
+FrameBufferPool::Available() const
+{
+    return impl_->Available();
+}
+
+size_t
+FrameBufferPool::BufferSize() const
+{
+    return impl_->BufferSize();
+}
+
+} // namespace client
+} // namespace vhal
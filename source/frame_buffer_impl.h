@@ -0,0 +1,100 @@
+#ifndef FRAME_BUFFER_IMPL_H
+#define FRAME_BUFFER_IMPL_H
+/**
+ * @file frame_buffer_impl.h
+ * @brief
+ * @version 0.1
+ * @date 2021-08-26
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "frame_buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vhal {
+namespace client {
+
+// One reference for the pool and one per buffer handed out; the last one
+// deletes the Impl. The release hook captures a plain Impl*, which
+// std::function stores without allocating, unlike a shared_ptr.
+class FrameBufferPool::Impl
+{
+public:
+    Impl(size_t buffer_size, size_t count)
+      : buffer_size_{ buffer_size },
+        memory_{ std::make_unique<uint8_t[]>(buffer_size * count) }
+    {
+        free_.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            free_.push_back(memory_.get() + i * buffer_size);
+        }
+    }
+
+    FrameBuffer Acquire()
+    {
+        uint8_t* data;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.empty()) {
+                return {};
+            }
+            data = free_.back();
+            free_.pop_back();
+        }
+        refs_++;
+        return FrameBuffer(data, buffer_size_, [this](uint8_t* data) {
+            Return(data);
+        });
+    }
+
+    size_t Available() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+
+    size_t BufferSize() const { return buffer_size_; }
+
+    void Unref()
+    {
+        if (--refs_ == 0) {
+            delete this;
+        }
+    }
+
+private:
+    void Return(uint8_t* data)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(data);
+        }
+        Unref();
+    }
+
+    const size_t               buffer_size_;
+    std::unique_ptr<uint8_t[]> memory_;
+    mutable std::mutex         mutex_;
+    std::vector<uint8_t*>      free_;
+    std::atomic<size_t>        refs_ = 1;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* FRAME_BUFFER_IMPL_H */
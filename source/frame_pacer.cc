@@ -0,0 +1,64 @@
+/**
+ * @file frame_pacer.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-18
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "frame_pacer.h"
+#include "frame_pacer_impl.h"
+
+namespace vhal {
+namespace client {
+
+FramePacer::FramePacer(uint32_t fps)
+  : impl_{ std::make_unique<Impl>(fps) }
+{}
+
+FramePacer::~FramePacer() = default;
+
+void
+FramePacer::SetFrameRate(uint32_t fps)
+{
+    impl_->SetFrameRate(fps);
+}
+
+uint32_t
+FramePacer::GetFrameRate() const
+{
+    return impl_->GetFrameRate();
+}
+
+bool
+FramePacer::WaitNextFrame()
+{
+    return impl_->WaitNextFrame();
+}
+
+void
+FramePacer::Reset()
+{
+    impl_->Reset();
+}
+
+FramePacer::Stats
+FramePacer::GetStats() const
+{
+    return impl_->GetStats();
+}
+
+} // namespace client
+} // namespace vhal
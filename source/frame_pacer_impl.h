@@ -0,0 +1,150 @@
+#ifndef FRAME_PACER_IMPL_H
+#define FRAME_PACER_IMPL_H
+/**
+ * @file frame_pacer_impl.h
+ * @brief
+ * @version 0.1
+ * @date 2021-08-18
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "frame_pacer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+extern "C"
+{
+#include <time.h>
+}
+
+namespace vhal {
+namespace client {
+
+class FramePacer::Impl
+{
+public:
+    explicit Impl(uint32_t fps) : fps_{ fps } {}
+
+    void SetFrameRate(uint32_t fps)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fps_     = fps;
+        started_ = false;
+    }
+
+    uint32_t GetFrameRate() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return fps_;
+    }
+
+    bool WaitNextFrame()
+    {
+        int64_t deadline;
+        bool    on_time = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (fps_ == 0) {
+                stats_.frames++;
+                return true;
+            }
+            int64_t now = Now();
+            if (!started_) {
+                start_   = now;
+                next_    = 0;
+                started_ = true;
+            }
+            deadline       = Deadline(next_);
+            int64_t period = kNsPerSec / fps_;
+            if (now - deadline >= period) {
+                // Late by whole frames: skip their slots instead of
+                // bursting to catch up.
+                uint64_t missed = (now - deadline) / period;
+                next_ += missed;
+                stats_.skipped += missed;
+                deadline = Deadline(next_);
+                on_time  = false;
+            }
+            next_++;
+        }
+
+        SleepUntil(deadline);
+        int64_t jitter = std::max<int64_t>(Now() - deadline, 0);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.frames++;
+        stats_.last_jitter = std::chrono::nanoseconds(jitter);
+        stats_.max_jitter =
+          std::max(stats_.max_jitter, std::chrono::nanoseconds(jitter));
+        jitter_sum_ += jitter;
+        paced_++;
+        stats_.mean_jitter = std::chrono::nanoseconds(jitter_sum_ / paced_);
+        return on_time;
+    }
+
+    void Reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        started_ = false;
+    }
+
+    Stats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    static constexpr int64_t kNsPerSec = 1000000000;
+
+    static int64_t Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * kNsPerSec + ts.tv_nsec;
+    }
+
+    static void SleepUntil(int64_t deadline)
+    {
+        struct timespec ts = { static_cast<time_t>(deadline / kNsPerSec),
+                               static_cast<long>(deadline % kNsPerSec) };
+        // With TIMER_ABSTIME a signal costs nothing: just go back to sleep.
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+               EINTR) {
+        }
+    }
+
+    // Absolute time of frame n, mutex_ held. Derived from the frame index
+    // so rounding never accumulates.
+    int64_t Deadline(uint64_t n) const
+    {
+        return start_ + static_cast<int64_t>(n * kNsPerSec / fps_);
+    }
+
+    mutable std::mutex mutex_;
+    uint32_t           fps_;
+    bool               started_    = false;
+    int64_t            start_      = 0;
+    uint64_t           next_       = 0;
+    uint64_t           paced_      = 0;
+    int64_t            jitter_sum_ = 0;
+    Stats              stats_;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* FRAME_PACER_IMPL_H */
@@ -0,0 +1,229 @@
+/**
+ * @file frame_queue.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-17
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "frame_queue.h"
+#include <algorithm>
+#include <iterator>
+
+namespace vhal {
+namespace client {
+
+FrameQueue::FrameQueue(size_t depth, SendQueuePolicy policy)
+  : depth_{ std::max<size_t>(depth, 1) }
+  , policy_{ policy }
+{}
+
+bool
+FrameQueue::Push(const uint8_t*                            data,
+                 size_t                                    size,
+                 FrameClass                                frame_class,
+                 const VideoSink::camera_frame_metadata_t& metadata)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!Admit(lock, frame_class)) {
+        return false;
+    }
+
+    Frame frame;
+    if (!free_.empty()) {
+        frame.data = std::move(free_.back());
+        free_.pop_back();
+    }
+    frame.data.assign(data, data + size);
+    frame.frame_class = frame_class;
+    frame.metadata    = metadata;
+    queue_.push_back(std::move(frame));
+    not_empty_.notify_one();
+    return true;
+}
+
+bool
+FrameQueue::Push(FrameBuffer                               buffer,
+                 FrameClass                                frame_class,
+                 const VideoSink::camera_frame_metadata_t& metadata)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!Admit(lock, frame_class)) {
+        return false;
+    }
+
+    Frame frame;
+    frame.buffer      = std::move(buffer);
+    frame.frame_class = frame_class;
+    frame.metadata    = metadata;
+    queue_.push_back(std::move(frame));
+    not_empty_.notify_one();
+    return true;
+}
+
+bool
+FrameQueue::Admit(std::unique_lock<std::mutex>& lock, FrameClass frame_class)
+{
+    if (frame_class != FrameClass::kOpaque &&
+        policy_ != SendQueuePolicy::kBlock) {
+        if (awaiting_keyframe_ && (frame_class == FrameClass::kReference ||
+                                   frame_class == FrameClass::kNonReference)) {
+            dropped_++;
+            return false;
+        }
+        if (frame_class == FrameClass::kKeyframe) {
+            awaiting_keyframe_ = false;
+        }
+        if (!MakeRoom(frame_class)) {
+            dropped_++;
+            return false;
+        }
+    } else {
+        if (policy_ == SendQueuePolicy::kLatestOnly) {
+            while (!queue_.empty()) {
+                DropFront();
+            }
+        }
+        if (queue_.size() >= depth_) {
+            switch (policy_) {
+                case SendQueuePolicy::kBlock:
+                    not_full_.wait(lock, [this]() {
+                        return closed_ || queue_.size() < depth_;
+                    });
+                    break;
+                case SendQueuePolicy::kDropNewest:
+                    dropped_++;
+                    return false;
+                default:
+                    DropFront();
+                    break;
+            }
+        }
+    }
+    return !closed_;
+}
+
+bool
+FrameQueue::MakeRoom(FrameClass frame_class)
+{
+    // Parameter sets are small and the next keyframe needs them; they do
+    // not count against the depth.
+    if (frame_class == FrameClass::kParameterSets) {
+        return true;
+    }
+    size_t limit = policy_ == SendQueuePolicy::kLatestOnly ? 1 : depth_;
+    auto   is_picture = [](const Frame& frame) {
+        return frame.frame_class != FrameClass::kParameterSets;
+    };
+    if (size_t(std::count_if(queue_.begin(), queue_.end(), is_picture)) <
+        limit) {
+        return true;
+    }
+
+    // Nothing predicts from a non-reference frame.
+    auto oldest =
+      std::find_if(queue_.begin(), queue_.end(), [](const Frame& frame) {
+          return frame.frame_class == FrameClass::kNonReference;
+      });
+    if (oldest != queue_.end()) {
+        Drop(oldest);
+        return true;
+    }
+    if (frame_class == FrameClass::kNonReference) {
+        return false;
+    }
+
+    if (frame_class == FrameClass::kKeyframe) {
+        // Decoding restarts at the keyframe: keep only the parameter sets
+        // queued right before it.
+        auto keep = queue_.end();
+        while (keep != queue_.begin() &&
+               std::prev(keep)->frame_class == FrameClass::kParameterSets) {
+            --keep;
+        }
+        for (auto n = std::distance(queue_.begin(), keep); n > 0; n--) {
+            DropFront();
+        }
+        return true;
+    }
+
+    // Everything up to the next keyframe may predict from this frame.
+    awaiting_keyframe_ = true;
+    return false;
+}
+
+bool
+FrameQueue::Pop(std::vector<uint8_t>&               frame,
+                VideoSink::camera_frame_metadata_t* metadata,
+                FrameBuffer*                        buffer)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !queue_.empty(); });
+    if (closed_) {
+        return false;
+    }
+    Frame& front = queue_.front();
+    if (metadata != nullptr) {
+        *metadata = front.metadata;
+    }
+    if (!front.buffer) {
+        std::swap(frame, front.data);
+        free_.push_back(std::move(front.data));
+    } else if (buffer != nullptr) {
+        *buffer = std::move(front.buffer);
+    } else {
+        frame.assign(front.buffer.Data(),
+                     front.buffer.Data() + front.buffer.Size());
+    }
+    queue_.pop_front();
+    not_full_.notify_one();
+    return true;
+}
+
+void
+FrameQueue::Close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    queue_.clear();
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+size_t
+FrameQueue::Size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void
+FrameQueue::DropFront()
+{
+    Drop(queue_.begin());
+}
+
+void
+FrameQueue::Drop(std::deque<Frame>::iterator at)
+{
+    if (!at->buffer) {
+        free_.push_back(std::move(at->data));
+    }
+    queue_.erase(at);
+    dropped_++;
+}
+
+} // namespace client
+} // namespace vhal
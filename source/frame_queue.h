@@ -0,0 +1,165 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+/**
+ * @file frame_queue.h
+ * @brief Bounded frame queue between a producer and a sender thread.
+ * @version 0.1
+ * @date 2021-08-17
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "frame_buffer.h"
+#include "libvhal_common.h"
+#include "nal_classifier.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Holds up to depth frame copies for a sender thread; what happens
+ * when it is full is up to the SendQueuePolicy.
+ *
+ * Frame buffers are recycled: Pop() hands the consumer's previous buffer
+ * back to the queue, so once every buffer has grown to the frame size a
+ * Push() costs one memcpy and no allocation. A FrameBuffer is queued as
+ * is, without any copy, and released once the consumer is done with it or
+ * the frame is dropped.
+ *
+ * Frames pushed with a FrameClass other than kOpaque are dropped so that
+ * the decoder never sees a frame whose reference is gone: non-reference
+ * frames go first; when only reference frames are left the new frame goes,
+ * and so does everything after it up to the next keyframe; a keyframe
+ * replaces whatever older pictures are queued. Every policy but kBlock
+ * drops this way, with kLatestOnly keeping one frame at most.
+ *
+ * Push() and Pop() may be called from different threads.
+ */
+class FrameQueue
+{
+public:
+    FrameQueue(size_t depth, SendQueuePolicy policy);
+
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    /**
+     * @brief Copy a frame into the queue.
+     *
+     * @param frame_class See ClassifyAnnexBFrame().
+     * @param metadata Handed back by Pop() with the frame.
+     *
+     * @return true Queued.
+     * @return false Dropped by kDropNewest or because its reference was
+     *         dropped, or the queue is closed.
+     */
+    bool Push(const uint8_t*                            data,
+              size_t                                    size,
+              FrameClass                                frame_class = FrameClass::kOpaque,
+              const VideoSink::camera_frame_metadata_t& metadata    = {});
+
+    /**
+     * @brief Queue buffer without copying it. See the copying Push().
+     */
+    bool Push(FrameBuffer                               buffer,
+              FrameClass                                frame_class = FrameClass::kOpaque,
+              const VideoSink::camera_frame_metadata_t& metadata    = {});
+
+    /**
+     * @brief Wait for the next frame and swap it into frame. The previous
+     * contents of frame are kept for reuse.
+     *
+     * @param metadata If not null, set to what the frame was pushed with.
+     * @param buffer If not null, a frame pushed as FrameBuffer is moved
+     *        here and frame is left alone; otherwise it is copied into
+     *        frame.
+     *
+     * @return false The queue was closed.
+     */
+    bool Pop(std::vector<uint8_t>&              frame,
+             VideoSink::camera_frame_metadata_t* metadata = nullptr,
+             FrameBuffer*                        buffer   = nullptr);
+
+    /**
+     * @brief Wake up Push() and Pop() for good and discard what is queued.
+     */
+    void Close();
+
+    /**
+     * @brief Frames discarded by the policy so far.
+     */
+    uint64_t Dropped() const { return dropped_; }
+
+    /**
+     * @brief Frames waiting for the sender.
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Frames the queue holds at most.
+     */
+    size_t Depth() const { return depth_; }
+
+private:
+    struct Frame
+    {
+        std::vector<uint8_t>               data;
+        // Set instead of data for frames pushed as FrameBuffer.
+        FrameBuffer                        buffer;
+        FrameClass                         frame_class = FrameClass::kOpaque;
+        VideoSink::camera_frame_metadata_t metadata    = {};
+    };
+
+    // Apply the policy to a new frame of frame_class. mutex_ held, may
+    // wait for room.
+    //
+    // @return false Drop the new frame.
+    bool Admit(std::unique_lock<std::mutex>& lock, FrameClass frame_class);
+
+    // Move the oldest queued frame to the free list. mutex_ held.
+    void DropFront();
+
+    // Move queued frame at to the free list. mutex_ held.
+    void Drop(std::deque<Frame>::iterator at);
+
+    // Make room for a frame of frame_class without breaking references.
+    // mutex_ held.
+    //
+    // @return false Drop the new frame instead.
+    bool MakeRoom(FrameClass frame_class);
+
+    const size_t          depth_;
+    const SendQueuePolicy policy_;
+
+    mutable std::mutex                mutex_;
+    std::condition_variable           not_empty_;
+    std::condition_variable           not_full_;
+    std::deque<Frame>                 queue_;
+    std::vector<std::vector<uint8_t>> free_;
+    bool                              closed_  = false;
+    std::atomic<uint64_t>             dropped_ = 0;
+    // A reference frame was dropped; drop pictures until a keyframe.
+    bool awaiting_keyframe_ = false;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* FRAME_QUEUE_H */
@@ -0,0 +1,89 @@
+/**
+ * @file framed_reader.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-12
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "framed_reader.h"
+#include <algorithm>
+#include <cstring>
+extern "C"
+{
+#include <sys/socket.h>
+}
+
+namespace vhal {
+namespace client {
+
+FramedReader::FramedReader(IStreamSocketClient& client, size_t capacity)
+  : client_{ client }
+  , buffer_(capacity)
+{}
+
+IOResult
+FramedReader::Fill(size_t max)
+{
+    if (begin_ == end_) {
+        begin_ = end_ = 0;
+    } else if (end_ == buffer_.size()) {
+        // Move the partial frame to the front to make room behind it.
+        memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    size_t room = buffer_.size() - end_;
+    if (max > 0) {
+        room = std::min(room, max);
+    }
+    if (room == 0) {
+        return { -1, "Frame larger than read buffer" };
+    }
+    auto result = client_.Recv(buffer_.data() + end_, room, MSG_DONTWAIT);
+    if (std::get<0>(result) > 0) {
+        end_ += std::get<0>(result);
+    }
+    return result;
+}
+
+bool
+FramedReader::Peek(void* frame, size_t size) const
+{
+    if (Buffered() < size) {
+        return false;
+    }
+    memcpy(frame, buffer_.data() + begin_, size);
+    return true;
+}
+
+void
+FramedReader::Consume(size_t size)
+{
+    begin_ += std::min(size, Buffered());
+}
+
+bool
+FramedReader::Next(void* frame, size_t size)
+{
+    if (!Peek(frame, size)) {
+        return false;
+    }
+    Consume(size);
+    return true;
+}
+
+} // namespace client
+} // namespace vhal
@@ -0,0 +1,115 @@
+#ifndef FRAMED_READER_H
+#define FRAMED_READER_H
+/**
+ * @file framed_reader.h
+ * @brief Read-ahead buffer for the fixed-size control messages of the VHALs.
+ * @version 0.1
+ * @date 2021-08-12
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "istream_socket_client.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Collects bytes from an IStreamSocketClient and hands out whole
+ * frames.
+ *
+ * The talker calls Fill() once per POLLIN, which does a single non-blocking
+ * Recv() of everything queued (up to the buffer capacity), and then takes
+ * frames out with Next()/Peek() until one is incomplete. A frame split
+ * across TCP segments simply waits in the buffer for the next POLLIN, so the
+ * talker never blocks in the middle of a message, and a burst of messages
+ * costs one recv() instead of two per message.
+ *
+ * Not thread safe; used from the talker (or event loop) thread only.
+ */
+class FramedReader
+{
+public:
+    static constexpr size_t kDefaultCapacity = 4096;
+
+    /**
+     * @param client   Socket to read from; must outlive the reader.
+     * @param capacity Largest frame plus read-ahead.
+     */
+    explicit FramedReader(IStreamSocketClient& client,
+                          size_t               capacity = kDefaultCapacity);
+
+    /**
+     * @brief Recv() what is queued on the socket into the buffer.
+     *
+     * @param max Read at most this many bytes, 0 for as much as fits. Pass
+     *            the missing part of the current frame on sockets that carry
+     *            unframed data after the control messages, so the reader
+     *            never takes bytes that belong to somebody else.
+     *
+     * @return IOResult <bytes read, ""> on success. <0, ""> when the peer
+     *         closed the connection and <-1, error> on failure, including
+     *         a frame that does not fit the buffer; both mean reconnect.
+     */
+    IOResult Fill(size_t max = 0);
+
+    /**
+     * @brief Number of bytes buffered and not consumed yet.
+     */
+    size_t Buffered() const { return end_ - begin_; }
+
+    /**
+     * @brief Copy the first size buffered bytes to frame without consuming
+     * them.
+     *
+     * @return false Fewer than size bytes are buffered.
+     */
+    bool Peek(void* frame, size_t size) const;
+
+    /**
+     * @brief Drop size bytes from the front of the buffer.
+     */
+    void Consume(size_t size);
+
+    /**
+     * @brief Peek() and Consume() in one go.
+     */
+    bool Next(void* frame, size_t size);
+
+    template<typename T>
+    bool Next(T& frame)
+    {
+        return Next(&frame, sizeof(T));
+    }
+
+    /**
+     * @brief Forget buffered bytes. Call on every reconnect: leftovers of
+     * the previous connection must not be parsed as the start of a frame.
+     */
+    void Reset() { begin_ = end_ = 0; }
+
+private:
+    IStreamSocketClient& client_;
+    std::vector<uint8_t> buffer_;
+    size_t               begin_ = 0;
+    size_t               end_   = 0;
+};
+
+} // namespace client
+} // namespace vhal
+
+#endif /* FRAMED_READER_H */
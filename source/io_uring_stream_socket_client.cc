@@ -0,0 +1,158 @@
+/**
+ * @file io_uring_stream_socket_client.cc
+ * @brief
+ * @version 1.0
+ * @date 2021-08-04
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "io_uring_stream_socket_client.h"
+#include "io_uring_stream_socket_client_impl.h"
+
+namespace vhal {
+namespace client {
+IoUringStreamSocketClient::IoUringStreamSocketClient(
+  const std::string&   remote_server_path,
+  const SocketOptions& options)
+  : impl_{ std::make_unique<Impl>(remote_server_path, options) }
+{}
+
+IoUringStreamSocketClient::IoUringStreamSocketClient(
+  const std::string&   remote_server_ip,
+  const int            port,
+  const SocketOptions& options)
+  : impl_{ std::make_unique<Impl>(remote_server_ip, port, options) }
+{}
+
+IoUringStreamSocketClient::IoUringStreamSocketClient(
+  const int            android_vm_cid,
+  const unsigned int   port,
+  const SocketOptions& options)
+  : impl_{ std::make_unique<Impl>(android_vm_cid, port, options) }
+{}
+
+IoUringStreamSocketClient::~IoUringStreamSocketClient() = default;
+
+ConnectionResult
+IoUringStreamSocketClient::Connect()
+{
+    return impl_->Connect();
+}
+
+bool
+IoUringStreamSocketClient::Connected() const
+{
+    return impl_->Connected();
+}
+
+int
+IoUringStreamSocketClient::GetNativeSocketFd() const
+{
+    return impl_->GetNativeSocketFd();
+}
+
+IOResult
+IoUringStreamSocketClient::Send(const uint8_t* data, size_t size)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->Send(data, size, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+IoUringStreamSocketClient::Send(const uint8_t* data, size_t size, std::error_code& ec)
+{
+    return impl_->Send(data, size, ec);
+}
+
+IOResult
+IoUringStreamSocketClient::SendV(const struct iovec* iov, int iovcnt)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendV(iov, iovcnt, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+IoUringStreamSocketClient::SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+{
+    return impl_->SendV(iov, iovcnt, ec);
+}
+
+IOResult
+IoUringStreamSocketClient::SendAll(const uint8_t* data, size_t size, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = SendAll(data, size, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+IoUringStreamSocketClient::SendAll(const uint8_t*   data,
+                                  size_t           size,
+                                  int              timeout_ms,
+                                  std::error_code& ec)
+{
+    struct iovec iov = { const_cast<uint8_t*>(data), size };
+    return impl_->SendAll(&iov, 1, timeout_ms, ec);
+}
+
+IOResult
+IoUringStreamSocketClient::SendAll(const struct iovec* iov, int iovcnt, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+IoUringStreamSocketClient::SendAll(const struct iovec* iov,
+                                  int                 iovcnt,
+                                  int                 timeout_ms,
+                                  std::error_code&    ec)
+{
+    return impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+}
+
+IOResult
+IoUringStreamSocketClient::Recv(uint8_t* data, size_t size, int flag)
+{
+    std::error_code ec;
+    ssize_t         received = impl_->Recv(data, size, flag, ec);
+    return socket_io::ToIOResult(received, ec);
+}
+
+ssize_t
+IoUringStreamSocketClient::Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+{
+    return impl_->Recv(data, size, flag, ec);
+}
+
+void
+IoUringStreamSocketClient::Close()
+{
+    impl_->Close();
+}
+
+IOResult
+IoUringStreamSocketClient::RegisterBuffers(const struct iovec* bufs,
+                                           unsigned int        nr)
+{
+    return impl_->RegisterBuffers(bufs, nr);
+}
+
+} // namespace client
+} // namespace vhal
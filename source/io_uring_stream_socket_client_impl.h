@@ -0,0 +1,396 @@
+/**
+ * @file io_uring_stream_socket_client_impl.h
+ * @brief
+ * @version 0.1
+ * @date 2021-08-04
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef IO_URING_STREAM_SOCKET_CLIENT_IMPL_H
+#define IO_URING_STREAM_SOCKET_CLIENT_IMPL_H
+
+#include "io_uring_stream_socket_client.h"
+#include "socket_io.h"
+#include "vhal_log.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <linux/vm_sockets.h>
+#include <liburing.h>
+extern "C"
+{
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+namespace vhal {
+namespace client {
+
+class IoUringStreamSocketClient::Impl
+{
+public:
+    Impl(const std::string&   remote_server_socket_path,
+         const SocketOptions& options)
+      : options_{ options }
+    {
+        struct sockaddr_un remote = {};
+        remote.sun_family         = AF_UNIX;
+        strncpy(remote.sun_path,
+                remote_server_socket_path.c_str(),
+                sizeof(remote.sun_path) - 1);
+        SetRemote(&remote,
+                  offsetof(struct sockaddr_un, sun_path) +
+                    strlen(remote.sun_path));
+        InitRings();
+    }
+
+    Impl(const std::string&   remote_server_ip,
+         const int            port,
+         const SocketOptions& options)
+      : options_{ options }
+    {
+        struct sockaddr_in remote = {};
+        remote.sin_family         = AF_INET;
+        remote.sin_port           = htons(port);
+        inet_pton(AF_INET, remote_server_ip.c_str(), &remote.sin_addr);
+        SetRemote(&remote, sizeof(remote));
+        InitRings();
+    }
+
+    Impl(const int            android_vm_cid,
+         const unsigned int   port,
+         const SocketOptions& options)
+      : options_{ options }
+    {
+        struct sockaddr_vm remote = {};
+        remote.svm_family         = AF_VSOCK;
+        remote.svm_cid            = android_vm_cid;
+        remote.svm_port           = port;
+        SetRemote(&remote, sizeof(remote));
+        InitRings();
+    }
+
+    ~Impl()
+    {
+        Close();
+        io_uring_queue_exit(&send_ring_);
+        io_uring_queue_exit(&recv_ring_);
+    }
+
+    ConnectionResult Connect()
+    {
+        std::string error_msg = "";
+        if (fd_ >= 0) {
+            Close();
+        }
+        fd_ = ::socket(remote_.ss_family, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+        auto option_errors = socket_io::ApplySocketOptions(
+          fd_, options_, remote_.ss_family == AF_INET);
+        if (!option_errors.empty()) {
+            VHAL_LOG(kWarning)
+              << "Socket options not applied: " << option_errors;
+        }
+        std::tie(connected_, error_msg) = socket_io::Connect(
+          fd_, (struct sockaddr*)&remote_, remote_len_);
+        return { connected_, error_msg };
+    }
+
+    bool Connected() const { return connected_; }
+
+    int GetNativeSocketFd() const { return fd_; }
+
+    ssize_t Send(const uint8_t* data, size_t size, std::error_code& ec)
+    {
+        struct iovec iov = { const_cast<uint8_t*>(data), size };
+        return SendV(&iov, 1, ec);
+    }
+
+    ssize_t SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+    {
+        ssize_t sent = SubmitSendBatch(iov, iovcnt, MSG_NOSIGNAL);
+        if (sent < 0) {
+            ec = std::error_code(-sent, std::system_category());
+            VHAL_LOG(kError) << "SendV() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt;
+            return -1;
+        }
+        ec.clear();
+        return sent;
+    }
+
+    ssize_t SendAll(const struct iovec* iov,
+                    int                 iovcnt,
+                    int                 timeout_ms,
+                    std::error_code&    ec)
+    {
+        // Deadline-bounded writes need poll(); keep them on the shared path.
+        timeout_ms = socket_io::SendTimeout(timeout_ms, options_);
+        if (timeout_ms >= 0) {
+            return socket_io::SendAll(fd_, iov, iovcnt, timeout_ms, ec);
+        }
+
+        std::vector<struct iovec> left(iov, iov + iovcnt);
+        size_t                    total = 0;
+        size_t                    idx   = 0;
+        while (idx < left.size()) {
+            // MSG_WAITALL lets the kernel finish short socket writes itself,
+            // the loop below only resumes after a batch-size split.
+            ssize_t sent = SubmitSendBatch(left.data() + idx,
+                                           left.size() - idx,
+                                           MSG_NOSIGNAL | MSG_WAITALL);
+            if (sent < 0) {
+                ec = std::error_code(-sent, std::system_category());
+                VHAL_LOG(kError) << "SendAll() failed: " << ec.message()
+                                 << ", fd: " << fd_
+                                 << ", iovcnt: " << iovcnt;
+                return -1;
+            }
+            total += sent;
+            while (sent > 0 && idx < left.size()) {
+                size_t step = std::min<size_t>(sent, left[idx].iov_len);
+                left[idx].iov_base =
+                  static_cast<uint8_t*>(left[idx].iov_base) + step;
+                left[idx].iov_len -= step;
+                sent -= step;
+                if (left[idx].iov_len == 0) {
+                    idx++;
+                }
+            }
+            while (idx < left.size() && left[idx].iov_len == 0) {
+                idx++;
+            }
+        }
+        ec.clear();
+        return total;
+    }
+
+    ssize_t Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+    {
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&recv_ring_);
+        int buf_index            = FindRegisteredBuffer(data, size);
+        if (buf_index >= 0) {
+            io_uring_prep_read_fixed(sqe, fd_, data, size, 0, buf_index);
+        } else {
+            io_uring_prep_recv(sqe, fd_, data, size, flag);
+        }
+
+        int received = SubmitAndReap(&recv_ring_);
+        if (received < 0) {
+            ec = std::error_code(-received, std::system_category());
+            VHAL_LOG(kWarning) << "Recv() failed: " << ec.message()
+                               << ", fd: " << fd_
+                               << ", size: " << size;
+            return -1;
+        }
+        ec.clear();
+        return received;
+    }
+
+    void Close()
+    {
+        connected_ = false;
+        if (fd_ < 0) return;
+        shutdown(fd_, SHUT_RDWR);
+        close(fd_);
+        fd_ = -1;
+    }
+
+    IOResult RegisterBuffers(const struct iovec* bufs, unsigned int nr)
+    {
+        if (!registered_.empty()) {
+            io_uring_unregister_buffers(&send_ring_);
+            io_uring_unregister_buffers(&recv_ring_);
+            registered_.clear();
+        }
+        if (nr == 0) {
+            return { 0, "" };
+        }
+
+        int ret = io_uring_register_buffers(&send_ring_, bufs, nr);
+        if (ret == 0) {
+            ret = io_uring_register_buffers(&recv_ring_, bufs, nr);
+            if (ret < 0) {
+                io_uring_unregister_buffers(&send_ring_);
+            }
+        }
+        if (ret < 0) {
+            return { -1, std::strerror(-ret) };
+        }
+        registered_.assign(bufs, bufs + nr);
+        return { nr, "" };
+    }
+
+private:
+    // Max number of linked sends submitted with one io_uring_enter().
+    static constexpr unsigned int kQueueDepth = 64;
+
+    void SetRemote(const void* addr, socklen_t len)
+    {
+        memset(&remote_, 0, sizeof(remote_));
+        memcpy(&remote_, addr, len);
+        remote_len_ = len;
+    }
+
+    void InitRings()
+    {
+        // Separate rings so that a Recv() blocked on the talker thread never
+        // holds up Send() from the producer thread; a ring must only be
+        // driven by one thread at a time.
+        int ret = io_uring_queue_init(kQueueDepth, &send_ring_, 0);
+        if (ret < 0) {
+            throw std::system_error(-ret, std::system_category());
+        }
+        ret = io_uring_queue_init(kQueueDepth, &recv_ring_, 0);
+        if (ret < 0) {
+            io_uring_queue_exit(&send_ring_);
+            throw std::system_error(-ret, std::system_category());
+        }
+    }
+
+    int FindRegisteredBuffer(const void* data, size_t size) const
+    {
+        auto begin = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < registered_.size(); i++) {
+            auto base = static_cast<const uint8_t*>(registered_[i].iov_base);
+            if (begin >= base &&
+                begin + size <= base + registered_[i].iov_len) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Submit everything queued on ring and wait for its single completion.
+    int SubmitAndReap(struct io_uring* ring)
+    {
+        int ret;
+        do {
+            ret = io_uring_submit_and_wait(ring, 1);
+        } while (ret == -EINTR);
+        if (ret < 0) {
+            return ret;
+        }
+
+        struct io_uring_cqe* cqe = nullptr;
+        do {
+            ret = io_uring_wait_cqe(ring, &cqe);
+        } while (ret == -EINTR);
+        if (ret < 0) {
+            return ret;
+        }
+        int res = cqe->res;
+        io_uring_cqe_seen(ring, cqe);
+        return res;
+    }
+
+    /**
+     * Queue one send per buffer (up to kQueueDepth), linked so they reach
+     * the socket in order, and reap them with a single submit-and-wait.
+     * Returns the number of bytes written by the leading run of buffers that
+     * completed in full (plus a trailing short one), or -errno if the first
+     * one failed.
+     */
+    ssize_t SubmitSendBatch(const struct iovec* iov, size_t iovcnt, int flags)
+    {
+        const unsigned int n =
+          std::min<size_t>(iovcnt, kQueueDepth);
+        for (unsigned int i = 0; i < n; i++) {
+            struct io_uring_sqe* sqe = io_uring_get_sqe(&send_ring_);
+            int buf_index = FindRegisteredBuffer(iov[i].iov_base,
+                                                 iov[i].iov_len);
+            if (buf_index >= 0) {
+                io_uring_prep_write_fixed(sqe,
+                                          fd_,
+                                          iov[i].iov_base,
+                                          iov[i].iov_len,
+                                          0,
+                                          buf_index);
+            } else {
+                io_uring_prep_send(sqe,
+                                   fd_,
+                                   iov[i].iov_base,
+                                   iov[i].iov_len,
+                                   flags);
+            }
+            io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(uintptr_t(i)));
+            if (i + 1 < n) {
+                io_uring_sqe_set_flags(sqe, IOSQE_IO_LINK);
+            }
+        }
+
+        int ret;
+        do {
+            ret = io_uring_submit_and_wait(&send_ring_, n);
+        } while (ret == -EINTR);
+        if (ret < 0) {
+            return ret;
+        }
+
+        std::array<int, kQueueDepth> res;
+        for (unsigned int reaped = 0; reaped < n; reaped++) {
+            struct io_uring_cqe* cqe = nullptr;
+            do {
+                ret = io_uring_wait_cqe(&send_ring_, &cqe);
+            } while (ret == -EINTR);
+            if (ret < 0) {
+                return ret;
+            }
+            res[uintptr_t(io_uring_cqe_get_data(cqe))] = cqe->res;
+            io_uring_cqe_seen(&send_ring_, cqe);
+        }
+
+        // A short or failed send cancels the rest of the chain.
+        ssize_t sent = 0;
+        for (unsigned int i = 0; i < n; i++) {
+            if (res[i] < 0) {
+                return sent > 0 ? sent : res[i];
+            }
+            sent += res[i];
+            if (size_t(res[i]) < iov[i].iov_len) {
+                break;
+            }
+        }
+        return sent;
+    }
+
+    int  fd_        = -1;
+    bool connected_ = false;
+
+    struct sockaddr_storage remote_;
+    socklen_t               remote_len_ = 0;
+    SocketOptions           options_;
+
+    struct io_uring           send_ring_;
+    struct io_uring           recv_ring_;
+    std::vector<struct iovec> registered_;
+};
+
+} // namespace client
+} // namespace vhal
+
+#endif /* IO_URING_STREAM_SOCKET_CLIENT_IMPL_H */
@@ -0,0 +1,101 @@
+/**
+ * @file latency_histogram.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-27
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "latency_histogram.h"
+#include <algorithm>
+
+namespace vhal {
+namespace client {
+
+void
+LatencyHistogram::Record(std::chrono::nanoseconds latency)
+{
+    uint64_t ns = std::max<int64_t>(latency.count(), 0);
+    buckets_[BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max &&
+           !max_ns_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+VideoSink::LatencySummary
+LatencyHistogram::Summary() const
+{
+    // Count what is in the buckets rather than keeping a separate count,
+    // so that percentiles are taken over the same samples.
+    std::array<uint64_t, kBuckets> counts;
+    uint64_t                       count = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        count += counts[i];
+    }
+
+    VideoSink::LatencySummary summary;
+    summary.count = count;
+    if (count == 0) {
+        return summary;
+    }
+    uint64_t max = max_ns_.load(std::memory_order_relaxed);
+    auto percentile = [&](uint64_t permille) {
+        // Rank of the sample at this percentile, 1-based, rounded up.
+        uint64_t rank = (count * permille + 999) / 1000;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds(std::min(UpperBound(i), max));
+            }
+        }
+        return std::chrono::nanoseconds(max);
+    };
+    summary.p50  = percentile(500);
+    summary.p99  = percentile(990);
+    summary.max  = std::chrono::nanoseconds(max);
+    summary.mean = std::chrono::nanoseconds(
+      sum_ns_.load(std::memory_order_relaxed) / count);
+    return summary;
+}
+
+size_t
+LatencyHistogram::BucketOf(uint64_t ns)
+{
+    ns = std::min<uint64_t>(ns, (uint64_t(1) << kMaxBits) - 1);
+    if (ns < kSubBuckets) {
+        return ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    return size_t(msb - kSubBucketBits + 1) * kSubBuckets +
+           ((ns >> (msb - kSubBucketBits)) & (kSubBuckets - 1));
+}
+
+uint64_t
+LatencyHistogram::UpperBound(size_t bucket)
+{
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    int      shift = int(bucket / kSubBuckets) - 1;
+    uint64_t lower = uint64_t(kSubBuckets + bucket % kSubBuckets) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+} // namespace client
+} // namespace vhal
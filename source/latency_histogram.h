@@ -0,0 +1,69 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+/**
+ * @file latency_histogram.h
+ * @brief Lock-free latency histogram for the send path.
+ * @version 0.1
+ * @date 2021-08-27
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "video_sink.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Log-linear histogram: every power of two is split into 8 buckets,
+ * so a reported percentile is at most 12.5% above the true value, from 1 ns
+ * up to about 18 minutes; longer samples land in the last bucket. Record() is a few relaxed atomic adds and never
+ * blocks; Summary() may run concurrently and sees each sample either
+ * entirely or not at all in the percentiles.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(std::chrono::nanoseconds latency);
+
+    VideoSink::LatencySummary Summary() const;
+
+private:
+    static constexpr int    kSubBucketBits = 3;
+    static constexpr int    kSubBuckets    = 1 << kSubBucketBits;
+    static constexpr int    kMaxBits       = 40;
+    static constexpr size_t kBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    static size_t   BucketOf(uint64_t ns);
+    // Largest value that falls into bucket.
+    static uint64_t UpperBound(size_t bucket);
+
+    std::array<std::atomic<uint64_t>, kBuckets> buckets_ = {};
+    std::atomic<uint64_t>                       sum_ns_  = 0;
+    std::atomic<uint64_t>                       max_ns_  = 0;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* LATENCY_HISTOGRAM_H */
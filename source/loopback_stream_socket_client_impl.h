@@ -0,0 +1,128 @@
+/**
+ * @file loopback_stream_socket_client_impl.h
+ * @brief
+ * @version 0.1
+ * @date 2021-08-13
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef LOOPBACK_STREAM_SOCKET_CLIENT_IMPL_H
+#define LOOPBACK_STREAM_SOCKET_CLIENT_IMPL_H
+
+#include "loopback_stream_socket_client.h"
+#include "socket_io.h"
+#include "vhal_log.h"
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+extern "C"
+{
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+}
+
+namespace vhal {
+namespace client {
+
+class LoopbackStreamSocketClient::Impl
+{
+public:
+    Impl(PeerCallback on_connect, const SocketOptions& options)
+      : on_connect_{ std::move(on_connect) },
+        options_{ options }
+    {}
+    ~Impl() { Close(); }
+
+    ConnectionResult Connect()
+    {
+        if (fd_ >= 0) {
+            Close();
+        }
+        int sv[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+        fd_ = sv[0];
+        auto errors = socket_io::ApplySocketOptions(fd_, options_, false);
+        if (!errors.empty()) {
+            VHAL_LOG(kWarning) << "Socket options not applied: " << errors;
+        }
+        if (on_connect_) {
+            on_connect_(sv[1]);
+        } else {
+            close(sv[1]);
+        }
+        connected_ = true;
+        return { true, "" };
+    }
+
+    bool Connected() const { return connected_; }
+
+    int GetNativeSocketFd() const { return fd_; }
+
+    ssize_t Send(const uint8_t* data, size_t size, std::error_code& ec)
+    {
+        ssize_t sent = ::send(fd_, data, size, MSG_NOSIGNAL);
+        ec           = sent == -1 ? socket_io::LastError() : std::error_code();
+        return sent;
+    }
+
+    ssize_t SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+    {
+        struct msghdr msg = {};
+        msg.msg_iov       = const_cast<struct iovec*>(iov);
+        msg.msg_iovlen    = iovcnt;
+        ssize_t sent      = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+        ec = sent == -1 ? socket_io::LastError() : std::error_code();
+        return sent;
+    }
+
+    ssize_t SendAll(const struct iovec* iov,
+                    int                 iovcnt,
+                    int                 timeout_ms,
+                    std::error_code&    ec)
+    {
+        return socket_io::SendAll(
+          fd_, iov, iovcnt, socket_io::SendTimeout(timeout_ms, options_), ec);
+    }
+
+    ssize_t Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+    {
+        ssize_t received = ::recv(fd_, data, size, flag);
+        ec = received == -1 ? socket_io::LastError() : std::error_code();
+        return received;
+    }
+
+    void Close()
+    {
+        connected_ = false;
+        if (fd_ < 0) return;
+        shutdown(fd_, SHUT_RDWR);
+        close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    PeerCallback  on_connect_;
+    SocketOptions options_;
+    int           fd_        = -1;
+    bool          connected_ = false;
+};
+
+} // namespace client
+} // namespace vhal
+
+#endif /* LOOPBACK_STREAM_SOCKET_CLIENT_IMPL_H */
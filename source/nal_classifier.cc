@@ -0,0 +1,114 @@
+/**
+ * @file nal_classifier.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-23
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "nal_classifier.h"
+#include <cstring>
+
+namespace vhal {
+namespace client {
+
+namespace {
+
+// ITU-T H.264 Table 7-1.
+enum H264NalType : uint8_t
+{
+    kH264Slice          = 1,
+    kH264SliceDataPartA = 2,
+    kH264Idr            = 5,
+    kH264Sps            = 7,
+    kH264Pps            = 8,
+};
+
+// ITU-T H.265 Table 7-1.
+enum H265NalType : uint8_t
+{
+    kH265BlaWLp    = 16,
+    kH265RsvIrap23 = 23,
+    kH265Vps       = 32,
+    kH265Pps       = 34,
+};
+
+} // namespace
+
+const uint8_t*
+NextAnnexBNalUnit(const uint8_t* p, const uint8_t* end)
+{
+    while (end - p >= 3) {
+        auto one = static_cast<const uint8_t*>(
+          std::memchr(p + 2, 0x01, static_cast<size_t>(end - p - 2)));
+        if (one == nullptr) {
+            return end;
+        }
+        if (one[-1] == 0 && one[-2] == 0) {
+            return one + 1;
+        }
+        p = one - 1;
+    }
+    return end;
+}
+
+FrameClass
+ClassifyAnnexBFrame(VideoSink::VideoCodecType codec,
+                    const uint8_t*            data,
+                    size_t                    size)
+{
+    if (codec != VideoSink::VideoCodecType::kH264 &&
+        codec != VideoSink::VideoCodecType::kH265) {
+        return FrameClass::kOpaque;
+    }
+
+    const uint8_t* end        = data + size;
+    bool           start_code = false;
+    bool           parameters = false;
+    for (auto nal = NextAnnexBNalUnit(data, end); nal < end;
+         nal      = NextAnnexBNalUnit(nal, end)) {
+        start_code = true;
+        if (codec == VideoSink::VideoCodecType::kH264) {
+            uint8_t type    = nal[0] & 0x1f;
+            uint8_t ref_idc = (nal[0] >> 5) & 0x03;
+            if (type == kH264Idr) {
+                return FrameClass::kKeyframe;
+            }
+            if (type >= kH264Slice && type <= kH264SliceDataPartA) {
+                return ref_idc != 0 ? FrameClass::kReference
+                                    : FrameClass::kNonReference;
+            }
+            parameters |= type == kH264Sps || type == kH264Pps;
+        } else {
+            uint8_t type = (nal[0] >> 1) & 0x3f;
+            if (type >= kH265BlaWLp && type <= kH265RsvIrap23) {
+                return FrameClass::kKeyframe;
+            }
+            if (type < kH265BlaWLp) {
+                // Even types below 16 are sub-layer non-reference pictures.
+                return type % 2 == 0 ? FrameClass::kNonReference
+                                     : FrameClass::kReference;
+            }
+            parameters |= type >= kH265Vps && type <= kH265Pps;
+        }
+    }
+    if (!start_code) {
+        return FrameClass::kOpaque;
+    }
+    return parameters ? FrameClass::kParameterSets : FrameClass::kNonReference;
+}
+
+} // namespace client
+} // namespace vhal
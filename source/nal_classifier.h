@@ -0,0 +1,75 @@
+#ifndef NAL_CLASSIFIER_H
+#define NAL_CLASSIFIER_H
+/**
+ * @file nal_classifier.h
+ * @brief Tells keyframes, reference and non-reference frames of an Annex-B
+ *        H.264/H.265 stream apart.
+ * @version 0.1
+ * @date 2021-08-23
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "video_sink.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief What dropping a frame does to the decoder.
+ */
+enum class FrameClass
+{
+    // Not Annex-B H.264/H.265: nothing is known about it.
+    kOpaque,
+    // IDR (H.264) or IRAP (H.265): decoding restarts here.
+    kKeyframe,
+    // Later frames may predict from it.
+    kReference,
+    // Nothing predicts from it (nal_ref_idc 0, or a *_N picture in H.265),
+    // or it has no picture at all (SEI, AUD).
+    kNonReference,
+    // VPS/SPS/PPS without a picture: needed by the next keyframe.
+    kParameterSets,
+};
+
+/**
+ * @brief Find the next Annex-B start code. memchr() looks for its 01 byte,
+ * so the scan runs at memchr speed over slice data; a 4-byte start code is
+ * found through its last three bytes.
+ *
+ * @return First byte after the next 00 00 01 at or after p, or end.
+ */
+const uint8_t* NextAnnexBNalUnit(const uint8_t* p, const uint8_t* end);
+
+/**
+ * @brief Classify one access unit by the header of its first picture NAL
+ * unit. All slices of a picture share its type and reference flag, so the
+ * rest of the frame is not scanned.
+ *
+ * @param codec Only kH264 and kH265 are classified.
+ * @param data Annex-B access unit (00 00 01 / 00 00 00 01 start codes).
+ * @param size Size of data.
+ *
+ * @return kOpaque for other codecs and data without a start code.
+ */
+FrameClass ClassifyAnnexBFrame(VideoSink::VideoCodecType codec,
+                               const uint8_t*            data,
+                               size_t                    size);
+
+} // namespace client
+} // namespace vhal
+#endif /* NAL_CLASSIFIER_H */
@@ -1,6 +1,7 @@
 #ifndef _RECEIVER_LOG_H
 #define _RECEIVER_LOG_H
 
+#include "vhal_log.h"
 #include <cstring>
 #include <pthread.h>
 #include <stdio.h>
@@ -12,51 +13,39 @@
 namespace vhal {
 namespace client {
 
-#ifdef __android__
-#include <android/log.h>
-#endif
-
 #define LIBVHAL_INFO 1
 #define LIBVHAL_DEBUG 2
 #define LIBVHAL_WARNING 3
 #define LIBVHAL_ERROR 4
 
-#ifndef __android__
-#define AIC_LOG(level, fmt, ...)                                               \
-    do {                                                                       \
-        if (level > LIBVHAL_INFO) {                                            \
-            printf("%s %ld %s(%d): " fmt "\n",                                 \
-                   (level == 4)                                                \
-                     ? "ERR"                                                   \
-                     : ((level == 3)                                           \
-                          ? "WRN"                                              \
-                          : ((level == 2) ? "DBG" : "LIBVHAL_INFO")),          \
-                   syscall(__NR_gettid),                                       \
-                   __FUNCTION__,                                               \
-                   __LINE__,                                                   \
-                   ##__VA_ARGS__);                                             \
-            fflush(stdout);                                                    \
-        }                                                                      \
-    } while (0)
-#else
+// LIBVHAL_* to LogLevel. LIBVHAL_INFO has never been printed.
+constexpr LogLevel
+AicLogLevel(int level)
+{
+    return level == LIBVHAL_ERROR
+             ? LogLevel::kError
+             : (level == LIBVHAL_WARNING ? LogLevel::kWarning : LogLevel::kDebug);
+}
+
+// printf-style logging through the library logger, see VHAL_LOG.
 #define AIC_LOG(level, fmt, ...)                                               \
     do {                                                                       \
-        if (level > LIBVHAL_INFO) {                                            \
-            __android_log_print(                                               \
-              (level == 4)                                                     \
-                ? ANDROID_LOG_ERROR                                            \
-                : ((level == 3)                                                \
-                     ? ANDROID_LOG_WARN                                        \
-                     : ((level == 2) ? ANDROID_LOG_DEBUG : ANDROID_LOG_INFO)), \
-              LOG_TAG,                                                         \
-              "%s(%d): " fmt,                                                  \
-              __FUNCTION__,                                                    \
-              __LINE__,                                                        \
-              ##__VA_ARGS__);                                                  \
+        const auto vhal_log_level = ::vhal::client::AicLogLevel(level);        \
+        if (level > LIBVHAL_INFO &&                                            \
+            int(vhal_log_level) >= LIBVHAL_LOG_MIN_LEVEL &&                    \
+            ::vhal::client::LogEnabled(vhal_log_level)) {                      \
+            static ::vhal::client::LogSite vhal_log_site;                      \
+            if (vhal_log_site.Admit()) {                                       \
+                ::vhal::client::LogPrintf(vhal_log_level,                      \
+                                          vhal_log_site,                       \
+                                          __FUNCTION__,                        \
+                                          __LINE__,                            \
+                                          fmt,                                 \
+                                          ##__VA_ARGS__);                      \
+            }                                                                  \
         }                                                                      \
     } while (0)
-#endif
 
 } // namespace client
 } // namespace vhal
-#endif //_RECEIVER_LOG_H
\ No newline at end of file
+#endif //_RECEIVER_LOG_H
@@ -0,0 +1,186 @@
+/**
+ * @file reconnect_policy.cc
+ * @brief Backoff between connection attempts of the VHAL clients.
+ * @version 0.1
+ * @date 2021-08-10
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "reconnect_policy.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+extern "C"
+{
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/poll.h>
+#include <unistd.h>
+}
+
+using namespace std::chrono;
+
+namespace vhal {
+namespace client {
+
+namespace {
+
+// 2^kMaxShift * initial_delay is far beyond any sensible max_delay.
+constexpr uint32_t kMaxShift = 20;
+
+} // namespace
+
+ReconnectPolicy::ReconnectPolicy(const std::string& watch_path,
+                                 milliseconds       initial_delay,
+                                 milliseconds       max_delay)
+  : initial_delay_{ initial_delay },
+    max_delay_{ std::max(initial_delay, max_delay) },
+    rng_{ std::random_device{}() }
+{
+    cancel_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    auto slash = watch_path.rfind('/');
+    if (slash != std::string::npos && slash + 1 < watch_path.size()) {
+        watch_dir_  = slash == 0 ? "/" : watch_path.substr(0, slash);
+        watch_name_ = watch_path.substr(slash + 1);
+        inotify_fd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        WatchSocketDir();
+    }
+}
+
+ReconnectPolicy::~ReconnectPolicy()
+{
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+    if (cancel_fd_ >= 0) {
+        close(cancel_fd_);
+    }
+}
+
+milliseconds
+ReconnectPolicy::Backoff()
+{
+    const milliseconds cap = NextDelay();
+    failures_++;
+
+    // Equal jitter: never less than half the delay, never more than all of it.
+    std::uniform_int_distribution<milliseconds::rep> jitter(0, cap.count() / 2);
+    return cap - milliseconds(cap.count() / 2) + milliseconds(jitter(rng_));
+}
+
+int
+ReconnectPolicy::WatchFd()
+{
+    // The socket dir may not exist yet on the first attempts.
+    WatchSocketDir();
+    return watch_ >= 0 ? inotify_fd_ : -1;
+}
+
+bool
+ReconnectPolicy::WaitBeforeRetry()
+{
+    const auto deadline = steady_clock::now() + Backoff();
+    const int  watch_fd = WatchFd();
+
+    while (true) {
+        // Round up: poll() must not wake before the deadline.
+        auto left = ceil<milliseconds>(deadline - steady_clock::now());
+        if (left.count() <= 0) {
+            return true;
+        }
+        struct pollfd fds[2] = {
+            { cancel_fd_, POLLIN, 0 },
+            { watch_fd, POLLIN, 0 },
+        };
+        int ret = ::poll(fds, std::size(fds), left.count());
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return true;
+        }
+        if (fds[0].revents & POLLIN) {
+            return false;
+        }
+        if ((fds[1].revents & POLLIN) && SocketCreated()) {
+            return true;
+        }
+    }
+}
+
+void
+ReconnectPolicy::Reset()
+{
+    failures_ = 0;
+}
+
+void
+ReconnectPolicy::Cancel()
+{
+    uint64_t one = 1;
+    if (::write(cancel_fd_, &one, sizeof(one)) < 0) {
+        // Counter overflow only, it is readable already.
+    }
+}
+
+bool
+ReconnectPolicy::ShouldLog() const
+{
+    uint32_t attempt = failures_ + 1;
+    return (attempt & (attempt - 1)) == 0;
+}
+
+milliseconds
+ReconnectPolicy::NextDelay() const
+{
+    uint32_t shift = std::min(failures_, kMaxShift);
+    return std::min<milliseconds>(max_delay_, initial_delay_ * (1LL << shift));
+}
+
+void
+ReconnectPolicy::WatchSocketDir()
+{
+    if (inotify_fd_ < 0 || watch_ >= 0) {
+        return;
+    }
+    watch_ = inotify_add_watch(inotify_fd_,
+                               watch_dir_.c_str(),
+                               IN_CREATE | IN_MOVED_TO | IN_ATTRIB);
+}
+
+bool
+ReconnectPolicy::SocketCreated()
+{
+    alignas(struct inotify_event) char buf[4096];
+    bool                               created = false;
+    ssize_t                            len;
+    while ((len = ::read(inotify_fd_, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + len;) {
+            auto event = reinterpret_cast<struct inotify_event*>(p);
+            if (event->mask & IN_IGNORED) {
+                // Directory went away, watch it again next time.
+                watch_ = -1;
+            } else if (event->len > 0 && watch_name_ == event->name) {
+                created = true;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return created;
+}
+
+} // namespace client
+} // namespace vhal
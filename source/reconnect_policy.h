@@ -0,0 +1,133 @@
+#ifndef RECONNECT_POLICY_H
+#define RECONNECT_POLICY_H
+/**
+ * @file reconnect_policy.h
+ * @brief Backoff between connection attempts of the VHAL clients.
+ * @version 0.1
+ * @date 2021-08-10
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Decides how long a talker thread waits before the next Connect().
+ *
+ * Delays grow exponentially from initial_delay up to max_delay, and each one
+ * is randomized to [delay / 2, delay] so that many instances started together
+ * do not retry in lockstep.
+ *
+ * For Unix sockets, pass the socket path as watch_path: the directory is
+ * watched with inotify and the wait ends as soon as the socket file is
+ * created, so the VHAL coming up is noticed without polling.
+ *
+ * All methods but Cancel() are called from the talker thread (or event loop
+ * thread) only; Cancel() may be called from any thread.
+ */
+class ReconnectPolicy
+{
+public:
+    ReconnectPolicy(
+      const std::string&        watch_path    = "",
+      std::chrono::milliseconds initial_delay = std::chrono::milliseconds(10),
+      std::chrono::milliseconds max_delay     = std::chrono::seconds(5));
+    ~ReconnectPolicy();
+
+    ReconnectPolicy(const ReconnectPolicy&) = delete;
+    ReconnectPolicy& operator=(const ReconnectPolicy&) = delete;
+
+    /**
+     * @brief Record a failed attempt and sleep for the backoff delay.
+     *
+     * @return true The delay expired or the watched socket appeared.
+     * @return false Cancel() was called.
+     */
+    bool WaitBeforeRetry();
+
+    /**
+     * @brief Record a failed attempt and return the randomized delay, for
+     * callers that wait on an event loop instead of WaitBeforeRetry().
+     */
+    std::chrono::milliseconds Backoff();
+
+    /**
+     * @brief inotify fd to wait on next to the Backoff() delay, -1 if there
+     * is nothing to watch. Once readable, check SocketCreated().
+     */
+    int WatchFd();
+
+    /**
+     * @brief Consume pending inotify events.
+     *
+     * @return true The watched socket was (re)created.
+     */
+    bool SocketCreated();
+
+    /**
+     * @brief Start over from initial_delay, call after a successful connect.
+     */
+    void Reset();
+
+    /**
+     * @brief Wake up WaitBeforeRetry() for good, used on shutdown.
+     */
+    void Cancel();
+
+    /**
+     * @brief eventfd that turns readable once Cancel() was called, for
+     * threads that block on something else than WaitBeforeRetry().
+     */
+    int CancelFd() const { return cancel_fd_; }
+
+    /**
+     * @brief Whether the current failure is worth logging. True for the 1st,
+     * 2nd, 4th, 8th, ... consecutive failure, so a VHAL that stays away for
+     * long does not flood the log.
+     */
+    bool ShouldLog() const;
+
+    /**
+     * @brief Number of consecutive failed attempts since the last Reset().
+     */
+    uint32_t Failures() const { return failures_; }
+
+    /**
+     * @brief Delay the next WaitBeforeRetry() sleeps at most.
+     */
+    std::chrono::milliseconds NextDelay() const;
+
+private:
+    void WatchSocketDir();
+
+    std::string               watch_dir_;
+    std::string               watch_name_;
+    std::chrono::milliseconds initial_delay_;
+    std::chrono::milliseconds max_delay_;
+    uint32_t                  failures_ = 0;
+    int                       inotify_fd_ = -1;
+    int                       watch_      = -1;
+    int                       cancel_fd_  = -1;
+    std::minstd_rand          rng_;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* RECONNECT_POLICY_H */
@@ -22,6 +22,7 @@
  */
 #include "sensor_interface.h"
 #include "sensor_interface_impl.h"
+#include "unix_seqpacket_socket_client.h"
 #include "unix_stream_socket_client.h"
 #include <functional>
 #include <memory>
@@ -47,9 +48,27 @@ SensorInterface::SensorInterface(UnixConnectionInfo unix_conn_info)
     }
 
     //Creating interface to communicate to VHAL via libvhal
-    auto unix_sock_client =
-      make_unique<UnixStreamSocketClient>(move(sockPath));
-    impl_ = std::make_unique<Impl>(std::move(unix_sock_client));
+    std::unique_ptr<IStreamSocketClient> unix_sock_client;
+    if (unix_conn_info.seqpacket) {
+        unix_sock_client = make_unique<UnixSeqpacketSocketClient>(
+          sockPath, unix_conn_info.socket_options);
+    } else {
+        unix_sock_client = make_unique<UnixStreamSocketClient>(
+          sockPath, unix_conn_info.socket_options);
+    }
+    impl_ = std::make_unique<Impl>(
+      std::move(unix_sock_client), unix_conn_info.event_loop, sockPath);
+}
+
+SensorInterface::SensorInterface(
+  std::unique_ptr<IStreamSocketClient> socket_client,
+  std::shared_ptr<EventLoop>           event_loop)
+{
+    if (!socket_client) {
+        throw std::invalid_argument("Please set a valid socket_client");
+    }
+    impl_ = std::make_unique<Impl>(std::move(socket_client),
+                                   std::move(event_loop));
 }
 
 SensorInterface::~SensorInterface() {}
@@ -64,6 +83,12 @@ IOResult SensorInterface::SendDataPacket(const SensorDataPacket *event)
     return impl_->SendDataPacket(event);
 }
 
+ssize_t SensorInterface::SendDataPacket(const SensorDataPacket* event,
+                                        std::error_code&        ec)
+{
+    return impl_->SendDataPacket(event, ec);
+}
+
 uint64_t SensorInterface::GetSupportedSensorList()
 {
     return impl_->GetSupportedSensorList();
@@ -23,12 +23,15 @@
  *
  */
 
+#include "framed_reader.h"
+#include "socket_io.h"
 #include "istream_socket_client.h"
+#include "vhal_log.h"
+#include "vhal_talker.h"
 #include "sensor_interface.h"
 #include <atomic>
 #include <chrono>
 #include <functional>
-#include <iostream>
 #include <memory>
 #include <cstring>
 #include <string>
@@ -37,6 +40,7 @@ extern "C"
 {
 #include <sys/poll.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 }
 #include <thread>
@@ -51,80 +55,19 @@ namespace client {
 class SensorInterface::Impl
 {
 public:
-    Impl(unique_ptr<IStreamSocketClient> socket_client)
-      : socket_client_{ move(socket_client) }
+    Impl(unique_ptr<IStreamSocketClient> socket_client,
+         std::shared_ptr<EventLoop>      event_loop = nullptr,
+         const std::string&              watch_path = "")
+      : socket_client_{ move(socket_client) },
+        reader_{ *socket_client_ },
+        talker_{ TalkerOps(), move(event_loop), watch_path }
     {
-        vhal_talker_thread_ = thread([this]() {
-            while (should_continue_) {
-                if (not socket_client_->Connected()) {
-                    if (auto [connected, error_msg] = socket_client_->Connect();
-                        !connected) {
-                        cout << "SensorInterface Failed to connect to VHal: "
-                             << error_msg
-                             << ". Retry after 3ms...\n";
-                        this_thread::sleep_for(3ms);
-                        continue;
-                    }
-                }
-                // connected ...
-                cout << "Connected to Sensor VHal!\n";
-
-                struct pollfd fds[1];
-                const int     timeout_ms = 1 * 1000; // 1 sec timeout
-                int           ret;
-
-                // watch socket for input
-                fds[0].fd     = socket_client_->GetNativeSocketFd();
-                fds[0].events = POLLIN;
-
-                do {
-                    ret = poll(fds, std::size(fds), timeout_ms);
-                    if (ret == -1) {
-                        throw system_error(errno, system_category());
-                    }
-                    if (!ret) {
-                        continue;
-                    }
-                    if (fds[0].revents & POLLIN) {
-                        cout << "Sensor VHal has some message for us!\n";
-
-                        SensorInterface::CtrlPacket ctrl_msg;
-
-                        if (auto [received, recv_err_msg] =
-                              socket_client_->Recv(
-                                reinterpret_cast<uint8_t*>(&ctrl_msg),
-                                sizeof(ctrl_msg));
-                            received != sizeof(SensorInterface::CtrlPacket)) {
-                            cout << "Failed to read message from SensorInterface: "
-                                 << recv_err_msg
-                                 << ", going to disconnect and reconnect.\n";
-                            socket_client_->Close();
-                            break;
-                        }
-
-                        if (IsValidCtrlPacket(ctrl_msg.type)) {
-                            // success, invoke client callback
-                            callback_(cref(ctrl_msg));
-                        }
-                    } else {
-                        if (fds[0].revents & (POLLERR|POLLHUP)) {
-                            cout << "SensorInterface Poll Fail event: "
-                                << fds[0].revents
-                                << ", reconnect\n";
-                            socket_client_->Close();
-                            break;
-                        }
-                        cout << "SensorInterface : Poll revents " << fds[0].revents << "\n";
-                    }
-                } while (should_continue_);
-            }
-        });
+        talker_.Start();
     }
 
     ~Impl()
     {
-        should_continue_ = false;
-        vhal_talker_thread_.join();
+        talker_.Stop();
     }
 
     bool RegisterCallback(SensorCallback callback)
@@ -134,12 +77,27 @@ public:
     }
 
     IOResult SendDataPacket(const SensorDataPacket *event)
+    {
+        std::error_code ec;
+        ssize_t         sent = SendDataPacket(event, ec);
+        if (ec == std::errc::not_connected) {
+            return {0, "VHAL Not connected"};
+        }
+        if (ec == std::errc::not_supported) {
+            return {-1, "Sensor Type not supported"};
+        }
+        return socket_io::ToIOResult(sent, ec);
+    }
+
+    ssize_t SendDataPacket(const SensorDataPacket *event, std::error_code& ec)
     {
         vhal_sensor_event_t sensor_event;
         int dataCount = 0;
 
-        if (not socket_client_->Connected())
-            return {0, "VHAL Not connected"};
+        if (not socket_client_->Connected()) {
+            ec = std::make_error_code(std::errc::not_connected);
+            return 0;
+        }
 
         switch (event->type) {
             case SENSOR_TYPE_ACCELEROMETER:
@@ -161,9 +119,10 @@ public:
                 break;
 
             default:
-                cout << "LibVHAL[Sensor]: Sensor type %d not supported."
-                        "Dropping data event." << event->type << endl;
-                return {-1, "Sensor Type not supported"};
+                VHAL_LOG(kError) << "Sensor type " << event->type
+                                 << " not supported, dropping data event.";
+                ec = std::make_error_code(std::errc::not_supported);
+                return -1;
         }
 
         int32_t dataHeaderLen = sizeof(vhal_sensor_event_t) - sizeof(sensor_event.fdata);
@@ -172,16 +131,18 @@ public:
         sensor_event.type = event->type;
         sensor_event.fdataCount = dataCount;
         sensor_event.timestamp_ns = event->timestamp_ns;
-        uint8_t dataPtr[totalPayloadLen];
-        std::memmove(dataPtr, &sensor_event, dataHeaderLen);
-        std::memmove((dataPtr + dataHeaderLen), event->fdata, dataPayLoadLen);
-        if (auto [sent, error_msg] =
-                socket_client_->Send(dataPtr, totalPayloadLen); sent == -1) {
-            return { sent, error_msg };
+        // Event header and sensor values are gathered by sendmsg(), no need
+        // to pack them into an intermediate buffer.
+        struct iovec iov[2] = {
+            { &sensor_event, static_cast<size_t>(dataHeaderLen) },
+            { const_cast<float*>(event->fdata), static_cast<size_t>(dataPayLoadLen) },
+        };
+        if (socket_client_->SendAll(iov, std::size(iov), -1, ec) == -1) {
+            return -1;
         }
 
         // success
-        return { totalPayloadLen, "" };
+        return totalPayloadLen;
     }
 
     bool IsValidCtrlPacket(int32_t SensorType)
@@ -217,8 +178,64 @@ public:
 private:
     SensorCallback                  callback_ = nullptr;
     unique_ptr<IStreamSocketClient> socket_client_;
-    thread                          vhal_talker_thread_;
-    atomic<bool>                    should_continue_ = true;
+    FramedReader                    reader_;
+
+    // Declared last: its callbacks use every member above.
+    VhalTalker talker_;
+
+    VhalTalker::Ops TalkerOps()
+    {
+        VhalTalker::Ops ops;
+        ops.connect   = [this]() { return socket_client_->Connect(); };
+        ops.connected = [this]() { return socket_client_->Connected(); };
+        ops.fd        = [this]() { return socket_client_->GetNativeSocketFd(); };
+        ops.close     = [this]() { socket_client_->Close(); };
+        ops.on_connected = [this]() {
+            VHAL_LOG(kInfo) << "Connected to Sensor VHal!";
+            reader_.Reset();
+        };
+        ops.on_connect_failed = [](const std::string& error_msg,
+                                   std::chrono::milliseconds retry_in) {
+            VHAL_LOG(kWarning)
+              << "SensorInterface Failed to connect to VHal: " << error_msg
+              << ". Retry in " << retry_in.count() << "ms...";
+        };
+        ops.on_event = [this](short revents) { return OnVhalEvent(revents); };
+        return ops;
+    }
+
+    // Handle poll() events of the VHal socket, false to reconnect.
+    bool OnVhalEvent(short revents)
+    {
+        if (revents & POLLIN) {
+            VHAL_LOG(kDebug) << "Sensor VHal has some message for us!";
+
+            if (auto [received, recv_err_msg] = reader_.Fill(); received <= 0) {
+                VHAL_LOG(kError)
+                  << "Failed to read message from SensorInterface: "
+                                 << recv_err_msg
+                                 << ", going to disconnect and reconnect.";
+                return false;
+            }
+
+            SensorInterface::CtrlPacket ctrl_msg;
+            while (reader_.Next(ctrl_msg)) {
+                if (IsValidCtrlPacket(ctrl_msg.type)) {
+                    // success, invoke client callback
+                    callback_(cref(ctrl_msg));
+                }
+            }
+        } else {
+            if (revents & (POLLERR|POLLHUP)) {
+                VHAL_LOG(kError) << "SensorInterface Poll Fail event: "
+                                 << revents
+                                 << ", reconnect";
+                return false;
+            }
+            VHAL_LOG(kDebug) << "SensorInterface : Poll revents " << revents;
+        }
+        return true;
+    }
 };
 
 } // namespace client
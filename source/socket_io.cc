@@ -0,0 +1,361 @@
+/**
+ * @file socket_io.cc
+ * @brief Socket helpers shared by the stream socket client implementations.
+ * @version 0.1
+ * @date 2021-08-02
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "socket_io.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <vector>
+extern "C"
+{
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/poll.h>
+#include <sys/socket.h>
+}
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+using namespace std::chrono;
+
+namespace vhal {
+namespace client {
+namespace socket_io {
+
+namespace {
+
+// Vectors up to this size are copied on the stack, larger ones on the heap.
+constexpr int kInlineIovecs = 16;
+
+#ifndef IOV_MAX
+constexpr int kIovMax = 1024;
+#else
+constexpr int kIovMax = IOV_MAX;
+#endif
+
+} // namespace
+
+std::string
+ApplySocketOptions(int fd, const SocketOptions& options, bool tcp)
+{
+    std::string errors;
+    auto        set = [fd, &errors](int level, int name, int value, const char* what) {
+        if (::setsockopt(fd, level, name, &value, sizeof(value)) < 0) {
+            errors += std::string(errors.empty() ? "" : ", ") + what + ": " +
+                      std::strerror(errno);
+        }
+    };
+
+    if (options.send_buffer_size > 0) {
+        set(SOL_SOCKET, SO_SNDBUF, options.send_buffer_size, "SO_SNDBUF");
+    }
+    if (options.recv_buffer_size > 0) {
+        set(SOL_SOCKET, SO_RCVBUF, options.recv_buffer_size, "SO_RCVBUF");
+    }
+    if (options.priority >= 0) {
+        set(SOL_SOCKET, SO_PRIORITY, options.priority, "SO_PRIORITY");
+    }
+    if (options.busy_poll_us > 0) {
+        set(SOL_SOCKET, SO_BUSY_POLL, options.busy_poll_us, "SO_BUSY_POLL");
+    }
+    if (options.send_timeout_ms >= 0) {
+        struct timeval tv = { options.send_timeout_ms / 1000,
+                              (options.send_timeout_ms % 1000) * 1000 };
+        if (::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
+            errors += std::string(errors.empty() ? "" : ", ") +
+                      "SO_SNDTIMEO: " + std::strerror(errno);
+        }
+    }
+    if (tcp && options.tcp_nodelay) {
+        set(IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+    }
+    if (tcp && options.tcp_quickack) {
+        set(IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+    }
+    return errors;
+}
+
+void
+RearmQuickAck(int fd)
+{
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+}
+
+ConnectionResult
+Connect(int fd, const struct sockaddr* addr, socklen_t addr_len, int timeout_ms)
+{
+    int fl = ::fcntl(fd, F_GETFL);
+    if (fl < 0 || ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0) {
+        return { false, std::strerror(errno) };
+    }
+
+    int err = 0;
+    if (::connect(fd, addr, addr_len) < 0) {
+        err = errno;
+    }
+    if (err == EINPROGRESS || err == EINTR) {
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        int           ready;
+        do {
+            ready = ::poll(&pfd, 1, timeout_ms);
+        } while (ready < 0 && errno == EINTR);
+        if (ready < 0) {
+            err = errno;
+        } else if (ready == 0) {
+            err = ETIMEDOUT;
+        } else {
+            socklen_t len = sizeof(err);
+            if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+                err = errno;
+            }
+        }
+    }
+
+    ::fcntl(fd, F_SETFL, fl);
+    if (err != 0) {
+        return { false, std::strerror(err) };
+    }
+    return { true, "" };
+}
+
+ssize_t
+SendAll(int                 fd,
+        const struct iovec* iov,
+        int                 iovcnt,
+        int                 timeout_ms,
+        std::error_code&    ec,
+        int                 flags,
+        size_t*             calls)
+{
+    ec.clear();
+    // sendmsg() may stop anywhere, so work on a copy we can advance.
+    struct iovec              inline_iov[kInlineIovecs];
+    std::vector<struct iovec> heap_iov;
+    struct iovec*             cur = inline_iov;
+    if (iovcnt > kInlineIovecs) {
+        heap_iov.assign(iov, iov + iovcnt);
+        cur = heap_iov.data();
+    } else {
+        std::copy(iov, iov + iovcnt, inline_iov);
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+    }
+
+    const bool bounded  = timeout_ms >= 0;
+    const auto deadline = steady_clock::now() + milliseconds(timeout_ms);
+    const int  send_flags =
+      flags | MSG_NOSIGNAL | (bounded ? MSG_DONTWAIT : 0);
+
+    size_t sent = 0;
+    int    idx  = 0;
+    if (calls) {
+        *calls = 0;
+    }
+    while (sent < total) {
+        // Skip exhausted (or empty) entries.
+        while (idx < iovcnt && cur[idx].iov_len == 0) {
+            idx++;
+        }
+
+        struct msghdr msg = {};
+        msg.msg_iov       = cur + idx;
+        msg.msg_iovlen    = std::min(iovcnt - idx, kIovMax);
+
+        ssize_t ret = ::sendmsg(fd, &msg, send_flags);
+        if (ret < 0 && errno == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+            // Too many unread completions, fall back to a copy.
+            ret = ::sendmsg(fd, &msg, send_flags & ~MSG_ZEROCOPY);
+        } else if (ret >= 0 && calls) {
+            (*calls)++;
+        }
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ec = LastError();
+                return -1;
+            }
+            // Socket buffer is full, wait until it drains.
+            int wait_ms = -1;
+            if (bounded) {
+                auto left = duration_cast<milliseconds>(deadline -
+                                                        steady_clock::now());
+                wait_ms   = std::max<int>(0, left.count());
+            }
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            int           ready = ::poll(&pfd, 1, wait_ms);
+            if (ready < 0 && errno != EINTR) {
+                ec = LastError();
+                return -1;
+            }
+            if (ready == 0) {
+                ec = std::make_error_code(std::errc::timed_out);
+                return -1;
+            }
+            continue;
+        }
+
+        sent += ret;
+        // Advance past what the kernel accepted.
+        size_t consumed = ret;
+        while (consumed > 0) {
+            size_t step = std::min(consumed, cur[idx].iov_len);
+            cur[idx].iov_base =
+              static_cast<uint8_t*>(cur[idx].iov_base) + step;
+            cur[idx].iov_len -= step;
+            consumed -= step;
+            if (cur[idx].iov_len == 0) {
+                idx++;
+            }
+        }
+    }
+    return sent;
+}
+
+IOResult
+SendAll(int                 fd,
+        const struct iovec* iov,
+        int                 iovcnt,
+        int                 timeout_ms,
+        int                 flags,
+        size_t*             calls)
+{
+    std::error_code ec;
+    ssize_t         sent = SendAll(fd, iov, iovcnt, timeout_ms, ec, flags, calls);
+    return ToIOResult(sent, ec);
+}
+
+IOResult
+SendWithFd(int                 fd,
+           const struct iovec* iov,
+           int                 iovcnt,
+           int                 passed_fd,
+           int                 timeout_ms)
+{
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+    }
+
+    union
+    {
+        char           buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control = {};
+
+    struct msghdr msg  = {};
+    msg.msg_iov        = const_cast<struct iovec*>(iov);
+    msg.msg_iovlen     = std::min(iovcnt, kIovMax);
+    msg.msg_control    = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level     = SOL_SOCKET;
+    cm->cmsg_type      = SCM_RIGHTS;
+    cm->cmsg_len       = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cm), &passed_fd, sizeof(int));
+
+    ssize_t ret;
+    do {
+        ret = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        return { -1, std::strerror(errno) };
+    }
+    if (size_t(ret) == total) {
+        return { ret, "" };
+    }
+
+    // The descriptor went with the first byte; write the remainder as is.
+    std::vector<struct iovec> rest;
+    size_t                    skip = ret;
+    for (int i = 0; i < iovcnt; i++) {
+        if (skip >= iov[i].iov_len) {
+            skip -= iov[i].iov_len;
+            continue;
+        }
+        rest.push_back({ static_cast<uint8_t*>(iov[i].iov_base) + skip,
+                         iov[i].iov_len - skip });
+        skip = 0;
+    }
+    auto [sent, error_msg] =
+      SendAll(fd, rest.data(), rest.size(), timeout_ms);
+    if (sent < 0) {
+        return { -1, error_msg };
+    }
+    return { total, "" };
+}
+
+int
+ReadZeroCopyCompletions(
+  int fd, const std::function<void(uint32_t lo, uint32_t hi)>& on_complete)
+{
+    int count = 0;
+    while (true) {
+        char          control[128];
+        struct msghdr msg  = {};
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? count : -1;
+        }
+
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr;
+             cm                 = CMSG_NXTHDR(&msg, cm)) {
+            bool recverr = (cm->cmsg_level == SOL_IP &&
+                            cm->cmsg_type == IP_RECVERR) ||
+                           (cm->cmsg_level == SOL_IPV6 &&
+                            cm->cmsg_type == IPV6_RECVERR);
+            if (!recverr) {
+                continue;
+            }
+            auto serr =
+              reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+            if (serr->ee_errno != 0 ||
+                serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            // ee_code may carry SO_EE_CODE_ZEROCOPY_COPIED when the kernel
+            // had to copy anyway; the buffer is released either way.
+            on_complete(serr->ee_info, serr->ee_data);
+            count++;
+        }
+    }
+}
+
+} // namespace socket_io
+} // namespace client
+} // namespace vhal
@@ -0,0 +1,166 @@
+#ifndef SOCKET_IO_H
+#define SOCKET_IO_H
+/**
+ * @file socket_io.h
+ * @brief Socket helpers shared by the stream socket client implementations.
+ * @version 0.1
+ * @date 2021-08-02
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "libvhal_common.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <system_error>
+#include <tuple>
+extern "C"
+{
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+}
+
+namespace vhal {
+namespace client {
+namespace socket_io {
+
+// Upper bound for establishing a connection to a VHAL server.
+constexpr int kConnectTimeoutMs = 1000;
+
+/**
+ * @brief connect() fd to addr without blocking for longer than timeout_ms.
+ *
+ * The connect is issued in non-blocking mode and completion is awaited with
+ * poll(), after which fd is switched back to blocking mode. A VHAL that is
+ * not up yet therefore costs one syscall pair instead of a stalled thread.
+ *
+ * @return { true, "" } when connected, { false, error msg } otherwise.
+ */
+ConnectionResult Connect(int                    fd,
+                         const struct sockaddr* addr,
+                         socklen_t              addr_len,
+                         int                    timeout_ms = kConnectTimeoutMs);
+
+/**
+ * @brief Apply options to fd. TCP-only options are skipped unless tcp is
+ * set.
+ *
+ * @return "" on success, otherwise a description of every option the kernel
+ *         rejected. Rejected options are not fatal.
+ */
+std::string ApplySocketOptions(int fd, const SocketOptions& options, bool tcp);
+
+/**
+ * @brief Re-arm TCP_QUICKACK, which the kernel turns off by itself.
+ */
+void RearmQuickAck(int fd);
+
+/**
+ * @brief SendAll() deadline: timeout_ms if given (>= 0), else the
+ * send_timeout_ms of options.
+ */
+inline int
+SendTimeout(int timeout_ms, const SocketOptions& options)
+{
+    return timeout_ms >= 0 ? timeout_ms : options.send_timeout_ms;
+}
+
+/**
+ * @brief Write every byte of iov to fd.
+ *
+ * Short writes, EINTR and EAGAIN are retried. With timeout_ms < 0 the call
+ * blocks until all data is written. With timeout_ms >= 0 every write is
+ * issued with MSG_DONTWAIT and poll() waits for POLLOUT within whatever is
+ * left of the deadline, so a stalled peer can never block the caller longer
+ * than timeout_ms.
+ *
+ * SIGPIPE is suppressed; a vanished peer is reported as EPIPE instead.
+ *
+ * flags are OR'ed into every sendmsg() call. With MSG_ZEROCOPY, a chunk the
+ * kernel rejects with ENOBUFS (notification backlog over optmem) is resent
+ * as a regular copy. If calls is set it receives the number of sendmsg()
+ * calls that succeeded with all of flags applied, which is the number of
+ * zero-copy ids the call consumed.
+ *
+ * @return Total bytes on success.
+ * @return -1 on failure, with ec set; std::errc::timed_out when the deadline
+ *         expired. If that happened after part of the data was written, the
+ *         stream framing is broken and the caller should reconnect.
+ */
+ssize_t SendAll(int                 fd,
+                const struct iovec* iov,
+                int                 iovcnt,
+                int                 timeout_ms,
+                std::error_code&    ec,
+                int                 flags = 0,
+                size_t*             calls = nullptr);
+
+/**
+ * @brief SendAll() reporting { bytes, "" } or { -1, error msg }.
+ */
+IOResult SendAll(int                 fd,
+                 const struct iovec* iov,
+                 int                 iovcnt,
+                 int                 timeout_ms,
+                 int                 flags = 0,
+                 size_t*             calls = nullptr);
+
+/**
+ * @brief errno as a std::error_code; no allocation, the message is only
+ * formatted if somebody asks for it.
+ */
+inline std::error_code
+LastError()
+{
+    return std::error_code(errno, std::system_category());
+}
+
+/**
+ * @brief Adapt an error_code result to IOResult.
+ */
+inline IOResult
+ToIOResult(ssize_t result, const std::error_code& ec)
+{
+    return { result, ec ? ec.message() : std::string() };
+}
+
+/**
+ * @brief Like SendAll(), but passes passed_fd to the peer as SCM_RIGHTS
+ * ancillary data. The descriptor is attached to the first sendmsg() call,
+ * whatever it leaves unsent is written with SendAll(). fd must be a Unix
+ * domain socket.
+ */
+IOResult SendWithFd(int                 fd,
+                    const struct iovec* iov,
+                    int                 iovcnt,
+                    int                 passed_fd,
+                    int                 timeout_ms = -1);
+
+/**
+ * @brief Drain MSG_ZEROCOPY completion notifications from the error queue of
+ * fd without blocking.
+ *
+ * @param on_complete Called for every notification with the inclusive range
+ *        [lo, hi] of completed send ids.
+ * @return Number of notifications read, -1 on error.
+ */
+int ReadZeroCopyCompletions(
+  int fd, const std::function<void(uint32_t lo, uint32_t hi)>& on_complete);
+
+} // namespace socket_io
+} // namespace client
+} // namespace vhal
+#endif /* SOCKET_IO_H */
@@ -0,0 +1,103 @@
+/**
+ * @file stream_mux.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-19
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "stream_mux.h"
+#include "video_sink.h"
+#include <algorithm>
+#include <iterator>
+
+namespace vhal {
+namespace client {
+
+StreamMux::StreamMux(SendFn send, size_t chunk_size)
+  : send_{ std::move(send) }
+  , chunk_size_{ std::max<size_t>(chunk_size, 1) }
+{}
+
+bool
+StreamMux::Register(uint32_t camera_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cameras_.insert(camera_id).second;
+}
+
+void
+StreamMux::Unregister(uint32_t camera_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cameras_.erase(camera_id);
+}
+
+ssize_t
+StreamMux::SendFrame(uint32_t         camera_id,
+                     const uint8_t*   frame,
+                     size_t           size,
+                     std::error_code& ec)
+{
+    if (size > UINT32_MAX) {
+        ec = std::make_error_code(std::errc::message_size);
+        return -1;
+    }
+
+    size_t offset = 0;
+    do {
+        size_t chunk = std::min(size - offset, chunk_size_);
+        VideoSink::camera_header_t header = {
+            VideoSink::camera_packet_type_t::CAMERA_STREAM_DATA,
+            static_cast<uint32_t>(sizeof(VideoSink::camera_stream_chunk_t) +
+                                  chunk)
+        };
+        VideoSink::camera_stream_chunk_t chunk_header = {
+            camera_id,
+            static_cast<uint32_t>(size),
+            static_cast<uint32_t>(offset),
+            0
+        };
+        struct iovec iov[3] = {
+            { &header, sizeof(header) },
+            { &chunk_header, sizeof(chunk_header) },
+            { const_cast<uint8_t*>(frame) + offset, chunk },
+        };
+
+        // Wait for our turn; the ticket goes to the back of the line again
+        // for the next chunk.
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t                     ticket = next_ticket_++;
+        tickets_.push_back(ticket);
+        turn_.wait(lock, [this, ticket]() { return tickets_.front() == ticket; });
+        lock.unlock();
+
+        ssize_t sent = send_(iov, std::size(iov), ec);
+
+        lock.lock();
+        tickets_.pop_front();
+        turn_.notify_all();
+        if (sent == -1) {
+            return -1;
+        }
+        offset += chunk;
+    } while (offset < size);
+
+    ec.clear();
+    return size;
+}
+
+} // namespace client
+} // namespace vhal
@@ -0,0 +1,98 @@
+#ifndef STREAM_MUX_H
+#define STREAM_MUX_H
+/**
+ * @file stream_mux.h
+ * @brief Interleaves the frames of several camera streams on one socket.
+ * @version 0.1
+ * @date 2021-08-19
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <system_error>
+extern "C"
+{
+#include <sys/types.h>
+#include <sys/uio.h>
+}
+
+namespace vhal {
+namespace client {
+
+/**
+ * @brief Cuts frames into CAMERA_STREAM_DATA chunks and lets concurrent
+ * senders write them in turns.
+ *
+ * Every chunk takes a ticket at the back of one FIFO, so senders with work
+ * pending get one chunk each per round: round robin with an equal byte
+ * quantum per turn. A 1 MB frame of one camera thus delays a small frame
+ * of another camera by at most one chunk rather than by the whole frame.
+ */
+class StreamMux
+{
+public:
+    /**
+     * @brief Writes one message completely, -1 with ec set on failure.
+     */
+    using SendFn = std::function<
+      ssize_t(const struct iovec* iov, int iovcnt, std::error_code& ec)>;
+
+    StreamMux(SendFn send, size_t chunk_size);
+
+    StreamMux(const StreamMux&) = delete;
+    StreamMux& operator=(const StreamMux&) = delete;
+
+    /**
+     * @brief Claim camera_id for one stream.
+     *
+     * @return false camera_id is taken.
+     */
+    bool Register(uint32_t camera_id);
+
+    void Unregister(uint32_t camera_id);
+
+    /**
+     * @brief Send a whole frame of camera_id, chunk by chunk, taking turns
+     * with the other senders.
+     *
+     * @return size, or -1 with ec set. The frame is abandoned at the first
+     *         failed chunk; the send function is expected to reset the
+     *         connection, which tells the VHAL to drop the partial frame.
+     */
+    ssize_t SendFrame(uint32_t         camera_id,
+                      const uint8_t*   frame,
+                      size_t           size,
+                      std::error_code& ec);
+
+private:
+    const SendFn send_;
+    const size_t chunk_size_;
+
+    std::mutex              mutex_;
+    std::condition_variable turn_;
+    std::deque<uint64_t>    tickets_;
+    uint64_t                next_ticket_ = 0;
+    std::set<uint32_t>      cameras_;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* STREAM_MUX_H */
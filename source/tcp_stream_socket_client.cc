@@ -27,8 +27,9 @@
 namespace vhal {
 namespace client {
 TcpStreamSocketClient::TcpStreamSocketClient(
-    const std::string& remote_server_ip,const int port)
-    : impl_{ std::make_unique<Impl>(remote_server_ip,port) }
+    const std::string& remote_server_ip,const int port,
+    const SocketOptions& options)
+    : impl_{ std::make_unique<Impl>(remote_server_ip,port,options) }
 {}
 
 TcpStreamSocketClient::~TcpStreamSocketClient() = default;
@@ -54,13 +55,78 @@ TcpStreamSocketClient::GetNativeSocketFd() const
 IOResult
 TcpStreamSocketClient::Send(const uint8_t* data, size_t size)
 {
-    return impl_->Send(data, size);
+    std::error_code ec;
+    ssize_t         sent = impl_->Send(data, size, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+TcpStreamSocketClient::Send(const uint8_t* data, size_t size, std::error_code& ec)
+{
+    return impl_->Send(data, size, ec);
 }
 
 IOResult
-TcpStreamSocketClient::Recv(uint8_t* data, size_t size, uint8_t flag)
+TcpStreamSocketClient::SendV(const struct iovec* iov, int iovcnt)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendV(iov, iovcnt, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+TcpStreamSocketClient::SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+{
+    return impl_->SendV(iov, iovcnt, ec);
+}
+
+IOResult
+TcpStreamSocketClient::SendAll(const uint8_t* data, size_t size, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = SendAll(data, size, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+TcpStreamSocketClient::SendAll(const uint8_t*   data,
+                              size_t           size,
+                              int              timeout_ms,
+                              std::error_code& ec)
 {
-    return impl_->Recv(data, size);
+    struct iovec iov = { const_cast<uint8_t*>(data), size };
+    return impl_->SendAll(&iov, 1, timeout_ms, ec);
+}
+
+IOResult
+TcpStreamSocketClient::SendAll(const struct iovec* iov, int iovcnt, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+TcpStreamSocketClient::SendAll(const struct iovec* iov,
+                              int                 iovcnt,
+                              int                 timeout_ms,
+                              std::error_code&    ec)
+{
+    return impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+}
+
+IOResult
+TcpStreamSocketClient::Recv(uint8_t* data, size_t size, int flag)
+{
+    std::error_code ec;
+    ssize_t         received = impl_->Recv(data, size, flag, ec);
+    return socket_io::ToIOResult(received, ec);
+}
+
+ssize_t
+TcpStreamSocketClient::Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+{
+    return impl_->Recv(data, size, flag, ec);
 }
 
 void
@@ -69,5 +135,49 @@ TcpStreamSocketClient::Close()
     impl_->Close();
 }
 
+bool
+TcpStreamSocketClient::EnableZeroCopy()
+{
+    return impl_->EnableZeroCopy();
+}
+
+bool
+TcpStreamSocketClient::ZeroCopyEnabled() const
+{
+    return impl_->ZeroCopyEnabled();
+}
+
+uint32_t
+TcpStreamSocketClient::NextZeroCopyId() const
+{
+    return impl_->NextZeroCopyId();
+}
+
+IOResult
+TcpStreamSocketClient::SendAllZeroCopy(const struct iovec* iov,
+                                       int                 iovcnt,
+                                       int                 timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendAllZeroCopy(iov, iovcnt, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+TcpStreamSocketClient::SendAllZeroCopy(const struct iovec* iov,
+                                       int                 iovcnt,
+                                       int                 timeout_ms,
+                                       std::error_code&    ec)
+{
+    return impl_->SendAllZeroCopy(iov, iovcnt, timeout_ms, ec);
+}
+
+int
+TcpStreamSocketClient::ReadZeroCopyCompletions(
+  const std::function<void(uint32_t lo, uint32_t hi)>& on_complete)
+{
+    return impl_->ReadZeroCopyCompletions(on_complete);
+}
+
 } // namespace client
 } // namespace vhal
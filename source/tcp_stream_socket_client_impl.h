@@ -2,6 +2,8 @@
 #define TCP_STREAM_SOCKET_CLIENT_IMPL_H
 
 #include "tcp_stream_socket_client.h"
+#include "socket_io.h"
+#include "vhal_log.h"
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
@@ -16,13 +18,23 @@ extern "C"
 #include <unistd.h>
 }
 
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
 namespace vhal {
 namespace client {
 
 class TcpStreamSocketClient::Impl
 {
 public:
-    Impl(const std::string& remote_server_ip, const int port)
+    Impl(const std::string&   remote_server_ip,
+         const int            port,
+         const SocketOptions& options)
+      : options_{ options }
     {
         tcp_sock_addr_.sin_family = AF_INET;
         tcp_sock_addr_.sin_port = htons(port);
@@ -40,10 +52,11 @@ public:
         if (fd_ < 0) {
             throw std::system_error(errno, std::system_category());
         }
-        connected_ = ::connect(fd_, (struct sockaddr*)&tcp_sock_addr_, sizeof(struct sockaddr_in)) == 0;
-        if (!connected_) {
-            error_msg = std::strerror(errno);
-        }
+        ApplyOptions();
+        next_zerocopy_id_ = 0;
+        zerocopy_ = zerocopy_requested_ && ApplyZeroCopy();
+        std::tie(connected_, error_msg) = socket_io::Connect(
+          fd_, (struct sockaddr*)&tcp_sock_addr_, sizeof(struct sockaddr_in));
         return { connected_, error_msg };
     }
 
@@ -51,37 +64,131 @@ public:
 
     int GetNativeSocketFd() const { return fd_; }
 
-    IOResult Send(const uint8_t* data, size_t size)
+    ssize_t Send(const uint8_t* data, size_t size, std::error_code& ec)
     {
-        std::string error_msg = "";
+        ssize_t sent = ::send(fd_, data, size, 0);
+        if (sent == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kError) << "Send() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", size: " << size;
+        } else {
+            ec.clear();
+        }
+        return sent;
+    }
 
-        ssize_t sent;
-        if ((sent = ::send(fd_, data, size, 0)) == -1) {
-            std::cout << ". Send() args: fd: " << fd_ << ", data: " << data
-                      << ", size: " << size << "\n";
-            error_msg = std::strerror(errno);
+    ssize_t SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+    {
+        struct msghdr msg = {};
+        msg.msg_iov    = const_cast<struct iovec*>(iov);
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t sent = ::sendmsg(fd_, &msg, 0);
+        if (sent == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kError) << "SendV() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt;
+        } else {
+            ec.clear();
         }
-        return { sent, error_msg };
+        return sent;
     }
 
-    IOResult Recv(uint8_t* data, size_t size)
+    ssize_t SendAll(const struct iovec* iov,
+                    int                 iovcnt,
+                    int                 timeout_ms,
+                    std::error_code&    ec)
     {
-        std::string error_msg = "";
+        timeout_ms   = socket_io::SendTimeout(timeout_ms, options_);
+        ssize_t sent = socket_io::SendAll(fd_, iov, iovcnt, timeout_ms, ec);
+        if (sent == -1) {
+            VHAL_LOG(kError) << "SendAll() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt
+                             << ", timeout_ms: " << timeout_ms;
+        }
+        return sent;
+    }
+
+    // Waits for all of size, unless flag has MSG_DONTWAIT: then returns
+    // whatever is queued. On failure, returns the bytes received so far with
+    // ec set.
+    ssize_t Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+    {
+        ec.clear();
         ssize_t left = size;
         while (left > 0 ) {
-            ssize_t received = ::recv(fd_,data, left,0);
+            ssize_t received = ::recv(fd_,data, left,flag);
+            if (received < 0 && (flag & MSG_DONTWAIT) &&
+                (errno == EAGAIN || errno == EWOULDBLOCK) &&
+                size_t(left) < size) {
+                break;
+            }
             if (received <= 0) {
-                std::cout << ". Recv() args: fd: " << fd_ << ", data: " << data
-                      << ", size: " << size << "\n";
-                error_msg = std::strerror(errno);
+                ec = received == 0
+                       ? std::make_error_code(std::errc::connection_reset)
+                       : socket_io::LastError();
+                VHAL_LOG(kWarning) << "Recv() failed: " << ec.message()
+                                   << ", fd: " << fd_
+                                   << ", size: " << size;
                 break;
             }
             else {
+                if (options_.tcp_quickack) {
+                    socket_io::RearmQuickAck(fd_);
+                }
                 data += received;
                 left -= received;
             }
         }
-        return { size-left, error_msg };
+        return size-left;
+    }
+
+    bool EnableZeroCopy()
+    {
+        zerocopy_requested_ = true;
+        if (fd_ < 0) {
+            return true;
+        }
+        zerocopy_ = ApplyZeroCopy();
+        return zerocopy_;
+    }
+
+    bool ZeroCopyEnabled() const { return zerocopy_; }
+
+    uint32_t NextZeroCopyId() const { return next_zerocopy_id_; }
+
+    ssize_t SendAllZeroCopy(const struct iovec* iov,
+                            int                 iovcnt,
+                            int                 timeout_ms,
+                            std::error_code&    ec)
+    {
+        if (!zerocopy_) {
+            return SendAll(iov, iovcnt, timeout_ms, ec);
+        }
+        size_t  calls = 0;
+        timeout_ms    = socket_io::SendTimeout(timeout_ms, options_);
+        ssize_t sent  = socket_io::SendAll(
+          fd_, iov, iovcnt, timeout_ms, ec, MSG_ZEROCOPY, &calls);
+        // Every successful MSG_ZEROCOPY sendmsg() consumes one id.
+        next_zerocopy_id_ += calls;
+        if (sent == -1) {
+            VHAL_LOG(kError) << "SendAllZeroCopy() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt;
+        }
+        return sent;
+    }
+
+    int ReadZeroCopyCompletions(
+      const std::function<void(uint32_t lo, uint32_t hi)>& on_complete)
+    {
+        if (fd_ < 0) {
+            return 0;
+        }
+        return socket_io::ReadZeroCopyCompletions(fd_, on_complete);
     }
 
     void Close() {
@@ -93,9 +200,28 @@ public:
     }
 
 private:
+    void ApplyOptions()
+    {
+        auto errors = socket_io::ApplySocketOptions(fd_, options_, true);
+        if (!errors.empty()) {
+            VHAL_LOG(kWarning) << "Socket options not applied: " << errors;
+        }
+    }
+
+    bool ApplyZeroCopy()
+    {
+        int one = 1;
+        return ::setsockopt(fd_, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+    }
+
     int  fd_ = -1;
     bool connected_ = false;
     struct sockaddr_in tcp_sock_addr_;
+    SocketOptions      options_;
+
+    bool     zerocopy_requested_ = false;
+    bool     zerocopy_           = false;
+    uint32_t next_zerocopy_id_   = 0;
 };
 
 } // namespace client
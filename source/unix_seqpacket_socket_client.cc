@@ -0,0 +1,143 @@
+/**
+ * @file unix_seqpacket_socket_client.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-16
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "unix_seqpacket_socket_client.h"
+#include "unix_seqpacket_socket_client_impl.h"
+
+namespace vhal {
+namespace client {
+UnixSeqpacketSocketClient::UnixSeqpacketSocketClient(
+  const std::string&   remote_server_path,
+  const SocketOptions& options)
+  : impl_{ std::make_unique<Impl>(remote_server_path, options) }
+{}
+
+UnixSeqpacketSocketClient::~UnixSeqpacketSocketClient() = default;
+
+ConnectionResult
+UnixSeqpacketSocketClient::Connect()
+{
+    return impl_->Connect();
+}
+
+bool
+UnixSeqpacketSocketClient::Connected() const
+{
+    return impl_->Connected();
+}
+
+int
+UnixSeqpacketSocketClient::GetNativeSocketFd() const
+{
+    return impl_->GetNativeSocketFd();
+}
+
+IOResult
+UnixSeqpacketSocketClient::Send(const uint8_t* data, size_t size)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->Send(data, size, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+UnixSeqpacketSocketClient::Send(const uint8_t* data, size_t size, std::error_code& ec)
+{
+    return impl_->Send(data, size, ec);
+}
+
+IOResult
+UnixSeqpacketSocketClient::SendV(const struct iovec* iov, int iovcnt)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendV(iov, iovcnt, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+UnixSeqpacketSocketClient::SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+{
+    return impl_->SendV(iov, iovcnt, ec);
+}
+
+IOResult
+UnixSeqpacketSocketClient::SendAll(const uint8_t* data, size_t size, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = SendAll(data, size, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+UnixSeqpacketSocketClient::SendAll(const uint8_t*   data,
+                                   size_t           size,
+                                   int              timeout_ms,
+                                   std::error_code& ec)
+{
+    struct iovec iov = { const_cast<uint8_t*>(data), size };
+    return impl_->SendAll(&iov, 1, timeout_ms, ec);
+}
+
+IOResult
+UnixSeqpacketSocketClient::SendAll(const struct iovec* iov, int iovcnt, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+UnixSeqpacketSocketClient::SendAll(const struct iovec* iov,
+                                   int                 iovcnt,
+                                   int                 timeout_ms,
+                                   std::error_code&    ec)
+{
+    return impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+}
+
+IOResult
+UnixSeqpacketSocketClient::Recv(uint8_t* data, size_t size, int flag)
+{
+    std::error_code ec;
+    ssize_t         received = impl_->Recv(data, size, flag, ec);
+    return socket_io::ToIOResult(received, ec);
+}
+
+ssize_t
+UnixSeqpacketSocketClient::Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+{
+    return impl_->Recv(data, size, flag, ec);
+}
+
+IOResult
+UnixSeqpacketSocketClient::SendFd(const struct iovec* iov, int iovcnt, int fd)
+{
+    return impl_->SendFd(iov, iovcnt, fd);
+}
+
+void
+UnixSeqpacketSocketClient::Close()
+{
+    impl_->Close();
+}
+
+} // namespace client
+} // namespace vhal
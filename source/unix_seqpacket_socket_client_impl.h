@@ -0,0 +1,181 @@
+/**
+ * @file unix_seqpacket_socket_client_impl.h
+ * @brief
+ * @version 0.1
+ * @date 2021-08-16
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef UNIX_SEQPACKET_SOCKET_CLIENT_IMPL_H
+#define UNIX_SEQPACKET_SOCKET_CLIENT_IMPL_H
+
+#include "unix_seqpacket_socket_client.h"
+#include "socket_io.h"
+#include "vhal_log.h"
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+extern "C"
+{
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+namespace vhal {
+namespace client {
+
+class UnixSeqpacketSocketClient::Impl
+{
+public:
+    Impl(const std::string&   remote_server_socket_path,
+         const SocketOptions& options)
+      : options_{ options }
+    {
+        remote_.sun_family = AF_UNIX;
+        strncpy(remote_.sun_path,
+                remote_server_socket_path.c_str(),
+                sizeof(remote_.sun_path) - 1);
+    }
+    ~Impl() { Close(); }
+
+    ConnectionResult Connect()
+    {
+        std::string error_msg = "";
+        auto        len = strlen(remote_.sun_path) + sizeof(remote_.sun_family);
+        if (fd_ >= 0) {
+            Close();
+        }
+        fd_ = ::socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+        ApplyOptions();
+        std::tie(connected_, error_msg) =
+          socket_io::Connect(fd_, (struct sockaddr*)&remote_, len);
+        return { connected_, error_msg };
+    }
+
+    bool Connected() const { return connected_; }
+
+    int GetNativeSocketFd() const { return fd_; }
+
+    ssize_t Send(const uint8_t* data, size_t size, std::error_code& ec)
+    {
+        struct iovec iov = { const_cast<uint8_t*>(data), size };
+        return SendV(&iov, 1, ec);
+    }
+
+    ssize_t SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+    {
+        struct msghdr msg = {};
+        msg.msg_iov    = const_cast<struct iovec*>(iov);
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t sent = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+        if (sent == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kError) << "SendV() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt;
+        } else {
+            ec.clear();
+        }
+        return sent;
+    }
+
+    // A SOCK_SEQPACKET sendmsg() writes the whole message or nothing, so
+    // SendAll() only adds the EINTR/EAGAIN retries and the deadline.
+    ssize_t SendAll(const struct iovec* iov,
+                    int                 iovcnt,
+                    int                 timeout_ms,
+                    std::error_code&    ec)
+    {
+        timeout_ms   = socket_io::SendTimeout(timeout_ms, options_);
+        ssize_t sent = socket_io::SendAll(fd_, iov, iovcnt, timeout_ms, ec);
+        if (sent == -1) {
+            VHAL_LOG(kError) << "SendAll() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt
+                             << ", timeout_ms: " << timeout_ms;
+        }
+        return sent;
+    }
+
+    IOResult SendFd(const struct iovec* iov, int iovcnt, int fd)
+    {
+        auto result = socket_io::SendWithFd(fd_, iov, iovcnt, fd);
+        if (std::get<0>(result) == -1) {
+            VHAL_LOG(kError) << "SendFd() failed: " << std::get<1>(result)
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt << ", passed fd: " << fd;
+        }
+        return result;
+    }
+
+    ssize_t Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+    {
+        struct iovec  iov = { data, size };
+        struct msghdr msg = {};
+        msg.msg_iov    = &iov;
+        msg.msg_iovlen = 1;
+
+        ssize_t received = ::recvmsg(fd_, &msg, flag);
+        if (received == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kWarning) << "Recv() failed: " << ec.message()
+                               << ", fd: " << fd_
+                               << ", size: " << size;
+        } else if (msg.msg_flags & MSG_TRUNC) {
+            // The rest of the message is gone; do not hand out half of it.
+            ec = std::make_error_code(std::errc::message_size);
+            VHAL_LOG(kError) << "Recv() message truncated, fd: " << fd_
+                             << ", size: " << size;
+            received = -1;
+        } else {
+            ec.clear();
+        }
+        return received;
+    }
+
+    void Close() {
+        connected_ = false;
+        if (fd_ < 0) return;
+        shutdown(fd_, SHUT_RDWR);
+        close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    void ApplyOptions()
+    {
+        auto errors = socket_io::ApplySocketOptions(fd_, options_, false);
+        if (!errors.empty()) {
+            VHAL_LOG(kWarning) << "Socket options not applied: " << errors;
+        }
+    }
+
+    int  fd_ = -1;
+    bool connected_ = false;
+
+    struct sockaddr_un remote_ = {};
+    SocketOptions      options_;
+};
+
+} // namespace client
+} // namespace vhal
+
+#endif /* UNIX_SEQPACKET_SOCKET_CLIENT_IMPL_H */
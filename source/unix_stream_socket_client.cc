@@ -26,8 +26,9 @@
 namespace vhal {
 namespace client {
 UnixStreamSocketClient::UnixStreamSocketClient(
-  const std::string& remote_server_path)
-  : impl_{ std::make_unique<Impl>(remote_server_path) }
+  const std::string&   remote_server_path,
+  const SocketOptions& options)
+  : impl_{ std::make_unique<Impl>(remote_server_path, options) }
 {}
 
 UnixStreamSocketClient::~UnixStreamSocketClient() = default;
@@ -53,13 +54,84 @@ UnixStreamSocketClient::GetNativeSocketFd() const
 IOResult
 UnixStreamSocketClient::Send(const uint8_t* data, size_t size)
 {
-    return impl_->Send(data, size);
+    std::error_code ec;
+    ssize_t         sent = impl_->Send(data, size, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+UnixStreamSocketClient::Send(const uint8_t* data, size_t size, std::error_code& ec)
+{
+    return impl_->Send(data, size, ec);
+}
+
+IOResult
+UnixStreamSocketClient::SendV(const struct iovec* iov, int iovcnt)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendV(iov, iovcnt, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+UnixStreamSocketClient::SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+{
+    return impl_->SendV(iov, iovcnt, ec);
+}
+
+IOResult
+UnixStreamSocketClient::SendAll(const uint8_t* data, size_t size, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = SendAll(data, size, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+UnixStreamSocketClient::SendAll(const uint8_t*   data,
+                               size_t           size,
+                               int              timeout_ms,
+                               std::error_code& ec)
+{
+    struct iovec iov = { const_cast<uint8_t*>(data), size };
+    return impl_->SendAll(&iov, 1, timeout_ms, ec);
+}
+
+IOResult
+UnixStreamSocketClient::SendAll(const struct iovec* iov, int iovcnt, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+UnixStreamSocketClient::SendAll(const struct iovec* iov,
+                               int                 iovcnt,
+                               int                 timeout_ms,
+                               std::error_code&    ec)
+{
+    return impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+}
+
+IOResult
+UnixStreamSocketClient::Recv(uint8_t* data, size_t size, int flag)
+{
+    std::error_code ec;
+    ssize_t         received = impl_->Recv(data, size, flag, ec);
+    return socket_io::ToIOResult(received, ec);
+}
+
+ssize_t
+UnixStreamSocketClient::Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+{
+    return impl_->Recv(data, size, flag, ec);
 }
 
 IOResult
-UnixStreamSocketClient::Recv(uint8_t* data, size_t size, uint8_t flag)
+UnixStreamSocketClient::SendFd(const struct iovec* iov, int iovcnt, int fd)
 {
-    return impl_->Recv(data, size);
+    return impl_->SendFd(iov, iovcnt, fd);
 }
 
 void
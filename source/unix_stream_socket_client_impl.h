@@ -23,6 +23,8 @@
 #define UNIX_STREAM_SOCKET_CLIENT_IMPL_H
 
 #include "unix_stream_socket_client.h"
+#include "socket_io.h"
+#include "vhal_log.h"
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
@@ -41,7 +43,9 @@ namespace client {
 class UnixStreamSocketClient::Impl
 {
 public:
-    Impl(const std::string& remote_server_socket_path)
+    Impl(const std::string&   remote_server_socket_path,
+         const SocketOptions& options)
+      : options_{ options }
     {
         remote_.sun_family = AF_UNIX;
         strcpy(remote_.sun_path, remote_server_socket_path.c_str());
@@ -59,12 +63,11 @@ public:
         if (fd_ < 0) {
             throw std::system_error(errno, std::system_category());
         }
-        connected_ = ::connect(fd_, (struct sockaddr*)&remote_, len) == 0;
-        if (!connected_) {
-            std::cout << "Connect() failed args: fd: " << fd_
-                      << ", remote server path: " << remote_.sun_path;
-            error_msg = std::strerror(errno);
-        }
+        ApplyOptions();
+        // Failures are expected while the VHAL is down; the caller decides
+        // whether they are worth logging.
+        std::tie(connected_, error_msg) =
+          socket_io::Connect(fd_, (struct sockaddr*)&remote_, len);
         return { connected_, error_msg };
     }
 
@@ -72,30 +75,77 @@ public:
 
     int GetNativeSocketFd() const { return fd_; }
 
-    IOResult Send(const uint8_t* data, size_t size)
+    ssize_t Send(const uint8_t* data, size_t size, std::error_code& ec)
     {
-        std::string error_msg = "";
+        ssize_t sent = ::send(fd_, data, size, 0);
+        if (sent == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kError) << "Send() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", size: " << size;
+        } else {
+            ec.clear();
+        }
+        return sent;
+    }
 
-        ssize_t sent;
-        if ((sent = ::send(fd_, data, size, 0)) == -1) {
-            std::cout << ". Send() args: fd: " << fd_ << ", data: " << data
-                      << ", size: " << size << "\n";
-            error_msg = std::strerror(errno);
+    ssize_t SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+    {
+        struct msghdr msg = {};
+        msg.msg_iov    = const_cast<struct iovec*>(iov);
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t sent = ::sendmsg(fd_, &msg, 0);
+        if (sent == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kError) << "SendV() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt;
+        } else {
+            ec.clear();
         }
-        return { sent, error_msg };
+        return sent;
     }
 
-    IOResult Recv(uint8_t* data, size_t size)
+    ssize_t SendAll(const struct iovec* iov,
+                    int                 iovcnt,
+                    int                 timeout_ms,
+                    std::error_code&    ec)
     {
-        std::string error_msg = "";
+        timeout_ms   = socket_io::SendTimeout(timeout_ms, options_);
+        ssize_t sent = socket_io::SendAll(fd_, iov, iovcnt, timeout_ms, ec);
+        if (sent == -1) {
+            VHAL_LOG(kError) << "SendAll() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt
+                             << ", timeout_ms: " << timeout_ms;
+        }
+        return sent;
+    }
 
-        ssize_t received;
-        if ((received = ::recv(fd_, data, size, 0)) == -1) {
-            std::cout << ". Recv() args: fd: " << fd_ << ", data: " << data
-                      << ", size: " << size << "\n";
-            error_msg = std::strerror(errno);
+    IOResult SendFd(const struct iovec* iov, int iovcnt, int fd)
+    {
+        auto result = socket_io::SendWithFd(fd_, iov, iovcnt, fd);
+        if (std::get<0>(result) == -1) {
+            VHAL_LOG(kError) << "SendFd() failed: " << std::get<1>(result)
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt << ", passed fd: " << fd;
+        }
+        return result;
+    }
+
+    ssize_t Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+    {
+        ssize_t received = ::recv(fd_, data, size, flag);
+        if (received == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kWarning) << "Recv() failed: " << ec.message()
+                               << ", fd: " << fd_
+                               << ", size: " << size;
+        } else {
+            ec.clear();
         }
-        return { received, error_msg };
+        return received;
     }
 
     void Close() {
@@ -107,11 +157,20 @@ public:
     }
 
 private:
+    void ApplyOptions()
+    {
+        auto errors = socket_io::ApplySocketOptions(fd_, options_, false);
+        if (!errors.empty()) {
+            VHAL_LOG(kWarning) << "Socket options not applied: " << errors;
+        }
+    }
+
     int  fd_ = -1;
     bool connected_ = false;
 
     struct sockaddr_un remote_;
     std::string        remote_server_socket_path_;
+    SocketOptions      options_;
 };
 
 } // namespace client
@@ -0,0 +1,337 @@
+/**
+ * @file vhal_log.cc
+ * @brief The logger behind VHAL_LOG and AIC_LOG.
+ * @version 0.1
+ * @date 2021-09-01
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "vhal_log.h"
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+}
+#ifdef __android__
+#include <android/log.h>
+#endif
+
+namespace vhal {
+namespace client {
+
+namespace {
+
+// Bounded multi-producer queue (Vyukov): a push or pop claims a cell with
+// one CAS and never waits for another thread.
+class LogRing
+{
+public:
+    explicit LogRing(size_t capacity) : cells_(capacity), mask_{ capacity - 1 }
+    {
+        for (size_t i = 0; i < capacity; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool Push(LogRecord&& record)
+    {
+        size_t pos = enqueue_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell&    cell = cells_[pos & mask_];
+            size_t   seq  = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (enqueue_.compare_exchange_weak(
+                      pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.record = std::move(record);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Single consumer: the drain thread.
+    bool Pop(LogRecord& record)
+    {
+        size_t pos  = dequeue_;
+        Cell&  cell = cells_[pos & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        record = std::move(cell.record);
+        dequeue_++;
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        LogRecord           record;
+    };
+
+    std::vector<Cell>   cells_;
+    const size_t        mask_;
+    std::atomic<size_t> enqueue_ = 0;
+    size_t              dequeue_ = 0;
+};
+
+void
+DefaultSink(const LogRecord& record)
+{
+    std::string suppressed;
+    if (record.suppressed > 0) {
+        suppressed = " (" + std::to_string(record.suppressed) +
+                     " similar messages suppressed)";
+    }
+#ifdef __android__
+    static const int kPriorities[] = { ANDROID_LOG_DEBUG,
+                                       ANDROID_LOG_INFO,
+                                       ANDROID_LOG_WARN,
+                                       ANDROID_LOG_ERROR };
+    __android_log_print(kPriorities[int(record.level)],
+                        "libvhal",
+                        "%s(%d): %s%s",
+                        record.function,
+                        record.line,
+                        record.message.c_str(),
+                        suppressed.c_str());
+#else
+    static const char* const kTags[] = { "DBG", "INF", "WRN", "ERR" };
+    printf("%s %d %s(%d): %s%s\n",
+           kTags[int(record.level)],
+           record.thread_id,
+           record.function,
+           record.line,
+           record.message.c_str(),
+           suppressed.c_str());
+    fflush(stdout);
+#endif
+}
+
+// The drain thread runs until the process exits. The logger is never
+// destroyed, so objects that log from static destructors are safe.
+class Logger
+{
+public:
+    static Logger& Get()
+    {
+        static Logger* logger = new Logger;
+        return *logger;
+    }
+
+    void Submit(LogRecord&& record)
+    {
+        if (!ring_.Push(std::move(record))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pushed_.fetch_add(1);
+        if (sleeping_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_.notify_one();
+        }
+    }
+
+    void Flush()
+    {
+        uint64_t                     target = pushed_.load();
+        std::unique_lock<std::mutex> lock(mutex_);
+        drained_.wait(lock, [&]() { return delivered_ >= target; });
+    }
+
+    void SetSink(LogSink sink)
+    {
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        sink_ = sink ? std::move(sink) : DefaultSink;
+    }
+
+    std::atomic<int>      level_      = int(LogLevel::kInfo);
+    std::atomic<uint32_t> rate_limit_ = 20;
+    std::atomic<uint64_t> dropped_    = 0;
+
+private:
+    static constexpr size_t kCapacity = 4096;
+
+    Logger() : ring_{ kCapacity }, sink_{ DefaultSink }
+    {
+        std::thread([this]() { Drain(); }).detach();
+        // Whatever is still in the ring at exit() gets written.
+        std::atexit([]() { Get().Flush(); });
+    }
+
+    void Drain()
+    {
+        LogRecord record;
+        for (;;) {
+            uint64_t delivered = 0;
+            {
+                std::lock_guard<std::mutex> lock(sink_mutex_);
+                while (ring_.Pop(record)) {
+                    sink_(record);
+                    delivered++;
+                }
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            delivered_ += delivered;
+            drained_.notify_all();
+            // A producer either sees sleeping_ and wakes us, or its push
+            // is counted here already.
+            sleeping_ = true;
+            if (pushed_.load() <= delivered_) {
+                wake_.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            sleeping_ = false;
+        }
+    }
+
+    LogRing           ring_;
+    std::atomic<bool> sleeping_ = false;
+    // Counted by producers, and by the drain thread under mutex_.
+    std::atomic<uint64_t>   pushed_    = 0;
+    uint64_t                delivered_ = 0;
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    std::mutex              sink_mutex_;
+    LogSink                 sink_;
+};
+
+int32_t
+ThreadId()
+{
+    static thread_local int32_t tid = int32_t(syscall(SYS_gettid));
+    return tid;
+}
+
+} // namespace
+
+bool
+LogEnabled(LogLevel level)
+{
+    return int(level) >= Logger::Get().level_.load(std::memory_order_relaxed);
+}
+
+bool
+LogSite::Admit()
+{
+    uint32_t limit = Logger::Get().rate_limit_.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return true;
+    }
+    // The coarse clock is a plain memory read, no syscall.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    int64_t window = window_.load(std::memory_order_relaxed);
+    if (window != now.tv_sec &&
+        window_.compare_exchange_strong(window, now.tv_sec)) {
+        count_.store(0, std::memory_order_relaxed);
+    }
+    if (count_.fetch_add(1, std::memory_order_relaxed) < limit) {
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+LogLine::LogLine(LogLevel level, LogSite& site, const char* function, int line)
+{
+    record_.level      = level;
+    record_.function   = function;
+    record_.line       = line;
+    record_.suppressed = site.TakeSuppressed();
+}
+
+LogLine::~LogLine()
+{
+    record_.message = stream_.str();
+    // Trailing newlines of messages written for std::cout.
+    while (!record_.message.empty() && record_.message.back() == '\n') {
+        record_.message.pop_back();
+    }
+    record_.time      = std::chrono::system_clock::now();
+    record_.thread_id = ThreadId();
+    Logger::Get().Submit(std::move(record_));
+}
+
+void
+LogPrintf(LogLevel    level,
+          LogSite&    site,
+          const char* function,
+          int         line,
+          const char* format,
+          ...)
+{
+    char    buffer[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    LogLine(level, site, function, line).stream() << buffer;
+}
+
+void
+Log::SetLevel(LogLevel level)
+{
+    Logger::Get().level_ = int(level);
+}
+
+LogLevel
+Log::GetLevel()
+{
+    return LogLevel(Logger::Get().level_.load());
+}
+
+void
+Log::SetRateLimit(uint32_t per_second)
+{
+    Logger::Get().rate_limit_ = per_second;
+}
+
+void
+Log::SetSink(LogSink sink)
+{
+    Logger::Get().SetSink(std::move(sink));
+}
+
+void
+Log::Flush()
+{
+    Logger::Get().Flush();
+}
+
+uint64_t
+Log::Dropped()
+{
+    return Logger::Get().dropped_.load(std::memory_order_relaxed);
+}
+
+} // namespace client
+} // namespace vhal
@@ -0,0 +1,113 @@
+#ifndef VHAL_LOG_H
+#define VHAL_LOG_H
+/**
+ * @file vhal_log.h
+ * @brief VHAL_LOG, the library's logging statement.
+ * @version 0.1
+ * @date 2021-09-01
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "libvhal_log.h"
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+
+// Levels below this (0 kDebug .. 3 kError) are compiled out, see the
+// LIBVHAL_LOG_MIN_LEVEL build option.
+#ifndef LIBVHAL_LOG_MIN_LEVEL
+#define LIBVHAL_LOG_MIN_LEVEL 0
+#endif
+
+/**
+ * Log a message streamed into it, e.g.
+ *
+ *     VHAL_LOG(kWarning) << "Socket options not applied: " << errors;
+ *
+ * Nothing after VHAL_LOG() is evaluated unless the message is logged. Each
+ * call site has its own rate limit, see Log::SetRateLimit().
+ */
+#define VHAL_LOG(severity)                                                     \
+    if (int(::vhal::client::LogLevel::severity) < LIBVHAL_LOG_MIN_LEVEL ||     \
+        !::vhal::client::LogEnabled(::vhal::client::LogLevel::severity)) {     \
+    } else if (static ::vhal::client::LogSite vhal_log_site;                   \
+               !vhal_log_site.Admit()) {                                       \
+    } else                                                                     \
+        ::vhal::client::LogLine(::vhal::client::LogLevel::severity,            \
+                                vhal_log_site,                                 \
+                                __FUNCTION__,                                  \
+                                __LINE__)                                      \
+          .stream()
+
+namespace vhal {
+namespace client {
+
+// Whether level passes Log::SetLevel().
+bool LogEnabled(LogLevel level);
+
+/**
+ * @brief Rate limit state of one VHAL_LOG() call site: at most
+ * Log::SetRateLimit() messages per second, counting what it refuses.
+ */
+class LogSite
+{
+public:
+    bool Admit();
+
+    // Messages refused since the last one admitted.
+    uint64_t TakeSuppressed()
+    {
+        return suppressed_.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t>  window_     = -1;
+    std::atomic<uint32_t> count_      = 0;
+    std::atomic<uint64_t> suppressed_ = 0;
+};
+
+/**
+ * @brief The message of one VHAL_LOG() statement, handed to the logger
+ * when the statement ends.
+ */
+class LogLine
+{
+public:
+    LogLine(LogLevel level, LogSite& site, const char* function, int line);
+    ~LogLine();
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    std::ostream& stream() { return stream_; }
+
+private:
+    LogRecord          record_;
+    std::ostringstream stream_;
+};
+
+/**
+ * @brief printf flavour of VHAL_LOG(), for AIC_LOG.
+ */
+void LogPrintf(LogLevel    level,
+               LogSite&    site,
+               const char* function,
+               int         line,
+               const char* format,
+               ...) __attribute__((format(printf, 5, 6)));
+
+} // namespace client
+} // namespace vhal
+#endif /* VHAL_LOG_H */
@@ -0,0 +1,211 @@
+/**
+ * @file vhal_talker.cc
+ * @brief Connection driver shared by the VHAL client objects.
+ * @version 0.1
+ * @date 2021-08-11
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "vhal_talker.h"
+#include "event_loop_impl.h"
+#include <cerrno>
+#include <system_error>
+extern "C"
+{
+#include <sys/poll.h>
+}
+
+using namespace std::chrono;
+
+namespace vhal {
+namespace client {
+
+VhalTalker::VhalTalker(Ops                        ops,
+                       std::shared_ptr<EventLoop> event_loop,
+                       const std::string&         watch_path)
+  : ops_{ std::move(ops) },
+    reconnect_{ watch_path },
+    event_loop_{ std::move(event_loop) }
+{}
+
+VhalTalker::~VhalTalker()
+{
+    Stop();
+}
+
+void
+VhalTalker::Start()
+{
+    if (running_.exchange(true)) {
+        return;
+    }
+    if (!event_loop_) {
+        thread_ = std::thread([this]() { Run(); });
+        return;
+    }
+    worker_ = event_loop_->impl_->Acquire();
+    worker_->Post([this]() { TryConnect(); });
+}
+
+void
+VhalTalker::Stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (!event_loop_) {
+        reconnect_.Cancel();
+        thread_.join();
+        return;
+    }
+    // Tasks run in order, so the TryConnect() posted by Start() is done by
+    // now; everything else we schedule is a timer or a watch.
+    worker_->RunSync([this]() {
+        stopped_ = true;
+        worker_->CancelTimer(retry_timer_);
+        Unwatch(socket_watch_);
+        Unwatch(dir_watch_);
+    });
+    event_loop_->impl_->Release(worker_);
+}
+
+void
+VhalTalker::Run()
+{
+    while (running_) {
+        if (!ops_.connected()) {
+            auto [connected, error_msg] = ops_.connect();
+            if (!connected) {
+                if (reconnect_.ShouldLog()) {
+                    ops_.on_connect_failed(error_msg, reconnect_.NextDelay());
+                }
+                if (!reconnect_.WaitBeforeRetry()) {
+                    break;
+                }
+                continue;
+            }
+            reconnect_.Reset();
+            ops_.on_connected();
+        }
+
+        struct pollfd fds[2];
+        const int     timeout_ms = 1 * 1000; // 1 sec timeout
+
+        // watch socket for input, and for Stop()
+        fds[0].fd     = ops_.fd();
+        fds[0].events = POLLIN;
+        fds[1].fd     = reconnect_.CancelFd();
+        fds[1].events = POLLIN;
+
+        int ret = poll(fds, std::size(fds), timeout_ms);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::system_category());
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (!fds[0].revents) {
+            continue;
+        }
+        if (!ops_.on_event(fds[0].revents)) {
+            ops_.close();
+        }
+    }
+}
+
+void
+VhalTalker::TryConnect()
+{
+    if (stopped_) {
+        return;
+    }
+    // Note: connect() is bounded by socket_io::kConnectTimeoutMs, which is
+    // only reached for remote TCP endpoints.
+    auto [connected, error_msg] = ops_.connect();
+    if (!connected) {
+        if (reconnect_.ShouldLog()) {
+            ops_.on_connect_failed(error_msg, reconnect_.NextDelay());
+        }
+        ScheduleRetry();
+        return;
+    }
+    reconnect_.Reset();
+    Unwatch(dir_watch_);
+    ops_.on_connected();
+
+    socket_watch_ = worker_->Watch(
+      ops_.fd(), EPOLLIN, [this](uint32_t events) { OnSocketEvent(events); });
+    if (socket_watch_ == 0) {
+        ops_.close();
+        ScheduleRetry();
+    }
+}
+
+void
+VhalTalker::ScheduleRetry()
+{
+    Retry(reconnect_.Backoff());
+    int fd = reconnect_.WatchFd();
+    if (fd >= 0 && dir_watch_ == 0) {
+        dir_watch_ =
+          worker_->Watch(fd, EPOLLIN, [this](uint32_t) { OnWatchEvent(); });
+    }
+}
+
+void
+VhalTalker::Retry(milliseconds delay)
+{
+    worker_->CancelTimer(retry_timer_);
+    retry_timer_ = worker_->RunAfter(delay, [this]() {
+        retry_timer_ = 0;
+        TryConnect();
+    });
+}
+
+void
+VhalTalker::OnSocketEvent(uint32_t events)
+{
+    // EPOLLIN/ERR/HUP share their values with the poll() flags.
+    if (ops_.on_event(static_cast<short>(events))) {
+        return;
+    }
+    Unwatch(socket_watch_);
+    ops_.close();
+    // Reconnect right away, like the threaded loop does.
+    Retry(milliseconds(0));
+}
+
+void
+VhalTalker::OnWatchEvent()
+{
+    if (reconnect_.SocketCreated()) {
+        Retry(milliseconds(0));
+    }
+}
+
+void
+VhalTalker::Unwatch(uint64_t& watch)
+{
+    if (watch != 0) {
+        worker_->Unwatch(watch);
+        watch = 0;
+    }
+}
+
+} // namespace client
+} // namespace vhal
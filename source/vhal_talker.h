@@ -0,0 +1,115 @@
+#ifndef VHAL_TALKER_H
+#define VHAL_TALKER_H
+/**
+ * @file vhal_talker.h
+ * @brief Connection driver shared by the VHAL client objects.
+ * @version 0.1
+ * @date 2021-08-11
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "event_loop.h"
+#include "libvhal_common.h"
+#include "reconnect_policy.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace vhal {
+namespace client {
+
+class EventLoopWorker;
+
+/**
+ * @brief Keeps one VHAL connection alive and dispatches its input.
+ *
+ * Connects with backoff (see ReconnectPolicy), then hands every poll event
+ * of the connected fd to Ops::on_event until that returns false, at which
+ * point the connection is closed and re-established.
+ *
+ * Without an EventLoop this runs on a dedicated thread, the historical
+ * behaviour. With one, the same steps run as callbacks on one of the loop
+ * threads, so no thread is spent per object.
+ */
+class VhalTalker
+{
+public:
+    struct Ops
+    {
+        std::function<ConnectionResult()> connect;
+        std::function<bool()>             connected;
+        std::function<int()>              fd;
+        std::function<void()>             close;
+        // Called after every successful connect.
+        std::function<void()> on_connected;
+        // Called for the 1st, 2nd, 4th, ... consecutive failure only.
+        std::function<void(const std::string& error_msg,
+                           std::chrono::milliseconds retry_in)>
+          on_connect_failed;
+        // poll() revents of the connected fd. Return false to reconnect.
+        std::function<bool(short revents)> on_event;
+    };
+
+    VhalTalker(Ops                        ops,
+               std::shared_ptr<EventLoop> event_loop = nullptr,
+               const std::string&         watch_path = "");
+    ~VhalTalker();
+
+    VhalTalker(const VhalTalker&) = delete;
+    VhalTalker& operator=(const VhalTalker&) = delete;
+
+    /**
+     * @brief Start connecting, on a new thread or on the event loop.
+     */
+    void Start();
+
+    /**
+     * @brief Stop and wait until no Ops callback is running any more. Must
+     * be called before whatever the callbacks use is destroyed.
+     */
+    void Stop();
+
+private:
+    // Thread-per-object mode.
+    void Run();
+
+    // Event loop mode, all on the worker thread.
+    void TryConnect();
+    void ScheduleRetry();
+    void OnSocketEvent(uint32_t events);
+    void OnWatchEvent();
+    void Retry(std::chrono::milliseconds delay);
+    void Unwatch(uint64_t& watch);
+
+    Ops                        ops_;
+    ReconnectPolicy            reconnect_;
+    std::shared_ptr<EventLoop> event_loop_;
+    std::thread                thread_;
+    std::atomic<bool>          running_ = false;
+
+    EventLoopWorker* worker_       = nullptr;
+    bool             stopped_      = false;
+    uint64_t         retry_timer_  = 0;
+    uint64_t         socket_watch_ = 0;
+    uint64_t         dir_watch_    = 0;
+};
+
+} // namespace client
+} // namespace vhal
+#endif /* VHAL_TALKER_H */
@@ -21,6 +21,8 @@
  */
 #include "video_sink.h"
 #include "video_sink_impl.h"
+#include "tcp_stream_socket_client.h"
+#include "unix_seqpacket_socket_client.h"
 #include "unix_stream_socket_client.h"
 #include "vsock_stream_socket_client.h"
 #include <functional>
@@ -30,6 +32,7 @@
 #include <sys/types.h>
 
 #define CAMERA_UNIX_SOCKET "/camera-socket"
+#define CAMERA_TCP_PORT 1982
 
 namespace vhal {
 namespace client {
@@ -47,9 +50,18 @@ VideoSink::VideoSink(UnixConnectionInfo unix_conn_info, CameraCallback callback)
     }
 
     //Creating interface to communicate to VHAL via libvhal
-    auto unix_sock_client =
-      std::make_unique<UnixStreamSocketClient>(std::move(sockPath));
-    impl_ = std::make_unique<Impl>(std::move(unix_sock_client), callback);
+    std::unique_ptr<IStreamSocketClient> unix_sock_client;
+    if (unix_conn_info.seqpacket) {
+        unix_sock_client = std::make_unique<UnixSeqpacketSocketClient>(
+          sockPath, unix_conn_info.socket_options);
+    } else {
+        unix_sock_client = std::make_unique<UnixStreamSocketClient>(
+          sockPath, unix_conn_info.socket_options);
+    }
+    impl_ = std::make_unique<Impl>(std::move(unix_sock_client),
+                                   callback,
+                                   unix_conn_info.event_loop,
+                                   sockPath);
 }
 
 VideoSink::VideoSink(VsockConnectionInfo vsock_conn_info, CameraCallback callback)
@@ -60,8 +72,36 @@ VideoSink::VideoSink(VsockConnectionInfo vsock_conn_info, CameraCallback callbac
     }
     //Creating interface to communicate to VHAL via libvhal
     auto vsock_sock_client =
-      std::make_unique<VsockStreamSocketClient>(std::move(vsock_conn_info.android_vm_cid));
-    impl_ = std::make_unique<Impl>(std::move(vsock_sock_client), callback);
+      std::make_unique<VsockStreamSocketClient>(vsock_conn_info.android_vm_cid,
+                                                vsock_conn_info.socket_options);
+    impl_ = std::make_unique<Impl>(
+      std::move(vsock_sock_client), callback, vsock_conn_info.event_loop);
+}
+
+VideoSink::VideoSink(TcpConnectionInfo tcp_conn_info, CameraCallback callback)
+{
+    if (tcp_conn_info.ip_addr.empty()) {
+        throw std::invalid_argument("Please set a valid ip_addr");
+    }
+    auto port = tcp_conn_info.port ? tcp_conn_info.port : CAMERA_TCP_PORT;
+    //Creating interface to communicate to VHAL via libvhal
+    auto tcp_sock_client =
+      std::make_unique<TcpStreamSocketClient>(tcp_conn_info.ip_addr,
+                                              port,
+                                              tcp_conn_info.socket_options);
+    impl_ = std::make_unique<Impl>(
+      std::move(tcp_sock_client), callback, tcp_conn_info.event_loop);
+}
+
+VideoSink::VideoSink(std::unique_ptr<IStreamSocketClient> socket_client,
+                     CameraCallback                       callback,
+                     std::shared_ptr<EventLoop>           event_loop)
+{
+    if (!socket_client) {
+        throw std::invalid_argument("Please set a valid socket_client");
+    }
+    impl_ = std::make_unique<Impl>(
+      std::move(socket_client), callback, std::move(event_loop));
 }
 
 VideoSink::~VideoSink() {}
@@ -77,11 +117,184 @@ IOResult VideoSink::SendDataPacket(const uint8_t* packet, size_t size)
     return impl_->SendDataPacket(packet, size);
 }
 
+ssize_t VideoSink::SendDataPacket(const uint8_t*   packet,
+                                  size_t           size,
+                                  std::error_code& ec)
+{
+    return impl_->SendDataPacket(packet, size, ec);
+}
+
+IOResult VideoSink::SendDataPacket(const uint8_t* packet,
+                                   size_t         size,
+                                   uint64_t       capture_timestamp_ns,
+                                   uint32_t       flags)
+{
+    return impl_->SendDataPacket(packet, size, capture_timestamp_ns, flags);
+}
+
+IOResult VideoSink::SendDataPacket(FrameBuffer frame)
+{
+    return impl_->SendDataPacket(std::move(frame));
+}
+
+IOResult VideoSink::SendDataPacket(FrameBuffer frame,
+                                   uint64_t    capture_timestamp_ns,
+                                   uint32_t    flags)
+{
+    return impl_->SendDataPacket(std::move(frame), capture_timestamp_ns, flags);
+}
+
+bool VideoSink::IsFrameMetadataEnabled() const
+{
+    return impl_->IsFrameMetadataEnabled();
+}
+
+IOResult VideoSink::SendAccessUnits(const uint8_t* data, size_t size)
+{
+    return impl_->SendAccessUnits(data, size);
+}
+
+IOResult VideoSink::FlushAccessUnits()
+{
+    return impl_->FlushAccessUnits();
+}
+
 IOResult VideoSink::SendRawPacket(const uint8_t* packet, size_t size)
 {
     return impl_->SendRawPacket(packet, size);
 }
 
+IOResult VideoSink::SendRawFrame(const RawFrame& frame)
+{
+    return impl_->SendRawFrame(frame);
+}
+
+IOResult VideoSink::SendRawFrame(const RawFrame& frame,
+                                 uint64_t        capture_timestamp_ns,
+                                 uint32_t        flags)
+{
+    return impl_->SendRawFrame(frame, capture_timestamp_ns, flags);
+}
+
+IOResult VideoSink::SendDataPacketZeroCopy(const uint8_t*        packet,
+                                           size_t                size,
+                                           PacketReleaseCallback release)
+{
+    return impl_->SendDataPacketZeroCopy(packet, size, std::move(release));
+}
+
+IOResult VideoSink::SendDataPacketZeroCopy(FrameBuffer frame)
+{
+    return impl_->SendDataPacketZeroCopy(std::move(frame));
+}
+
+void VideoSink::SetSendTimeout(int timeout_ms)
+{
+    impl_->SetSendTimeout(timeout_ms);
+}
+
+bool VideoSink::EnableAsyncSend(size_t depth, SendQueuePolicy policy)
+{
+    return impl_->EnableAsyncSend(depth, policy);
+}
+
+uint64_t VideoSink::GetDroppedFrameCount() const
+{
+    return impl_->GetDroppedFrameCount();
+}
+
+VideoSink::Stats VideoSink::GetStats() const
+{
+    return impl_->GetStats();
+}
+
+bool VideoSink::EnableCongestionMonitor(std::chrono::milliseconds interval,
+                                        uint64_t           max_bitrate_bps,
+                                        CongestionCallback callback)
+{
+    return impl_->EnableCongestionMonitor(
+      interval, max_bitrate_bps, std::move(callback));
+}
+
+void VideoSink::SetFrameCodec(VideoCodecType codec)
+{
+    impl_->SetFrameCodec(codec);
+}
+
+void VideoSink::SetFrameRate(uint32_t fps)
+{
+    impl_->SetFrameRate(fps);
+}
+
+FramePacer::Stats VideoSink::GetPacingStats() const
+{
+    return impl_->GetPacingStats();
+}
+
+std::unique_ptr<VideoSink::CameraStream>
+VideoSink::OpenCameraStream(uint32_t        camera_id,
+                            size_t          depth,
+                            SendQueuePolicy policy)
+{
+    auto stream = impl_->OpenCameraStream(camera_id, depth, policy);
+    if (!stream) {
+        return nullptr;
+    }
+    return std::unique_ptr<CameraStream>(new CameraStream(std::move(stream)));
+}
+
+VideoSink::CameraStream::CameraStream(std::unique_ptr<Impl> impl)
+  : impl_{ std::move(impl) }
+{}
+
+VideoSink::CameraStream::~CameraStream() = default;
+
+uint32_t VideoSink::CameraStream::CameraId() const
+{
+    return impl_->CameraId();
+}
+
+IOResult VideoSink::CameraStream::SendDataPacket(const uint8_t* packet, size_t size)
+{
+    return impl_->SendDataPacket(packet, size);
+}
+
+void VideoSink::CameraStream::SetFrameRate(uint32_t fps)
+{
+    impl_->SetFrameRate(fps);
+}
+
+void VideoSink::CameraStream::SetFrameCodec(VideoCodecType codec)
+{
+    impl_->SetFrameCodec(codec);
+}
+
+uint64_t VideoSink::CameraStream::GetDroppedFrameCount() const
+{
+    return impl_->GetDroppedFrameCount();
+}
+
+FramePacer::Stats VideoSink::CameraStream::GetPacingStats() const
+{
+    return impl_->GetPacingStats();
+}
+
+bool VideoSink::EnableSharedMemoryRing(uint32_t slot_count, size_t slot_size)
+{
+    return impl_->EnableSharedMemoryRing(slot_count, slot_size);
+}
+
+bool VideoSink::AcquireSharedFrameSlot(SharedFrameSlot& slot)
+{
+    return impl_->AcquireSharedFrameSlot(slot);
+}
+
+IOResult VideoSink::CommitSharedFrameSlot(const SharedFrameSlot& slot,
+                                          size_t                 size)
+{
+    return impl_->CommitSharedFrameSlot(slot, size);
+}
+
 std::shared_ptr<VideoSink::camera_capability_t>
 VideoSink::GetCameraCapabilty()
 {
@@ -99,5 +312,52 @@ VideoSink::ResetCameraCapabilty()
 {
     impl_->ResetCameraCapabilty();
 }
+
+bool
+VideoSink::WaitForReconnect(std::chrono::milliseconds timeout)
+{
+    return impl_->WaitForReconnect(timeout);
+}
+
+void
+VideoSink::RequestCameraCapability(std::chrono::milliseconds timeout,
+                                   CapabilityCallback        done)
+{
+    impl_->RequestCameraCapability(timeout, std::move(done));
+}
+
+std::future<std::shared_ptr<VideoSink::camera_capability_t>>
+VideoSink::RequestCameraCapability(std::chrono::milliseconds timeout)
+{
+    return impl_->RequestCameraCapability(timeout);
+}
+
+void
+VideoSink::SendCameraInfo(std::vector<camera_info_t> camera_info,
+                          std::chrono::milliseconds  timeout,
+                          AckCallback                done)
+{
+    impl_->SendCameraInfo(std::move(camera_info), timeout, std::move(done));
+}
+
+std::future<bool>
+VideoSink::SendCameraInfo(std::vector<camera_info_t> camera_info,
+                          std::chrono::milliseconds  timeout)
+{
+    return impl_->SendCameraInfo(std::move(camera_info), timeout);
+}
+
+std::shared_ptr<VideoSink::camera_capability_t>
+VideoSink::GetCachedCameraCapability() const
+{
+    return impl_->GetCachedCameraCapability();
+}
+
+void
+VideoSink::EnableSessionResume(ResumeCallback callback)
+{
+    impl_->EnableSessionResume(std::move(callback));
+}
+
 }; // namespace client
 } // namespace vhal
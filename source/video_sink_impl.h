@@ -21,21 +21,47 @@
  * limitations under the License.
  *
  */
+#include "annexb_packetizer.h"
+#include "camera_stream_impl.h"
+#include "capability_negotiator.h"
+#include "congestion_estimator.h"
+#include "frame_queue.h"
+#include "framed_reader.h"
+#include "nal_classifier.h"
+#include "stream_mux.h"
 #include "istream_socket_client.h"
+#include "latency_histogram.h"
+#include "vhal_log.h"
+#include "vhal_talker.h"
+#include "tcp_stream_socket_client.h"
+#include "unix_seqpacket_socket_client.h"
+#include "unix_stream_socket_client.h"
 #include "video_sink.h"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <functional>
-#include <iostream>
+#include <future>
+#include <list>
 #include <memory>
 #include <string>
 #include <system_error>
+#include <vector>
 extern "C"
 {
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
 }
 #include <thread>
 #include <tuple>
@@ -51,100 +77,61 @@ namespace client {
 class VideoSink::Impl
 {
 public:
-    Impl(unique_ptr<IStreamSocketClient> socket_client, CameraCallback callback)
-      : socket_client_{ move(socket_client) },
-        callback_{ move(callback) }
-    {
-        vhal_talker_thread_ = thread([this]() {
-            while (should_continue_) {
-                if (not socket_client_->Connected()) {
-                    if (auto [connected, error_msg] = socket_client_->Connect();
-                        !connected) {
-                        this_thread::sleep_for(33ms);
-                        continue;
-                    }
-                    cout << "Connected to Camera VHal!\n";
-                }
-                // connected ...
-                cout << " Connected to Camera VHal!\n";
-
-                struct pollfd fds[1];
-                const int     timeout_ms = 1 * 1000; // 1 sec timeout
-                int           ret;
-
-                // watch socket for input
-                fds[0].fd     = socket_client_->GetNativeSocketFd();
-                fds[0].events = POLLIN;
-                cmd_capability_ = std::make_shared<camera_capability_t>();
-                pthread_cond_signal(&mSignalInit);
-
-                do {
-                    ret = poll(fds, std::size(fds), timeout_ms);
-                    if (ret == -1) {
-                        throw system_error(errno, system_category());
-                    }
-                    if (!ret) {
-                        continue;
-                    }
-                    if (!(fds[0].revents & POLLIN)) {
-                        if (fds[0].revents & (POLLERR|POLLHUP|POLLNVAL)) {
-                            cout << "VideoSink Poll Fail event: "
-                                << fds[0].revents
-                                << ", reconnect\n";
-                            socket_client_->Close();
-                            break;
-                        }
-                        cout << "VideoSink : Poll revents " << fds[0].revents << "\n";
-                        continue;
-                    }
-                    cout << "Camera VHal has some message for us!\n";
-
-                    size_t header_size = sizeof(camera_header_t);
-                    camera_header_t cmd_header;
-                    std::tuple<ssize_t, std::string> response;
-  
-                    response = RecvPacket(
-                        reinterpret_cast<uint8_t*>(&cmd_header),
-                        header_size);
-                    if (get<0>(response) != header_size) {
-                        cout << "Failed to read camera_header_t from VideoSink: "
-                             << get<1>(response)
-                             << ", going to disconnect and reconnect.\n";
-                        socket_client_->Close();
-                        // FIXME: What to do ?? Exit ?
-                        continue;
-                    }
-                    switch(cmd_header.type) {
-                        case camera_packet_type_t::CAPABILITY:
-                            cout <<"received capability" <<"\n";
-                            if (!handle_capability())
-                                continue;
-                            break;
-
-                        case camera_packet_type_t::ACK:
-                            cout <<"received ack" <<"\n";
-                            if (!handle_ack())
-                                continue;
-                            break;
-
-                        case camera_packet_type_t::CAMERA_CONFIG:
-                            cout <<"received config" <<"\n";
-                            if (!handle_cmd())
-                                continue;
-                            break;
-                        default :
-                            cout <<"invalid header type received "<<"\n";
-                            break;
-                    }
-                } while (should_continue_);
-            }
-        });
+    Impl(unique_ptr<IStreamSocketClient> socket_client,
+         CameraCallback                  callback,
+         std::shared_ptr<EventLoop>      event_loop = nullptr,
+         const std::string&              watch_path = "")
+      : callback_{ move(callback) },
+        socket_client_{ move(socket_client) },
+        mux_{ [this](const struct iovec* iov, int iovcnt, std::error_code& ec) {
+                  return SendStreamChunk(iov, iovcnt, ec);
+              },
+              kStreamChunkSize },
+        negotiator_{ NegotiatorOps() },
+        reader_{ *socket_client_ },
+        talker_{ TalkerOps(), move(event_loop), watch_path }
+    {
+        // MSG_ZEROCOPY is only available on the TCP transport.
+        tcp_client_ = dynamic_cast<TcpStreamSocketClient*>(socket_client_.get());
+        // SCM_RIGHTS, and so the shared-memory ring, needs a Unix socket.
+        unix_client_ =
+          dynamic_cast<UnixStreamSocketClient*>(socket_client_.get());
+        seqpacket_client_ =
+          dynamic_cast<UnixSeqpacketSocketClient*>(socket_client_.get());
+        talker_.Start();
     }
 
     ~Impl()
     {
-        should_continue_ = false;
-        vhal_talker_thread_.join();
+        {
+            // Requests failed during teardown are not a resume.
+            std::lock_guard<std::mutex> lock(resume_mutex_);
+            resume_callback_ = nullptr;
+        }
+        if (congestion_monitor_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(congestion_mutex_);
+                congestion_stop_ = true;
+            }
+            congestion_cv_.notify_all();
+            congestion_monitor_.join();
+        }
+        if (send_queue_) {
+            // The sender may be stuck writing to a VHAL that stopped
+            // reading: stop reconnecting, then shut the socket under it.
+            send_queue_->Close();
+            talker_.Stop();
+            ResetConnection();
+            sender_.join();
+        }
+        talker_.Stop();
+        ReleaseZeroCopyPackets(true);
+        if (shm_base_ != nullptr) {
+            munmap(shm_base_, shm_len_);
+        }
+        if (shm_fd_ >= 0) {
+            close(shm_fd_);
+        }
     }
 
     bool IsConnected()
@@ -154,32 +141,386 @@ public:
 
     IOResult SendDataPacket(const uint8_t* packet, size_t size)
     {
-        std::string result_error_msg = "";
+        return SendDataPacket(packet, size, MonotonicNowNs(), 0);
+    }
 
-	//        std::tuple<ssize_t, std::string> response;
-        // Write payload size
-        camera_header_t data_header = {VideoSink::camera_packet_type_t::CAMERA_DATA, size};
-        std::tuple<ssize_t, std::string> response;
-        // Write payload size
-        //response = socket_client_->Send((uint8_t*)&size, sizeof(size));
-        response = socket_client_->Send((uint8_t*)&data_header, sizeof(data_header));
-        if (get<0>(response) == -1) {
-                get<1>(response) = "Error in writing payload size to Camera VHal: "
-                  + get<1>(response);
-                return response;
+    IOResult SendDataPacket(const uint8_t* packet,
+                            size_t         size,
+                            uint64_t       capture_timestamp_ns,
+                            uint32_t       flags)
+    {
+        std::error_code ec;
+        ssize_t         sent =
+          SendDataPacket(packet, size, capture_timestamp_ns, flags, ec);
+        return DataPacketResult(sent, ec);
+    }
+
+    IOResult SendDataPacket(FrameBuffer frame)
+    {
+        return SendDataPacket(std::move(frame), MonotonicNowNs(), 0);
+    }
+
+    IOResult SendDataPacket(FrameBuffer frame,
+                            uint64_t    capture_timestamp_ns,
+                            uint32_t    flags)
+    {
+        std::error_code ec;
+        ssize_t         sent =
+          SendDataPacket(std::move(frame), capture_timestamp_ns, flags, ec);
+        return DataPacketResult(sent, ec);
+    }
+
+    ssize_t SendDataPacket(const uint8_t* packet, size_t size, std::error_code& ec)
+    {
+        return SendDataPacket(packet, size, MonotonicNowNs(), 0, ec);
+    }
+
+    ssize_t SendDataPacket(const uint8_t*   packet,
+                           size_t           size,
+                           uint64_t         capture_timestamp_ns,
+                           uint32_t         flags,
+                           std::error_code& ec)
+    {
+        FrameClass              frame_class;
+        camera_frame_metadata_t metadata = NewFrameMetadata(
+          packet, size, capture_timestamp_ns, flags, frame_class);
+        if (send_queue_) {
+            if (!send_queue_->Push(packet, size, frame_class, metadata)) {
+                ec = std::make_error_code(std::errc::no_buffer_space);
+                return 0;
             }
-        // Write payload
-        response = socket_client_->Send(packet, size);
-        if (get<0>(response) == -1) {
-                get<1>(response) = "Error in writing payload to Camera VHal: "
-                  + get<1>(response);
-		cout <<" data send encountered serious error hence calling camera close and connection reset" <<"\n";
+            ec.clear();
+            return size;
+        }
+        return SendPacedDataPacket(packet, size, metadata, ec);
+    }
 
-                return response;
+    // Queued as is in async mode, released on return otherwise.
+    ssize_t SendDataPacket(FrameBuffer      frame,
+                           uint64_t         capture_timestamp_ns,
+                           uint32_t         flags,
+                           std::error_code& ec)
+    {
+        const size_t            size = frame.Size();
+        FrameClass              frame_class;
+        camera_frame_metadata_t metadata = NewFrameMetadata(
+          frame.Data(), size, capture_timestamp_ns, flags, frame_class);
+        if (send_queue_) {
+            if (!send_queue_->Push(std::move(frame), frame_class, metadata)) {
+                ec = std::make_error_code(std::errc::no_buffer_space);
+                return 0;
             }
+            ec.clear();
+            return size;
+        }
+        return SendPacedDataPacket(frame.Data(), size, metadata, ec);
+    }
 
-        // success
-        return response;
+    bool IsFrameMetadataEnabled() const
+    {
+        return metadata_enabled_;
+    }
+
+    IOResult SendAccessUnits(const uint8_t* data, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(packetizer_mutex_);
+        if (!UpdatePacketizer()) {
+            return { -1, "SendAccessUnits() needs SetFrameCodec(kH264 or kH265)" };
+        }
+        IOResult result = { size, "" };
+        packetizer_->Push(data, size, [&](const uint8_t* au, size_t au_size) {
+            SendAccessUnit(au, au_size, result);
+        });
+        return result;
+    }
+
+    IOResult FlushAccessUnits()
+    {
+        std::lock_guard<std::mutex> lock(packetizer_mutex_);
+        IOResult result = { 0, "" };
+        if (packetizer_) {
+            packetizer_->Flush([&](const uint8_t* au, size_t au_size) {
+                result = { au_size, "" };
+                SendAccessUnit(au, au_size, result);
+            });
+        }
+        return result;
+    }
+
+    void SetFrameCodec(VideoCodecType codec)
+    {
+        frame_codec_ = codec;
+    }
+
+    void SetFrameRate(uint32_t fps)
+    {
+        pacer_.SetFrameRate(fps);
+    }
+
+    std::unique_ptr<CameraStream::Impl> OpenCameraStream(uint32_t        camera_id,
+                                                         size_t          depth,
+                                                         SendQueuePolicy policy)
+    {
+        if (!mux_.Register(camera_id)) {
+            return nullptr;
+        }
+        return std::make_unique<CameraStream::Impl>(
+          mux_, camera_id, depth, policy);
+    }
+
+    FramePacer::Stats GetPacingStats() const
+    {
+        return pacer_.GetStats();
+    }
+
+    // Wait for the frame's deadline, if pacing is on. Late frames are sent
+    // anyway: dropping one would corrupt the encoded stream.
+    ssize_t SendPacedDataPacket(const uint8_t*           packet,
+                                size_t                   size,
+                                camera_frame_metadata_t& metadata,
+                                std::error_code&         ec)
+    {
+        pacer_.WaitNextFrame();
+        return SendDataPacketNow(packet, size, metadata, ec);
+    }
+
+    bool EnableAsyncSend(size_t depth, SendQueuePolicy policy)
+    {
+        if (send_queue_ || depth == 0) {
+            return false;
+        }
+        send_queue_ = std::make_unique<FrameQueue>(depth, policy);
+        sender_     = std::thread([this]() {
+            std::vector<uint8_t>    frame;
+            FrameBuffer             buffer;
+            camera_frame_metadata_t metadata;
+            std::error_code         ec;
+            while (send_queue_->Pop(frame, &metadata, &buffer)) {
+                ssize_t sent =
+                  buffer ? SendPacedDataPacket(
+                             buffer.Data(), buffer.Size(), metadata, ec)
+                         : SendPacedDataPacket(
+                             frame.data(), frame.size(), metadata, ec);
+                buffer.Reset();
+                if (sent == -1) {
+                    send_failures_++;
+                }
+            }
+        });
+        return true;
+    }
+
+    uint64_t GetDroppedFrameCount() const
+    {
+        uint64_t dropped = send_failures_;
+        if (send_queue_) {
+            dropped += send_queue_->Dropped();
+        }
+        return dropped;
+    }
+
+    Stats GetStats() const
+    {
+        Stats stats;
+        stats.frames_sent    = frames_sent_.load(std::memory_order_relaxed);
+        stats.bytes_sent     = bytes_sent_.load(std::memory_order_relaxed);
+        stats.send_errors    = send_errors_.load(std::memory_order_relaxed);
+        stats.frames_dropped = GetDroppedFrameCount();
+        stats.queue_depth    = send_queue_ ? send_queue_->Size() : 0;
+        {
+            std::lock_guard<std::mutex> lock(connect_mutex_);
+            stats.reconnects = connections_ > 0 ? connections_ - 1 : 0;
+        }
+        stats.send_latency = send_latency_.Summary();
+        stats.send_blocked = std::chrono::nanoseconds(
+          send_blocked_ns_.load(std::memory_order_relaxed));
+        stats.capability_rtt = capability_rtt_.Summary();
+        return stats;
+    }
+
+    bool EnableCongestionMonitor(std::chrono::milliseconds interval,
+                                 uint64_t                  max_bitrate_bps,
+                                 CongestionCallback        callback)
+    {
+        if (congestion_monitor_.joinable() ||
+            interval <= std::chrono::milliseconds::zero() || !callback) {
+            return false;
+        }
+        // The first interval starts now, not once the thread runs.
+        auto     last    = std::chrono::steady_clock::now();
+        uint64_t bytes   = bytes_sent_.load(std::memory_order_relaxed);
+        uint64_t frames  = frames_sent_.load(std::memory_order_relaxed);
+        uint64_t blocked = send_blocked_ns_.load(std::memory_order_relaxed);
+        congestion_monitor_ = std::thread([this, interval, max_bitrate_bps, last,
+                                           bytes, frames, blocked,
+                                           callback = move(callback)]() mutable {
+            CongestionEstimator          estimator(max_bitrate_bps);
+            std::unique_lock<std::mutex> lock(congestion_mutex_);
+            while (!congestion_cv_.wait_for(
+              lock, interval, [this]() { return congestion_stop_; })) {
+                auto now = std::chrono::steady_clock::now();
+                CongestionEstimator::Sample sample;
+                sample.socket_backlog = SocketBacklog();
+                sample.interval       = now - last;
+                sample.frame_rate     = pacer_.GetFrameRate();
+                if (send_queue_) {
+                    sample.queue_depth    = send_queue_->Size();
+                    sample.queue_capacity = send_queue_->Depth();
+                }
+                uint64_t new_bytes  = bytes_sent_.load(std::memory_order_relaxed);
+                uint64_t new_frames = frames_sent_.load(std::memory_order_relaxed);
+                uint64_t new_blocked =
+                  send_blocked_ns_.load(std::memory_order_relaxed);
+                sample.bytes        = new_bytes - bytes;
+                sample.frames       = new_frames - frames;
+                sample.send_blocked = std::chrono::nanoseconds(new_blocked - blocked);
+                last    = now;
+                bytes   = new_bytes;
+                frames  = new_frames;
+                blocked = new_blocked;
+
+                auto report = estimator.Update(sample);
+                lock.unlock();
+                callback(report);
+                lock.lock();
+            }
+        });
+        return true;
+    }
+
+    ssize_t SendDataPacketNow(const uint8_t*           packet,
+                              size_t                   size,
+                              camera_frame_metadata_t& metadata,
+                              std::error_code&         ec)
+    {
+        if (shm_enabled_ && size <= shm_info_.slot_size) {
+            SharedFrameSlot slot;
+            if (!AcquireSharedFrameSlot(slot)) {
+                ec = std::make_error_code(std::errc::no_buffer_space);
+                return -1;
+            }
+            memcpy(slot.data, packet, size);
+            return CommitSharedFrameSlot(slot, size, ec);
+        }
+
+        struct iovec iov[3];
+        iov[2] = { const_cast<uint8_t*>(packet), size };
+        return WriteDataPacket(iov, std::size(iov), size, metadata, ec);
+    }
+
+    // Header, metadata and payload go out in a single sendmsg() call.
+    // iov[0] and iov[1] are left free for the header and metadata, the
+    // payload of size bytes follows.
+    ssize_t WriteDataPacket(struct iovec*            iov,
+                            int                      iovcnt,
+                            size_t                   size,
+                            camera_frame_metadata_t& metadata,
+                            std::error_code&         ec)
+    {
+        camera_header_t data_header = {
+            VideoSink::camera_packet_type_t::CAMERA_DATA,
+            static_cast<uint32_t>(size)
+        };
+        int  first         = 1;
+        bool with_metadata = metadata_enabled_;
+        if (with_metadata) {
+            data_header.type = camera_packet_type_t::CAMERA_DATA_EXT;
+            data_header.size += sizeof(metadata);
+            iov[1] = { &metadata, sizeof(metadata) };
+            first  = 0;
+        }
+        iov[first] = { &data_header, sizeof(data_header) };
+        auto    start = std::chrono::steady_clock::now();
+        ssize_t sent;
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            if (with_metadata) {
+                StampFrameMetadata(metadata);
+            }
+            sent = socket_client_->SendAll(
+              iov + first, iovcnt - first, send_timeout_ms_, ec);
+        }
+        RecordDataPacket(start, sent == -1 ? -1 : ssize_t(size));
+        if (sent == -1) {
+                VHAL_LOG(kError) << "data send encountered serious error hence "
+                                    "calling camera close and connection reset";
+                ResetConnection();
+                return -1;
+            }
+
+        // success, report payload bytes only
+        return size;
+    }
+
+    IOResult SendRawFrame(const RawFrame& frame)
+    {
+        return SendRawFrame(frame, MonotonicNowNs(), 0);
+    }
+
+    IOResult SendRawFrame(const RawFrame& frame,
+                          uint64_t        capture_timestamp_ns,
+                          uint32_t        flags)
+    {
+        std::string error_msg = CheckRawFrame(frame);
+        if (!error_msg.empty()) {
+            return { -1, error_msg };
+        }
+        const uint32_t width  = frame.width;
+        const uint32_t height = frame.height;
+        const size_t   size   = size_t(width) * height * 3 / 2;
+        // Rows and row bytes of each plane, see PixelFormat.
+        const bool   planar   = frame.format == PixelFormat::kI420;
+        const size_t rows[3]  = { height, height / 2, height / 2 };
+        const size_t bytes[3] = { width, planar ? width / 2 : width, width / 2 };
+        const int    planes   = planar ? 3 : 2;
+
+        camera_frame_metadata_t metadata = {
+            capture_timestamp_ns, 0, next_sequence_++, flags, 0
+        };
+        std::error_code         ec;
+        if (shm_enabled_ && size <= shm_info_.slot_size) {
+            SharedFrameSlot slot;
+            if (!AcquireSharedFrameSlot(slot)) {
+                return DataPacketResult(
+                  -1, std::make_error_code(std::errc::no_buffer_space));
+            }
+            uint8_t* dst = slot.data;
+            for (int p = 0; p < planes; p++) {
+                dst = CopyPlane(frame.planes[p], rows[p], bytes[p], dst);
+            }
+            return DataPacketResult(CommitSharedFrameSlot(slot, size, ec), ec);
+        }
+
+        // One iovec per plane if its rows are contiguous, else one per row.
+        std::lock_guard<std::mutex> lock(raw_frame_mutex_);
+        raw_iov_.resize(2);
+        for (int p = 0; p < planes; p++) {
+            const RawFramePlane& plane = frame.planes[p];
+            if (plane.stride == bytes[p]) {
+                raw_iov_.push_back({ const_cast<uint8_t*>(plane.data),
+                                     rows[p] * bytes[p] });
+                continue;
+            }
+            for (size_t row = 0; row < rows[p]; row++) {
+                raw_iov_.push_back(
+                  { const_cast<uint8_t*>(plane.data + row * plane.stride),
+                    bytes[p] });
+            }
+        }
+        // A seqpacket message has to go out in one sendmsg(), which takes
+        // at most IOV_MAX vectors.
+        if (seqpacket_client_ != nullptr && raw_iov_.size() > kMaxRawIovecs) {
+            raw_pack_.resize(size);
+            uint8_t* dst = raw_pack_.data();
+            for (int p = 0; p < planes; p++) {
+                dst = CopyPlane(frame.planes[p], rows[p], bytes[p], dst);
+            }
+            raw_iov_.resize(3);
+            raw_iov_[2] = { raw_pack_.data(), size };
+        }
+        ssize_t sent = WriteDataPacket(
+          raw_iov_.data(), int(raw_iov_.size()), size, metadata, ec);
+        return DataPacketResult(sent, ec);
     }
 
     IOResult SendRawPacket(const uint8_t* packet, size_t size)
@@ -187,67 +528,347 @@ public:
       	std::tuple<ssize_t, std::string> response;
 
         // Write payload
-        response = socket_client_->Send(packet, size);
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            response = socket_client_->SendAll(packet, size, send_timeout_ms_);
+        }
+        RecordBlocked(start);
         if (get<0>(response) == -1) {
                 get<1>(response) = "Error in writing payload to Camera VHal: "
                   + get<1>(response);
-		cout <<" data send encountered serious error hence calling camera close and connection reset" <<"\n";
-
+                VHAL_LOG(kError) << "data send encountered serious error hence "
+                                    "calling camera close and connection reset";
+                ResetConnection();
                 return response;
             }
         // success
         return response;
     }
 
-    std::shared_ptr<camera_capability_t> GetCameraCapabilty()
+    IOResult SendDataPacketZeroCopy(FrameBuffer frame)
     {
-        std::tuple<ssize_t, std::string> response;
-        camera_header_t header_packet;
+        if (tcp_client_ == nullptr) {
+            return SendDataPacket(std::move(frame));
+        }
+        const uint8_t* packet = frame.Data();
+        size_t         size   = frame.Size();
+        return SendDataPacketZeroCopy(packet, size, nullptr, std::move(frame));
+    }
+
+    // owned, if any, is kept with the packet and released with it.
+    IOResult SendDataPacketZeroCopy(const uint8_t*        packet,
+                                    size_t                size,
+                                    PacketReleaseCallback release,
+                                    FrameBuffer           owned = {})
+    {
+        if (tcp_client_ == nullptr) {
+            // No MSG_ZEROCOPY on this transport: copy, then release at once.
+            auto response = SendDataPacket(packet, size);
+            release(packet);
+            return response;
+        }
+        if (!zerocopy_requested_.exchange(true)) {
+            tcp_client_->EnableZeroCopy();
+        }
 
-        header_packet.type = VideoSink::camera_packet_type_t::REQUST_CAPABILITY;
-       	response = SendRawPacket((unsigned char*)&header_packet, sizeof(camera_header_t));
+        ZeroCopyPacket* entry;
+        {
+            std::lock_guard<std::mutex> lock(zerocopy_mutex_);
+            entry           = &zerocopy_pending_.emplace_back();
+            entry->header   = { camera_packet_type_t::CAMERA_DATA,
+                                static_cast<uint32_t>(size) };
+            entry->packet   = packet;
+            entry->release  = move(release);
+            entry->owned    = std::move(owned);
+            entry->first_id = tcp_client_->NextZeroCopyId();
+            entry->generation = connection_generation_;
+        }
+
+        // The header is sent from the list entry rather than the stack: the
+        // kernel may still read these pages after sendmsg() returns.
+        struct iovec iov[2] = {
+            { &entry->header, sizeof(camera_header_t) },
+            { const_cast<uint8_t*>(packet), size },
+        };
+        IOResult response;
+        auto     start = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            response = tcp_client_->SendAllZeroCopy(
+              iov, std::size(iov), send_timeout_ms_);
+        }
+        RecordDataPacket(start, get<0>(response) == -1 ? -1 : ssize_t(size));
+        {
+            std::lock_guard<std::mutex> lock(zerocopy_mutex_);
+            entry->end_id = tcp_client_->NextZeroCopyId();
+            entry->sent   = true;
+            entry->failed = get<0>(response) == -1;
+        }
         if (get<0>(response) == -1) {
-            get<1>(response) = "Error in sending request capability header to Camera VHal: "
+            get<1>(response) = "Error in writing payload to Camera VHal: "
               + get<1>(response);
-            return NULL;
+            VHAL_LOG(kError) << "data send encountered serious error hence "
+                                "calling camera close and connection reset";
+            ResetConnection();
+        }
+        ReapZeroCopyCompletions();
+        if (get<0>(response) != -1) {
+            get<0>(response) = size;
         }
-        std::unique_lock<std::mutex> lck(mutex_);
-        wait_api_data.wait(lck);
+        return response;
+    }
 
-        cout << " returning GetCameraCapabilty result" << "\n";
-        return cmd_capability_;
+    void SetSendTimeout(int timeout_ms)
+    {
+        send_timeout_ms_ = timeout_ms;
     }
 
-    bool SetCameraCapabilty(std::vector<camera_info_t> camera_info)
+    bool EnableSharedMemoryRing(uint32_t slot_count, size_t slot_size)
     {
-        std::tuple<ssize_t, std::string> response;
-        
-        camera_header_t header_packet;
-        header_packet.type = camera_packet_type_t::CAMERA_INFO;
-        header_packet.size = camera_info.size() * sizeof(camera_info_t);
+        if ((unix_client_ == nullptr && seqpacket_client_ == nullptr) ||
+            shm_enabled_ || slot_count == 0 ||
+            slot_size == 0 || slot_size > UINT32_MAX) {
+            return false;
+        }
 
-        response = SendRawPacket((unsigned char*)&header_packet, sizeof(camera_header_t));
-        if (get<0>(response) == -1) {
-            get<1>(response) = "Error in sending config header to Camera VHal: "
-              + get<1>(response);
+        const size_t page   = sysconf(_SC_PAGESIZE);
+        const size_t states = sizeof(camera_shm_ring_info_t) +
+                              slot_count * sizeof(uint32_t);
+        const size_t data_offset = (states + page - 1) / page * page;
+        const size_t stride      = (slot_size + page - 1) / page * page;
+        const size_t len         = data_offset + stride * slot_count;
+        if (stride > UINT32_MAX || data_offset > UINT32_MAX) {
             return false;
         }
 
-        response = SendRawPacket((uint8_t *)(camera_info.data()),
-                                 camera_info.size() * sizeof(camera_info_t));
-        if (get<0>(response) == -1) {
-            get<1>(response) = "Error in sending config to Camera VHal: "
-              + get<1>(response);
+        int fd = memfd_create("vhal-camera-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd < 0) {
+            VHAL_LOG(kError) << "memfd_create failed: " << strerror(errno);
+            return false;
+        }
+        if (ftruncate(fd, len) < 0) {
+            VHAL_LOG(kError) << "ftruncate failed: " << strerror(errno);
+            close(fd);
+            return false;
+        }
+        // The VHAL maps whatever it receives; make sure the size stays put.
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+        void* base = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            VHAL_LOG(kError) << "mmap failed: " << strerror(errno);
+            close(fd);
             return false;
         }
 
-        std::unique_lock<std::mutex> lck(mutex_);
-        wait_api_data.wait(lck);
-        cout << " returning SetCameraCapabilty result" << "\n";
+        // ftruncate() zero-fills, so every slot starts out SHM_SLOT_FREE.
+        shm_info_ = { kShmRingMagic,
+                      kShmRingVersion,
+                      slot_count,
+                      static_cast<uint32_t>(slot_size),
+                      static_cast<uint32_t>(stride),
+                      static_cast<uint32_t>(data_offset),
+                      { 0, 0 } };
+        memcpy(base, &shm_info_, sizeof(shm_info_));
+        shm_fd_      = fd;
+        shm_base_    = static_cast<uint8_t*>(base);
+        shm_len_     = len;
+        shm_enabled_ = true;
 
+        if (socket_client_->Connected()) {
+            AnnounceSharedRing();
+        }
         return true;
     }
 
+    bool AcquireSharedFrameSlot(SharedFrameSlot& slot)
+    {
+        if (!shm_enabled_) {
+            return false;
+        }
+        for (uint32_t i = 0; i < shm_info_.slot_count; i++) {
+            uint32_t idx      = (shm_next_slot_ + i) % shm_info_.slot_count;
+            uint32_t expected = SHM_SLOT_FREE;
+            if (SlotState(idx).compare_exchange_strong(
+                  expected, SHM_SLOT_WRITING, std::memory_order_acquire)) {
+                shm_next_slot_ = (idx + 1) % shm_info_.slot_count;
+                slot.index     = idx;
+                slot.data      = shm_base_ + shm_info_.data_offset +
+                            size_t(idx) * shm_info_.slot_stride;
+                slot.capacity = shm_info_.slot_size;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    IOResult CommitSharedFrameSlot(const SharedFrameSlot& slot, size_t size)
+    {
+        std::error_code ec;
+        ssize_t         sent = CommitSharedFrameSlot(slot, size, ec);
+        if (ec == std::errc::invalid_argument) {
+            return { -1, "Invalid shared-memory slot" };
+        }
+        if (ec == std::errc::message_size) {
+            return { -1, "Frame does not fit in shared-memory slot" };
+        }
+        if (ec) {
+            return { -1, "Error in writing slot descriptor to Camera VHal: " +
+                           ec.message() };
+        }
+        return { sent, "" };
+    }
+
+    ssize_t CommitSharedFrameSlot(const SharedFrameSlot& slot,
+                                  size_t                 size,
+                                  std::error_code&       ec)
+    {
+        ec.clear();
+        if (!shm_enabled_ || slot.index >= shm_info_.slot_count) {
+            ec = std::make_error_code(std::errc::invalid_argument);
+            return -1;
+        }
+        if (size == 0) {
+            SlotState(slot.index).store(SHM_SLOT_FREE, std::memory_order_release);
+            return 0;
+        }
+        if (size > shm_info_.slot_size) {
+            SlotState(slot.index).store(SHM_SLOT_FREE, std::memory_order_release);
+            ec = std::make_error_code(std::errc::message_size);
+            return -1;
+        }
+
+        // Publish the frame contents before the VHAL can see the descriptor.
+        SlotState(slot.index).store(SHM_SLOT_READY, std::memory_order_release);
+
+        camera_shm_slot_desc_t desc = { slot.index, static_cast<uint32_t>(size) };
+        camera_header_t header = { camera_packet_type_t::CAMERA_SHM_DATA,
+                                   sizeof(desc) };
+        struct iovec iov[2] = {
+            { &header, sizeof(header) },
+            { &desc, sizeof(desc) },
+        };
+        auto    start = std::chrono::steady_clock::now();
+        ssize_t sent;
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            sent = socket_client_->SendAll(
+              iov, std::size(iov), send_timeout_ms_, ec);
+        }
+        RecordDataPacket(start, sent == -1 ? -1 : ssize_t(size));
+        if (sent == -1) {
+            SlotState(slot.index).store(SHM_SLOT_FREE, std::memory_order_release);
+            VHAL_LOG(kError) << "data send encountered serious error hence "
+                                "calling camera close and connection reset";
+            ResetConnection();
+            return -1;
+        }
+        return size;
+    }
+
+    std::shared_ptr<camera_capability_t> GetCameraCapabilty()
+    {
+        auto capability =
+          RequestCameraCapability(kNegotiationTimeout).get();
+        VHAL_LOG(kDebug) << "returning GetCameraCapabilty result";
+        return capability;
+    }
+
+    bool SetCameraCapabilty(std::vector<camera_info_t> camera_info)
+    {
+        bool acked =
+          SendCameraInfo(move(camera_info), kNegotiationTimeout).get();
+        VHAL_LOG(kDebug) << "returning SetCameraCapabilty result";
+        return acked;
+    }
+
+    void RequestCameraCapability(std::chrono::milliseconds timeout,
+                                 CapabilityCallback        done)
+    {
+        auto start = std::chrono::steady_clock::now();
+        negotiator_.RequestCapability(
+          timeout,
+          [this, start, done = move(done)](
+            std::shared_ptr<camera_capability_t> capability) {
+              if (capability) {
+                  capability_rtt_.Record(std::chrono::steady_clock::now() - start);
+              }
+              done(move(capability));
+          });
+    }
+
+    std::future<std::shared_ptr<camera_capability_t>> RequestCameraCapability(
+      std::chrono::milliseconds timeout)
+    {
+        auto promise =
+          std::make_shared<std::promise<std::shared_ptr<camera_capability_t>>>();
+        auto future = promise->get_future();
+        RequestCameraCapability(
+          timeout, [promise](std::shared_ptr<camera_capability_t> capability) {
+              promise->set_value(move(capability));
+          });
+        return future;
+    }
+
+    // An acknowledged camera info decides whether frames carry metadata
+    // from now on, and the resolution of raw frames until CMD_OPEN.
+    void SendCameraInfo(std::vector<camera_info_t> camera_info,
+                        std::chrono::milliseconds  timeout,
+                        AckCallback                done)
+    {
+        bool wants_metadata =
+          std::any_of(camera_info.begin(), camera_info.end(),
+                      [](const camera_info_t& info) {
+                          return info.features & kFeatureFrameMetadata;
+                      });
+        uint32_t resolution =
+          camera_info.empty() ? 0 : camera_info[0].resolution;
+        auto sent_info = camera_info;
+        negotiator_.SendCameraInfo(
+          move(camera_info),
+          timeout,
+          [this, wants_metadata, resolution, sent_info = move(sent_info),
+           done = move(done)](bool acked) mutable {
+              if (acked) {
+                  {
+                      std::lock_guard<std::mutex> lock(resume_mutex_);
+                      resume_info_ = move(sent_info);
+                  }
+                  // CMD_OPEN names the resolution the VHAL actually uses.
+                  uint32_t none = 0;
+                  negotiated_resolution_.compare_exchange_strong(none,
+                                                                 resolution);
+                  auto capability   = negotiator_.CachedCapability();
+                  metadata_enabled_ = wants_metadata && capability &&
+                                      (capability->features &
+                                       kFeatureFrameMetadata);
+              }
+              done(acked);
+          });
+    }
+
+    std::future<bool> SendCameraInfo(std::vector<camera_info_t> camera_info,
+                                     std::chrono::milliseconds  timeout)
+    {
+        auto promise = std::make_shared<std::promise<bool>>();
+        auto future  = promise->get_future();
+        SendCameraInfo(move(camera_info), timeout, [promise](bool acked) {
+            promise->set_value(acked);
+        });
+        return future;
+    }
+
+    std::shared_ptr<camera_capability_t> GetCachedCameraCapability() const
+    {
+        return negotiator_.CachedCapability();
+    }
+
+    void EnableSessionResume(ResumeCallback callback)
+    {
+        std::lock_guard<std::mutex> lock(resume_mutex_);
+        resume_callback_ = move(callback);
+    }
+
     bool handle_ack()
     {
         size_t ack_pkt_size = sizeof(CameraAck);
@@ -258,13 +879,14 @@ public:
             reinterpret_cast<uint8_t*>(&ack_pkt),
             ack_pkt_size);
         if (get<0>(response) != ack_pkt_size) {
-            cout << "Failed to read ack_pkt from VideoSink: "
-                 << get<1>(response)
-                 << ", going to disconnect and reconnect.\n";
-            socket_client_->Close();
+            VHAL_LOG(kError) << "Failed to read ack_pkt from VideoSink: "
+                             << get<1>(response)
+                             << ", going to disconnect and reconnect.";
             return false;
         }
-        wait_api_data.notify_one();
+        VHAL_LOG(kDebug) << "camera info "
+                         << (ack_pkt == ACK_CONFIG ? "acked" : "refused");
+        negotiator_.OnAck(ack_pkt);
         return true;
     }
     bool handle_capability()
@@ -272,19 +894,20 @@ public:
         size_t capability_pkt_size = sizeof(camera_capability_t);
         std::tuple<ssize_t, std::string> response;
 
+        camera_capability_t capability;
         response = RecvPacket(
-            reinterpret_cast<uint8_t*>(cmd_capability_.get()),
+            reinterpret_cast<uint8_t*>(&capability),
             capability_pkt_size);
         if (get<0>(response) != capability_pkt_size) {
-            cout << "Failed to read capability from VideoSink: "
-                 << get<1>(response)
-                 << ", going to disconnect and reconnect.\n";
-            socket_client_->Close();
+            VHAL_LOG(kError) << "Failed to read capability from VideoSink: "
+                             << get<1>(response)
+                             << ", going to disconnect and reconnect.";
             return false;
             // FIXME: What to do ?? Exit ?
         }
-        cout <<"params: codec type:"<<cmd_capability_->codec_type <<", resolution:"<<cmd_capability_->resolution<<"\n";
-        wait_api_data.notify_one();
+        VHAL_LOG(kDebug) << "params: codec type:" << capability.codec_type
+                         << ", resolution:" << capability.resolution;
+        negotiator_.OnCapability(capability);
 
         return true;
     }
@@ -298,45 +921,672 @@ public:
             reinterpret_cast<uint8_t*>(&cmd_pkt),
             cmd_pkt_size);
         if (get<0>(response) != cmd_pkt_size) {
-            cout << "Failed to read camera_config from VideoSink: "
-                 << get<1>(response)
-                 << ", going to disconnect and reconnect.\n";
-            socket_client_->Close();
+            VHAL_LOG(kError) << "Failed to read camera_config from VideoSink: "
+                             << get<1>(response)
+                             << ", going to disconnect and reconnect.";
             return false;
             // FIXME: What to do ?? Exit ?
         }
 
-        cout << "camera cmd received "<< (int)cmd_pkt.cmd <<"\n";
+        VHAL_LOG(kDebug) << "camera cmd received " << (int)cmd_pkt.cmd;
+        if (cmd_pkt.cmd == camera_cmd_t::CMD_OPEN) {
+            negotiated_resolution_ = cmd_pkt.camera_config.resolution;
+        }
+        if (cmd_pkt.cmd == camera_cmd_t::CMD_OPEN ||
+            cmd_pkt.cmd == camera_cmd_t::CMD_CLOSE) {
+            std::lock_guard<std::mutex> lock(resume_mutex_);
+            camera_open_ = cmd_pkt.cmd == camera_cmd_t::CMD_OPEN;
+            open_config_ = cmd_pkt.camera_config;
+        }
         callback_(cref(cmd_pkt));
         return true;
     }
 
     void ResetCameraCapabilty()
     {
-        pthread_mutex_lock(&mInitLock);
-        pthread_cond_wait(&mSignalInit, &mInitLock);
-        pthread_mutex_unlock(&mInitLock);
+        std::unique_lock<std::mutex> lock(connect_mutex_);
+        connect_cv_.wait(lock, [this]() { return connections_ > connections_seen_; });
+        connections_seen_ = connections_;
+    }
+
+    bool WaitForReconnect(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(connect_mutex_);
+        if (!connect_cv_.wait_for(lock, timeout, [this]() {
+                return connections_ > connections_seen_;
+            })) {
+            return false;
+        }
+        connections_seen_ = connections_;
+        return true;
     }
 
 private:
     CameraCallback                  callback_ = nullptr;
     unique_ptr<IStreamSocketClient> socket_client_;
-    thread                          vhal_talker_thread_;
-    atomic<bool>                    should_continue_ = true;
 
-    pthread_cond_t mSignalInit = PTHREAD_COND_INITIALIZER;
-    pthread_mutex_t mInitLock = PTHREAD_MUTEX_INITIALIZER;
+    // Successful connects so far, and as of the last ResetCameraCapabilty().
+    mutable std::mutex      connect_mutex_;
+    std::condition_variable connect_cv_;
+    uint64_t                connections_      = 0;
+    uint64_t                connections_seen_ = 0;
+
+    // -1: block until the whole packet is written.
+    atomic<int> send_timeout_ms_ = -1;
+    // Keeps packets from different threads from interleaving on the socket.
+    std::mutex send_mutex_;
+
+    // MSG_ZEROCOPY packets the kernel may still be reading from.
+    struct ZeroCopyPacket
+    {
+        camera_header_t       header;
+        const uint8_t*        packet = nullptr;
+        PacketReleaseCallback release;
+        FrameBuffer           owned;
+        uint32_t              first_id   = 0;
+        uint32_t              end_id     = 0;
+        uint64_t              completed  = 0;
+        uint64_t              generation = 0;
+        bool                  sent       = false;
+        bool                  failed     = false;
+    };
+    TcpStreamSocketClient*    tcp_client_ = nullptr;
+    atomic<bool>              zerocopy_requested_ = false;
+    std::mutex                zerocopy_mutex_;
+    std::list<ZeroCopyPacket> zerocopy_pending_;
+    uint64_t                  connection_generation_ = 0;
+
+    // Per-frame metadata, see kFeatureFrameMetadata. Off until negotiated
+    // on the current connection.
+    atomic<bool>     metadata_enabled_       = false;
+    atomic<uint64_t> next_sequence_          = 0;
+    // Set on connect: the next frame sent is flagged kFrameDiscontinuity.
+    atomic<bool>     metadata_discontinuity_ = true;
+    // Sequence of the last frame sent with metadata. send_mutex_ held.
+    uint64_t         last_sequence_sent_     = 0;
+
+    // FrameResolution raw frames are checked against, 0 until the VHAL
+    // opens a camera or acknowledges camera info on this connection.
+    atomic<uint32_t> negotiated_resolution_ = 0;
+
+    // SendRawFrame() scratch: the vectors for one frame, and the packed
+    // frame when a seqpacket message can't take that many.
+#ifdef IOV_MAX
+    static constexpr size_t kMaxRawIovecs = IOV_MAX;
+#else
+    static constexpr size_t kMaxRawIovecs = 1024;
+#endif
+    std::mutex                raw_frame_mutex_;
+    std::vector<struct iovec> raw_iov_;
+    std::vector<uint8_t>      raw_pack_;
+
+    // Frame pacing, see SetFrameRate(). Disabled until a rate is set.
+    FramePacer pacer_{ 0 };
+
+    // Shared by the CameraStreams, see OpenCameraStream().
+    StreamMux mux_;
+
+    // Async send queue, see EnableAsyncSend().
+    std::unique_ptr<FrameQueue> send_queue_;
+    std::thread                 sender_;
+    atomic<uint64_t>            send_failures_ = 0;
+    // GetStats() counters, updated with relaxed atomics only.
+    atomic<uint64_t> frames_sent_     = 0;
+    atomic<uint64_t> bytes_sent_      = 0;
+    atomic<uint64_t> send_errors_     = 0;
+    atomic<uint64_t> send_blocked_ns_ = 0;
+    LatencyHistogram send_latency_;
+    LatencyHistogram capability_rtt_;
+    // Congestion monitor thread, see EnableCongestionMonitor().
+    std::mutex              congestion_mutex_;
+    std::condition_variable congestion_cv_;
+    bool                    congestion_stop_ = false;
+    std::thread             congestion_monitor_;
+    // VideoCodecType of SendDataPacket() frames, 0 if unknown.
+    atomic<uint32_t>            frame_codec_   = 0;
+
+    // Cuts SendAccessUnits() input into access units.
+    std::mutex                        packetizer_mutex_;
+    std::unique_ptr<AnnexBPacketizer> packetizer_;
+
+    // Shared-memory frame ring, see EnableSharedMemoryRing().
+    UnixStreamSocketClient*    unix_client_      = nullptr;
+    UnixSeqpacketSocketClient* seqpacket_client_ = nullptr;
+    atomic<bool>               shm_enabled_      = false;
+    camera_shm_ring_info_t     shm_info_         = {};
+    int                        shm_fd_           = -1;
+    uint8_t*                   shm_base_         = nullptr;
+    size_t                     shm_len_          = 0;
+    uint32_t                   shm_next_slot_    = 0;
+
+    // Negotiation replayed after a reconnect, see EnableSessionResume().
+    std::mutex                 resume_mutex_;
+    ResumeCallback             resume_callback_;
+    std::vector<camera_info_t> resume_info_;
+    bool                       camera_open_ = false;
+    camera_config_t            open_config_ = {};
+
+    // Capability requests and camera info, see RequestCameraCapability().
+    CapabilityNegotiator negotiator_;
+
+    // Control messages from the VHal, read on the talker thread only.
+    FramedReader reader_;
+
+    // Declared last: its callbacks use every member above.
+    VhalTalker talker_;
+
+    // (Re)create packetizer_ for the frame codec. packetizer_mutex_ held.
+    bool UpdatePacketizer()
+    {
+        auto codec = VideoCodecType(frame_codec_.load());
+        if (codec != VideoCodecType::kH264 && codec != VideoCodecType::kH265) {
+            return false;
+        }
+        if (!packetizer_ || packetizer_->Codec() != codec) {
+            packetizer_ = std::make_unique<AnnexBPacketizer>(codec);
+        }
+        return true;
+    }
+
+    // Sequence number and library flags of a new frame; frame_class is
+    // what the async queue needs to know about it.
+    camera_frame_metadata_t NewFrameMetadata(const uint8_t* packet,
+                                             size_t         size,
+                                             uint64_t       capture_timestamp_ns,
+                                             uint32_t       flags,
+                                             FrameClass&    frame_class)
+    {
+        frame_class = ClassifyAnnexBFrame(
+          VideoCodecType(frame_codec_.load()), packet, size);
+        if (frame_class == FrameClass::kKeyframe) {
+            flags |= kFrameKeyframe;
+        }
+        // The sequence number is taken even if the frame is dropped later,
+        // so that the VHAL sees the gap.
+        return { capture_timestamp_ns, 0, next_sequence_++, flags, 0 };
+    }
+
+    // Why frame can't be sent as a negotiated raw frame, empty if it can.
+    std::string CheckRawFrame(const RawFrame& frame) const
+    {
+        const uint32_t width  = frame.width;
+        const uint32_t height = frame.height;
+        if (frame.format != PixelFormat::kI420 &&
+            frame.format != PixelFormat::kNV12 &&
+            frame.format != PixelFormat::kNV21) {
+            return "Unknown raw frame format";
+        }
+        if (width == 0 || height == 0 || width % 2 || height % 2) {
+            return "Raw frame needs an even, non-zero width and height";
+        }
+        const bool   planar   = frame.format == PixelFormat::kI420;
+        const size_t bytes[3] = { width, planar ? width / 2 : width, width / 2 };
+        for (int p = 0; p < (planar ? 3 : 2); p++) {
+            if (frame.planes[p].data == nullptr ||
+                frame.planes[p].stride < bytes[p]) {
+                return "Raw frame plane " + std::to_string(p) +
+                       " missing or stride too small";
+            }
+        }
+        uint32_t expected_width  = 0;
+        uint32_t expected_height = 0;
+        switch (negotiated_resolution_.load()) {
+            case FrameResolution::k480p:
+                expected_width  = 640;
+                expected_height = 480;
+                break;
+            case FrameResolution::k720p:
+                expected_width  = 1280;
+                expected_height = 720;
+                break;
+            case FrameResolution::k1080p:
+                expected_width  = 1920;
+                expected_height = 1080;
+                break;
+            default:
+                // Nothing negotiated on this connection yet.
+                return "";
+        }
+        if (width != expected_width || height != expected_height) {
+            return "Raw frame is " + std::to_string(width) + "x" +
+                   std::to_string(height) + ", the camera was opened at " +
+                   std::to_string(expected_width) + "x" +
+                   std::to_string(expected_height);
+        }
+        return "";
+    }
+
+    // Copy a plane's rows back to back to dst, return the end.
+    static uint8_t* CopyPlane(const RawFramePlane& plane,
+                              size_t               rows,
+                              size_t               bytes,
+                              uint8_t*             dst)
+    {
+        if (plane.stride == bytes) {
+            memcpy(dst, plane.data, rows * bytes);
+            return dst + rows * bytes;
+        }
+        for (size_t row = 0; row < rows; row++, dst += bytes) {
+            memcpy(dst, plane.data + row * plane.stride, bytes);
+        }
+        return dst;
+    }
+
+    // Bytes the VHAL has yet to read. A write stuck in the kernel is only
+    // counted in send_blocked_ns_ once it returns, this sees it earlier.
+    // Racing a reconnect at worst reads another socket's queue once.
+    size_t SocketBacklog() const
+    {
+        int fd      = socket_client_->GetNativeSocketFd();
+        int pending = 0;
+        if (fd < 0 || ioctl(fd, SIOCOUTQ, &pending) == -1 || pending < 0) {
+            return 0;
+        }
+        return size_t(pending);
+    }
+
+    // Time of a socket write that began at start.
+    void RecordBlocked(std::chrono::steady_clock::time_point start)
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        send_blocked_ns_.fetch_add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+          std::memory_order_relaxed);
+    }
+
+    // A data packet write that began at start; size -1 if it failed.
+    void RecordDataPacket(std::chrono::steady_clock::time_point start,
+                          ssize_t                               size)
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        send_latency_.Record(elapsed);
+        send_blocked_ns_.fetch_add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+          std::memory_order_relaxed);
+        if (size == -1) {
+            send_errors_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        frames_sent_.fetch_add(1, std::memory_order_relaxed);
+        bytes_sent_.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static IOResult DataPacketResult(ssize_t sent, const std::error_code& ec)
+    {
+        if (sent == 0 && ec == std::errc::no_buffer_space) {
+            return { 0, "Send queue full, frame dropped" };
+        }
+        if (ec == std::errc::no_buffer_space) {
+            return { -1, "No free slot in shared-memory ring" };
+        }
+        if (ec) {
+            return { -1, "Error in writing payload to Camera VHal: " + ec.message() };
+        }
+        return { sent, "" };
+    }
+
+    static uint64_t MonotonicNowNs()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return uint64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+
+    // Fill in what is only known at write time. send_mutex_ held, so
+    // frames are stamped in the order they go out.
+    void StampFrameMetadata(camera_frame_metadata_t& metadata)
+    {
+        if (metadata_discontinuity_.exchange(false) ||
+            metadata.sequence != last_sequence_sent_ + 1) {
+            metadata.flags |= kFrameDiscontinuity;
+        }
+        last_sequence_sent_        = metadata.sequence;
+        metadata.send_timestamp_ns = MonotonicNowNs();
+    }
+
+    // Replay the last acknowledged camera info on a new connection and
+    // report the outcome once, see EnableSessionResume(). Both requests are
+    // queued at once: the info goes out as soon as the capability is in,
+    // without a round trip through the application.
+    void ResumeSession()
+    {
+        std::vector<camera_info_t> camera_info;
+        {
+            std::lock_guard<std::mutex> lock(resume_mutex_);
+            if (!resume_callback_ || resume_info_.empty()) {
+                return;
+            }
+            camera_info = resume_info_;
+        }
+        auto event = std::make_shared<ResumeEvent>();
+        RequestCameraCapability(
+          kNegotiationTimeout,
+          [event](std::shared_ptr<camera_capability_t> capability) {
+              event->capability = move(capability);
+          });
+        SendCameraInfo(
+          move(camera_info), kNegotiationTimeout, [this, event](bool acked) {
+              ResumeCallback callback;
+              {
+                  std::lock_guard<std::mutex> lock(resume_mutex_);
+                  callback             = resume_callback_;
+                  event->acked         = acked;
+                  event->camera_open   = camera_open_;
+                  event->camera_config = open_config_;
+              }
+              // The camera stays open from the application's point of view.
+              if (acked && event->camera_open) {
+                  negotiated_resolution_ = event->camera_config.resolution;
+              }
+              if (callback) {
+                  callback(*event);
+              }
+          });
+    }
+
+    // Keep the first failure in result; later access units still go out.
+    void SendAccessUnit(const uint8_t* au, size_t size, IOResult& result)
+    {
+        auto [sent, error_msg] = SendDataPacket(au, size);
+        if (sent == -1 && get<0>(result) != -1) {
+            result = { -1, error_msg };
+        }
+    }
+
+    VhalTalker::Ops TalkerOps()
+    {
+        VhalTalker::Ops ops;
+        ops.connect   = [this]() { return socket_client_->Connect(); };
+        ops.connected = [this]() { return socket_client_->Connected(); };
+        ops.fd        = [this]() { return socket_client_->GetNativeSocketFd(); };
+        ops.close     = [this]() { socket_client_->Close(); };
+        ops.on_connected = [this]() {
+            VHAL_LOG(kInfo) << "Connected to Camera VHal!";
+            // The new peer has to ask for metadata again.
+            metadata_enabled_       = false;
+            metadata_discontinuity_ = true;
+            negotiated_resolution_  = 0;
+            OnReconnected();
+            negotiator_.OnConnected();
+            {
+                std::lock_guard<std::mutex> lock(connect_mutex_);
+                connections_++;
+            }
+            connect_cv_.notify_all();
+            ResumeSession();
+        };
+        ops.on_connect_failed = [](const std::string& error_msg,
+                                   std::chrono::milliseconds retry_in) {
+            VHAL_LOG(kWarning)
+              << "VideoSink Failed to connect to Camera VHal: " << error_msg
+              << ". Retry in " << retry_in.count() << "ms...";
+        };
+        ops.on_event = [this](short revents) { return OnVhalEvent(revents); };
+        return ops;
+    }
+
+    CapabilityNegotiator::Ops NegotiatorOps()
+    {
+        CapabilityNegotiator::Ops ops;
+        ops.request_capability = [this]() {
+            camera_header_t header = { camera_packet_type_t::REQUST_CAPABILITY, 0 };
+            auto [sent, error_msg] = SendRawPacket(
+              reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+            if (sent == -1) {
+                VHAL_LOG(kError) << "Error in sending request capability "
+                                    "header to Camera VHal: "
+                                 << error_msg;
+                return false;
+            }
+            return true;
+        };
+        ops.send_camera_info = [this](const std::vector<camera_info_t>& camera_info) {
+            camera_header_t header = {
+                camera_packet_type_t::CAMERA_INFO,
+                static_cast<uint32_t>(camera_info.size() * sizeof(camera_info_t))
+            };
+            struct iovec iov[2] = {
+                { &header, sizeof(header) },
+                { const_cast<camera_info_t*>(camera_info.data()), header.size },
+            };
+            IOResult response;
+            auto     start = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(send_mutex_);
+                response =
+                  socket_client_->SendAll(iov, std::size(iov), send_timeout_ms_);
+            }
+            RecordBlocked(start);
+            if (get<0>(response) == -1) {
+                VHAL_LOG(kError) << "Error in sending config to Camera VHal: "
+                                 << get<1>(response);
+                return false;
+            }
+            return true;
+        };
+        return ops;
+    }
+
+    // Handle poll() events of the VHal socket, false to reconnect.
+    bool OnVhalEvent(short revents)
+    {
+        if (tcp_client_ && (revents & POLLERR) &&
+            ReapZeroCopyCompletions() > 0) {
+            // Zero-copy completions are signalled via POLLERR.
+            revents &= ~POLLERR;
+            if (!revents) {
+                return true;
+            }
+        }
+        if (!(revents & POLLIN)) {
+            if (revents & (POLLERR|POLLHUP|POLLNVAL)) {
+                VHAL_LOG(kError) << "VideoSink Poll Fail event: "
+                                 << revents
+                                 << ", reconnect";
+                return false;
+            }
+            VHAL_LOG(kDebug) << "VideoSink : Poll revents " << revents;
+            return true;
+        }
+        auto [received, error_msg] = reader_.Fill();
+        if (received <= 0) {
+            VHAL_LOG(kError) << "Failed to read from Camera VHal: " << error_msg
+                             << ", going to disconnect and reconnect.";
+            return false;
+        }
+        // Handle every complete message; a partial one stays buffered until
+        // the rest of it arrives.
+        camera_header_t cmd_header;
+        while (reader_.Peek(&cmd_header, sizeof(cmd_header)) &&
+               reader_.Buffered() >=
+                 sizeof(cmd_header) + MessageBodySize(cmd_header.type)) {
+            reader_.Consume(sizeof(cmd_header));
+            VHAL_LOG(kDebug) << "Camera VHal has some message for us!";
+            if (!HandleMessage(cmd_header)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static size_t MessageBodySize(camera_packet_type_t type)
+    {
+        switch (type) {
+            case camera_packet_type_t::CAPABILITY:
+                return sizeof(camera_capability_t);
+            case camera_packet_type_t::ACK:
+                return sizeof(CameraAck);
+            case camera_packet_type_t::CAMERA_CONFIG:
+                return sizeof(camera_config_cmd_t);
+            default:
+                return 0;
+        }
+    }
+
+    bool HandleMessage(const camera_header_t& cmd_header)
+    {
+        switch(cmd_header.type) {
+            case camera_packet_type_t::CAPABILITY:
+                VHAL_LOG(kDebug) << "received capability";
+                return handle_capability();
+
+            case camera_packet_type_t::ACK:
+                VHAL_LOG(kDebug) << "received ack";
+                return handle_ack();
+
+            case camera_packet_type_t::CAMERA_CONFIG:
+                VHAL_LOG(kDebug) << "received config";
+                return handle_cmd();
+
+            default :
+                VHAL_LOG(kError) << "invalid header type received";
+                return true;
+        }
+    }
 
-    std::shared_ptr<camera_capability_t> cmd_capability_;
-    std::mutex mutex_;
-    std::condition_variable wait_api_data;
+    // Read zero-copy notifications and hand finished packets back to the
+    // producer. Returns the number of notifications read.
+    int ReapZeroCopyCompletions()
+    {
+        int count = tcp_client_->ReadZeroCopyCompletions(
+          [this](uint32_t lo, uint32_t hi) {
+              std::lock_guard<std::mutex> lock(zerocopy_mutex_);
+              for (auto& entry : zerocopy_pending_) {
+                  if (entry.generation != connection_generation_) {
+                      continue;
+                  }
+                  // While a send is in flight, every id from first_id on
+                  // belongs to it; sends are never concurrent.
+                  uint64_t end  = entry.sent ? entry.end_id : UINT64_MAX;
+                  uint64_t from = std::max<uint64_t>(lo, entry.first_id);
+                  uint64_t to   = std::min<uint64_t>(uint64_t(hi) + 1, end);
+                  if (to > from) {
+                      entry.completed += to - from;
+                  }
+              }
+          });
+        ReleaseZeroCopyPackets(false);
+        return count;
+    }
 
+    // Release packets whose ids all completed, whose send failed, or which
+    // belong to a previous connection. all=true releases everything.
+    void ReleaseZeroCopyPackets(bool all)
+    {
+        std::list<ZeroCopyPacket> done;
+        {
+            std::lock_guard<std::mutex> lock(zerocopy_mutex_);
+            for (auto it = zerocopy_pending_.begin();
+                 it != zerocopy_pending_.end();) {
+                auto next = std::next(it);
+                bool finished =
+                  it->sent &&
+                  (it->failed || it->generation != connection_generation_ ||
+                   it->completed >= uint64_t(it->end_id - it->first_id));
+                if (all || finished) {
+                    done.splice(done.end(), zerocopy_pending_, it);
+                }
+                it = next;
+            }
+        }
+        for (auto& entry : done) {
+            if (entry.release) {
+                entry.release(entry.packet);
+            }
+            entry.owned.Reset();
+        }
+    }
+
+    // Zero-copy ids restart on a new socket, anything still pending from
+    // the old one will never be notified.
+    void OnReconnected()
+    {
+        reader_.Reset();
+        if (shm_enabled_) {
+            AnnounceSharedRing();
+        }
+        if (tcp_client_ == nullptr) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(zerocopy_mutex_);
+            connection_generation_++;
+        }
+        ReleaseZeroCopyPackets(false);
+    }
+
+    static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t) &&
+                    alignof(atomic<uint32_t>) == alignof(uint32_t),
+                  "slot states are shared as plain uint32_t");
+
+    atomic<uint32_t>& SlotState(uint32_t idx)
+    {
+        return reinterpret_cast<atomic<uint32_t>*>(
+          shm_base_ + sizeof(camera_shm_ring_info_t))[idx];
+    }
+
+    // Hand the ring to a (new) VHAL connection. READY slots were queued for
+    // the previous peer and will never be consumed, so give them back;
+    // WRITING slots still belong to the producer.
+    void AnnounceSharedRing()
+    {
+        for (uint32_t i = 0; i < shm_info_.slot_count; i++) {
+            uint32_t expected = SHM_SLOT_READY;
+            SlotState(i).compare_exchange_strong(expected, SHM_SLOT_FREE);
+        }
+        camera_header_t header = { camera_packet_type_t::CAMERA_SHM_RING,
+                                   sizeof(shm_info_) };
+        struct iovec iov[2] = {
+            { &header, sizeof(header) },
+            { &shm_info_, sizeof(shm_info_) },
+        };
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        auto [sent, error_msg] =
+          unix_client_ ? unix_client_->SendFd(iov, std::size(iov), shm_fd_)
+                       : seqpacket_client_->SendFd(iov, std::size(iov), shm_fd_);
+        if (sent == -1) {
+            VHAL_LOG(kError)
+              << "Failed to send shared-memory ring to Camera VHal: "
+              << error_msg;
+            ResetConnection();
+        }
+    }
+
+    // One CAMERA_STREAM_DATA chunk. Like any other message it must not be
+    // interleaved with a concurrent write, hence send_mutex_.
+    ssize_t SendStreamChunk(const struct iovec* iov, int iovcnt, std::error_code& ec)
+    {
+        auto    start = std::chrono::steady_clock::now();
+        ssize_t sent;
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            sent = socket_client_->SendAll(iov, iovcnt, send_timeout_ms_, ec);
+        }
+        RecordBlocked(start);
+        if (sent == -1) {
+            ResetConnection();
+        }
+        return sent;
+    }
+
+    // A failed or timed out SendAll() may leave a partial packet in the
+    // stream. Shut the socket down so the talker thread sees the hangup and
+    // reconnects with clean framing.
+    void ResetConnection()
+    {
+        int fd = socket_client_->GetNativeSocketFd();
+        if (fd >= 0) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    // Messages are only dispatched once complete, so this never waits.
     IOResult RecvPacket(uint8_t* packet, size_t size)
     {
-        std::tuple<ssize_t, std::string> response;
-        response = socket_client_->Recv(
-            packet, size, MSG_WAITALL);
-        return response;
+        if (!reader_.Next(packet, size)) {
+            return { -1, "Incomplete message" };
+        }
+        return { size, "" };
     }
 };
 
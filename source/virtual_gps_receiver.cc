@@ -1,11 +1,14 @@
 
 #include "virtual_gps_receiver.h"
+#include "vhal_talker.h"
 #include "receiver_log.h"
+#include "socket_io.h"
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netinet/in.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -21,10 +24,27 @@ const std::string VirtualGpsReceiver::gpsStartMsg =
 const std::string VirtualGpsReceiver::gpsStopMsg = "{ \"key\" : \"gps-stop\" }";
 const unsigned int VirtualGpsReceiver::mDebug    = 0;
 
-VirtualGpsReceiver::VirtualGpsReceiver(struct TcpConnectionInfo tci) : mTci(tci)
+VirtualGpsReceiver::VirtualGpsReceiver(struct TcpConnectionInfo tci)
+  : mTci(tci)
 {
-    mWorkThread = std::unique_ptr<std::thread>(
-      new std::thread(&VirtualGpsReceiver::workThreadProc, this));
+    VhalTalker::Ops ops;
+    ops.connect   = [this]() { return Connect(); };
+    ops.connected = [this]() { return Connected(); };
+    ops.fd        = [this]() { return mSockGps; };
+    ops.close     = [this]() { Disconnect(); };
+    ops.on_connected = []() {
+        AIC_LOG(LIBVHAL_DEBUG, "Connected to GPS server.");
+    };
+    ops.on_connect_failed = [](const std::string&        error_msg,
+                               std::chrono::milliseconds retry_in) {
+        AIC_LOG(LIBVHAL_ERROR,
+                "Can't connect to GPS remote, %s. Retry in %lldms",
+                error_msg.c_str(),
+                static_cast<long long>(retry_in.count()));
+    };
+    ops.on_event = [this](short revents) { return OnSocketEvent(revents); };
+    mTalker = std::make_unique<VhalTalker>(std::move(ops), mTci.event_loop);
+    mTalker->Start();
 }
 
 VirtualGpsReceiver::~VirtualGpsReceiver()
@@ -33,10 +53,10 @@ VirtualGpsReceiver::~VirtualGpsReceiver()
         std::unique_lock<std::mutex> lock(mMutex);
         mStop = true;
     }
+    mTalker->Stop();
     if (mSockGps >= 0) {
         Disconnect();
     }
-    mWorkThread->join();
 }
 
 ConnectionResult
@@ -62,6 +82,13 @@ VirtualGpsReceiver::Connect()
         error_msg = std::strerror(errno);
         return { false, error_msg };
     }
+    auto option_errors =
+      socket_io::ApplySocketOptions(mSockGps, mTci.socket_options, true);
+    if (!option_errors.empty()) {
+        AIC_LOG(LIBVHAL_ERROR,
+                "GPS socket options not applied: %s",
+                option_errors.c_str());
+    }
 
     struct sockaddr_in addr;
     memset(&addr, 0, sizeof(struct sockaddr_in));
@@ -69,13 +96,10 @@ VirtualGpsReceiver::Connect()
     addr.sin_port   = htons(mPort);
     inet_pton(AF_INET, mTci.ip_addr.c_str(), &addr.sin_addr);
 
-    int res =
-      connect(mSockGps, (struct sockaddr*)&addr, sizeof(struct sockaddr_in));
-    if (res < 0) {
-        AIC_LOG(LIBVHAL_ERROR,
-                "Can't connect to GPS remote, %s",
-                strerror(errno));
-        error_msg = std::strerror(errno);
+    bool connected;
+    std::tie(connected, error_msg) = socket_io::Connect(
+      mSockGps, (struct sockaddr*)&addr, sizeof(struct sockaddr_in));
+    if (!connected) {
         close(mSockGps);
         mSockGps = -1;
         return { false, error_msg };
@@ -176,82 +200,60 @@ VirtualGpsReceiver::Read(uint8_t* buf, size_t len)
     return { offset > 0 ? offset : size, error_msg };
 }
 
-void
-VirtualGpsReceiver::workThreadProc()
+bool
+VirtualGpsReceiver::OnSocketEvent(short revents)
 {
-    while (true) {
-        {
-            std::unique_lock<std::mutex> lock(mMutex);
-            if (mStop) {
-                AIC_LOG(LIBVHAL_WARNING,
-                        "mStop = %s. Break from while.",
-                        mStop ? "true" : "false");
-                break;
-            }
-        }
+    if (!(revents & POLLIN)) {
+        AIC_LOG(LIBVHAL_WARNING,
+                "GPS socket poll event %d, try to connect again",
+                revents);
+        return false;
+    }
 
-        if (!Connected()) {
-            AIC_LOG(LIBVHAL_WARNING,
-                    "Not connected to GPS server. Need to connect again.");
-            IOResult ior = Connect();
-            if (!std::get<0>(ior)) {
-                sleep(3);
-                AIC_LOG(LIBVHAL_ERROR, "Try to connect GPS server again");
-                continue;
-            } else {
-                AIC_LOG(LIBVHAL_DEBUG, "Connected to GPS server.");
-            }
-        }
+    char     cmd = 0xFF;
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(&cmd);
+    IOResult ior = Read(ptr, sizeof(cmd));
+    int      res = std::get<0>(ior);
+    if (res != sizeof(cmd)) {
+        AIC_LOG(LIBVHAL_WARNING,
+                "%s",
+                mStop ? "mStop = true. Stop"
+                      : "Read error, try to connect and read again");
+        return false;
+    }
 
-        char     cmd = 0xFF;
-        uint8_t* ptr = reinterpret_cast<uint8_t*>(&cmd);
-        IOResult ior = Read(ptr, sizeof(cmd));
-        int      res = std::get<0>(ior);
-        if (res < 0) {
-            AIC_LOG(LIBVHAL_WARNING,
-                    "%s",
-                    mStop ? "mStop = true. Stop"
-                          : "Read error, try to connect and read again");
-        } else if (res == sizeof(cmd)) {
-            uint32_t command;
-            switch (cmd) {
-                case GPS_CMD_QUIT:
-                    command = Command::kGpsQuit;
-                    AIC_LOG(LIBVHAL_DEBUG, "GPS_CMD_QUIT");
-                    if (nullptr != mGpsCmdHandler)
-                        mGpsCmdHandler(static_cast<uint32_t>(command));
-                    else
-                        AIC_LOG(LIBVHAL_WARNING, "mGpsCmdHandler is nullptr");
-                    break;
-                case GPS_CMD_START:
-                    command = Command::kGpsStart;
-                    AIC_LOG(LIBVHAL_DEBUG, "GPS_CMD_START");
-                    if (nullptr != mGpsCmdHandler)
-                        mGpsCmdHandler(static_cast<uint32_t>(command));
-                    else
-                        AIC_LOG(LIBVHAL_WARNING, "mGpsCmdHandler is nullptr");
-                    break;
-                case GPS_CMD_STOP:
-                    command = Command::kGpsStop;
-                    AIC_LOG(LIBVHAL_DEBUG, "GPS_CMD_STOP");
-                    if (nullptr != mGpsCmdHandler)
-                        mGpsCmdHandler(static_cast<uint32_t>(command));
-                    else
-                        AIC_LOG(LIBVHAL_WARNING, "mGpsCmdHandler is nullptr");
-                    break;
+    uint32_t command;
+    switch (cmd) {
+        case GPS_CMD_QUIT:
+            command = Command::kGpsQuit;
+            AIC_LOG(LIBVHAL_DEBUG, "GPS_CMD_QUIT");
+            if (nullptr != mGpsCmdHandler)
+                mGpsCmdHandler(static_cast<uint32_t>(command));
+            else
+                AIC_LOG(LIBVHAL_WARNING, "mGpsCmdHandler is nullptr");
+            break;
+        case GPS_CMD_START:
+            command = Command::kGpsStart;
+            AIC_LOG(LIBVHAL_DEBUG, "GPS_CMD_START");
+            if (nullptr != mGpsCmdHandler)
+                mGpsCmdHandler(static_cast<uint32_t>(command));
+            else
+                AIC_LOG(LIBVHAL_WARNING, "mGpsCmdHandler is nullptr");
+            break;
+        case GPS_CMD_STOP:
+            command = Command::kGpsStop;
+            AIC_LOG(LIBVHAL_DEBUG, "GPS_CMD_STOP");
+            if (nullptr != mGpsCmdHandler)
+                mGpsCmdHandler(static_cast<uint32_t>(command));
+            else
+                AIC_LOG(LIBVHAL_WARNING, "mGpsCmdHandler is nullptr");
+            break;
 
-                default:
-                    AIC_LOG(LIBVHAL_ERROR, "GPS unkown command. cmd = %c", cmd);
-                    break;
-            }
-        } else {
-            AIC_LOG(LIBVHAL_ERROR,
-                    "GPS work thread, should not be here, res %d",
-                    res);
+        default:
+            AIC_LOG(LIBVHAL_ERROR, "GPS unkown command. cmd = %c", cmd);
             break;
-        }
     }
-    AIC_LOG(LIBVHAL_DEBUG, "GPS work thread exit");
+    return true;
 }
 
 bool
@@ -20,16 +20,15 @@ VirtualInputReceiver::~VirtualInputReceiver()
 bool
 VirtualInputReceiver::CreateTouchDevice(struct UnixConnectionInfo uci)
 {
-    printf("%s:%d Create virtual touch channel\n", __func__, __LINE__);
+    AIC_LOG(LIBVHAL_DEBUG, "Create virtual touch channel");
     mFd = open(uci.socket_dir.c_str(), O_RDWR | O_NONBLOCK, 0);
     if (mFd < 0) {
-        perror("Failed to open pipe for read error");
+        AIC_LOG(LIBVHAL_ERROR,
+                "Failed to open pipe for read error: %s",
+                strerror(errno));
         return false;
     } else {
-        printf("%s:%d Open %s successfully.\n",
-               __func__,
-               __LINE__,
-               uci.socket_dir.c_str());
+        AIC_LOG(LIBVHAL_DEBUG, "Open %s successfully.", uci.socket_dir.c_str());
     }
     return true;
 }
@@ -49,10 +48,11 @@ VirtualInputReceiver::SendEvent(uint16_t type, uint16_t code, int32_t value)
     ev.value        = value;
 
     if (mDebug)
-        AIC_LOG(mDebug, "type: %d code: %d value: %d", type, code, value);
+        AIC_LOG(
+          LIBVHAL_DEBUG, "type: %d code: %d value: %d", type, code, value);
 
     if (write(mFd, &ev, sizeof(struct input_event)) < 0) {
-        perror("Failed to send event\n");
+        AIC_LOG(LIBVHAL_ERROR, "Failed to send event: %s", strerror(errno));
         return false;
     }
     return true;
@@ -168,7 +168,7 @@ VirtualInputReceiver::ProcessOneCommand(const std::string& cmd)
     int32_t ms       = 0;
 
     if (mDebug)
-        AIC_LOG(mDebug, "cmd: %s", cmd.c_str());
+        AIC_LOG(LIBVHAL_DEBUG, "cmd: %s", cmd.c_str());
 
     switch (cmd[0]) {
         case 'c': // commit
@@ -189,13 +189,12 @@ VirtualInputReceiver::ProcessOneCommand(const std::string& cmd)
                 (uint32_t)x > kMaxPositionX || y < 0 ||
                 (uint32_t)y > kMaxPositionY || pressure < 0 ||
                 (uint32_t)pressure > kMaxPressure) {
-                printf(
-                  "%s: Error: Parameter error. slot=%d x=%d y=%d pressure=%d\n",
-                  __func__,
-                  slot,
-                  x,
-                  y,
-                  pressure);
+                AIC_LOG(LIBVHAL_ERROR,
+                        "Parameter error. slot=%d x=%d y=%d pressure=%d",
+                        slot,
+                        x,
+                        y,
+                        pressure);
                 return false;
             }
             SendDown(slot, x, y, pressure);
@@ -203,7 +202,7 @@ VirtualInputReceiver::ProcessOneCommand(const std::string& cmd)
         case 'u': // up
             sscanf(cmd.c_str(), "%c %d", &type, &slot);
             if (slot < 0 || (uint32_t)slot > kMaxSlot) {
-                printf("%s: Error: Parameter error. slot=%d\n", __func__, slot);
+                AIC_LOG(LIBVHAL_ERROR, "Parameter error. slot=%d", slot);
                 return false;
             }
             SendUp(slot);
@@ -220,13 +219,12 @@ VirtualInputReceiver::ProcessOneCommand(const std::string& cmd)
                 (uint32_t)x > kMaxPositionX || y < 0 ||
                 (uint32_t)y > kMaxPositionY || pressure < 0 ||
                 (uint32_t)pressure > kMaxPressure) {
-                printf(
-                  "%s: Error: Parameter error. slot=%d x=%d y=%d pressure=%d\n",
-                  __func__,
-                  slot,
-                  x,
-                  y,
-                  pressure);
+                AIC_LOG(LIBVHAL_ERROR,
+                        "Parameter error. slot=%d x=%d y=%d pressure=%d",
+                        slot,
+                        x,
+                        y,
+                        pressure);
                 return false;
             }
             SendMove(slot, x, y, pressure);
@@ -234,7 +232,7 @@ VirtualInputReceiver::ProcessOneCommand(const std::string& cmd)
         case 'w': // wait ms
             sscanf(cmd.c_str(), "%c %d", &type, &ms);
             if (ms <= 0) {
-                printf("%s: Error: Parameter error. ms=%d\n", __func__, ms);
+                AIC_LOG(LIBVHAL_ERROR, "Parameter error. ms=%d", ms);
                 return false;
             }
             SendWait(ms);
@@ -308,7 +306,7 @@ bool
 VirtualInputReceiver::ProcessOneJoystickCommand(const std::string& cmd)
 {
     if (mDebug)
-        printf("%s\n", __func__);
+        AIC_LOG(LIBVHAL_DEBUG, "%s", __func__);
 
     char     type = 0;
     uint16_t code;
@@ -317,7 +315,7 @@ VirtualInputReceiver::ProcessOneJoystickCommand(const std::string& cmd)
     switch (cmd[0]) {
         case 'c': // Commit
             if (mDebug)
-                printf("SendCommit\n");
+                AIC_LOG(LIBVHAL_DEBUG, "SendCommit");
             SendCommit();
             break;
 
@@ -328,7 +326,7 @@ VirtualInputReceiver::ProcessOneJoystickCommand(const std::string& cmd)
                    &code,
                    &value);
             if (mDebug)
-                printf("code = %d, value = %d\n", code, value);
+                AIC_LOG(LIBVHAL_DEBUG, "code = %d, value = %d", code, value);
             SendEvent(EV_KEY, code, value);
             break;
 
@@ -339,7 +337,7 @@ VirtualInputReceiver::ProcessOneJoystickCommand(const std::string& cmd)
                    &code,
                    &value);
             if (mDebug)
-                printf("code = %d, value = %d\n", code, value);
+                AIC_LOG(LIBVHAL_DEBUG, "code = %d, value = %d", code, value);
             SendEvent(EV_MSC, code, value);
             break;
 
@@ -350,32 +348,32 @@ VirtualInputReceiver::ProcessOneJoystickCommand(const std::string& cmd)
                    &code,
                    &value);
             if (mDebug)
-                printf("code = %d, value = %d\n", code, value);
+                AIC_LOG(LIBVHAL_DEBUG, "code = %d, value = %d", code, value);
             SendEvent(EV_ABS, code, value);
             break;
         case 'i': // insert joystick
             if (mDebug)
-                printf("%s:%d enable joystick down\n", __func__, __LINE__);
+                AIC_LOG(LIBVHAL_DEBUG, "enable joystick down");
             SendEvent(EV_KEY, 631, 1);
             SendCommit();
 
             usleep(2000);
 
             if (mDebug)
-                printf("%s:%d enable joystick up\n", __func__, __LINE__);
+                AIC_LOG(LIBVHAL_DEBUG, "enable joystick up");
             SendEvent(EV_KEY, 631, 0);
             SendCommit();
             break;
         case 'p': // pull out joystick
             if (mDebug)
-                printf("%s:%d disable joystick down\n", __func__, __LINE__);
+                AIC_LOG(LIBVHAL_DEBUG, "disable joystick down");
             SendEvent(EV_KEY, 632, 1);
             SendCommit();
 
             usleep(2000);
 
             if (mDebug)
-                printf("%s:%d disable joystick up\n", __func__, __LINE__);
+                AIC_LOG(LIBVHAL_DEBUG, "disable joystick up");
             SendEvent(EV_KEY, 632, 0);
             SendCommit();
 
@@ -392,7 +390,7 @@ VirtualInputReceiver::onKeyCode(uint16_t scanCode, uint32_t mask)
     std::string error_msg = "";
 
     if (mDebug)
-        printf("%s\n", __func__);
+        AIC_LOG(LIBVHAL_DEBUG, "%s", __func__);
 
     if (mask & KEY_STATE_MASK::Shift) {
         SendEvent(EV_KEY, KEY_LEFTSHIFT, 1);
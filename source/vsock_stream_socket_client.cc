@@ -26,8 +26,9 @@
 namespace vhal {
 namespace client {
 VsockStreamSocketClient::VsockStreamSocketClient(
-  const int android_vm_cid)
-  : impl_{ std::make_unique<Impl>(android_vm_cid) }
+  const int            android_vm_cid,
+  const SocketOptions& options)
+  : impl_{ std::make_unique<Impl>(android_vm_cid, options) }
 {}
 
 VsockStreamSocketClient::~VsockStreamSocketClient() = default;
@@ -53,14 +54,78 @@ VsockStreamSocketClient::GetNativeSocketFd() const
 IOResult
 VsockStreamSocketClient::Send(const uint8_t* data, size_t size)
 {
+    std::error_code ec;
+    ssize_t         sent = impl_->Send(data, size, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+VsockStreamSocketClient::Send(const uint8_t* data, size_t size, std::error_code& ec)
+{
+    return impl_->Send(data, size, ec);
+}
+
+IOResult
+VsockStreamSocketClient::SendV(const struct iovec* iov, int iovcnt)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendV(iov, iovcnt, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+VsockStreamSocketClient::SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
+{
+    return impl_->SendV(iov, iovcnt, ec);
+}
+
+IOResult
+VsockStreamSocketClient::SendAll(const uint8_t* data, size_t size, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = SendAll(data, size, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
 
-    return impl_->Send(data, size);
+ssize_t
+VsockStreamSocketClient::SendAll(const uint8_t*   data,
+                                size_t           size,
+                                int              timeout_ms,
+                                std::error_code& ec)
+{
+    struct iovec iov = { const_cast<uint8_t*>(data), size };
+    return impl_->SendAll(&iov, 1, timeout_ms, ec);
 }
 
 IOResult
-VsockStreamSocketClient::Recv(uint8_t* data, size_t size, uint8_t flag)
+VsockStreamSocketClient::SendAll(const struct iovec* iov, int iovcnt, int timeout_ms)
+{
+    std::error_code ec;
+    ssize_t         sent = impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+    return socket_io::ToIOResult(sent, ec);
+}
+
+ssize_t
+VsockStreamSocketClient::SendAll(const struct iovec* iov,
+                                int                 iovcnt,
+                                int                 timeout_ms,
+                                std::error_code&    ec)
+{
+    return impl_->SendAll(iov, iovcnt, timeout_ms, ec);
+}
+
+IOResult
+VsockStreamSocketClient::Recv(uint8_t* data, size_t size, int flag)
+{
+    std::error_code ec;
+    ssize_t         received = impl_->Recv(data, size, flag, ec);
+    return socket_io::ToIOResult(received, ec);
+}
+
+ssize_t
+VsockStreamSocketClient::Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
 {
-    return impl_->Recv(data, size, flag);
+    return impl_->Recv(data, size, flag, ec);
 }
 
 void
@@ -23,6 +23,8 @@
 #define VSOCK_STREAM_SOCKET_CLIENT_IMPL_H
 
 #include "vsock_stream_socket_client.h"
+#include "socket_io.h"
+#include "vhal_log.h"
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
@@ -48,7 +50,8 @@ namespace client {
 class VsockStreamSocketClient::Impl
 {
 public:
-    Impl(const int android_vm_cid)
+    Impl(const int android_vm_cid, const SocketOptions& options)
+      : options_{ options }
     {
         server_.svm_cid = android_vm_cid;
         server_.svm_family = AF_VSOCK;
@@ -68,10 +71,9 @@ public:
         if (fd_ < 0) {
             throw std::system_error(errno, std::system_category());
         }
-        connected_ = ::connect(fd_, (struct sockaddr*)&server_, sizeof(server_)) == 0;
-        if (!connected_) {
-            error_msg = std::strerror(errno);
-        }
+        ApplyOptions();
+        std::tie(connected_, error_msg) = socket_io::Connect(
+          fd_, (struct sockaddr*)&server_, sizeof(server_));
         return { connected_, error_msg };
     }
 
@@ -79,31 +81,67 @@ public:
 
     int GetNativeSocketFd() const { return fd_; }
 
-    IOResult Send(const uint8_t* data, size_t size)
+    ssize_t Send(const uint8_t* data, size_t size, std::error_code& ec)
     {
-        std::string error_msg = "";
-
         ssize_t sent = ::send(fd_, data, size, 0);
-        if (sent  == -1) {
-            std::cout << ". Send() args: fd: " << fd_
-                      << ", size: " << size << "\n";
-            error_msg = std::strerror(errno);
+        if (sent == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kError) << "Send() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", size: " << size;
+        } else {
+            ec.clear();
         }
-        return { sent, error_msg };
+        return sent;
     }
 
-    IOResult Recv(uint8_t* data, size_t size, uint8_t flag)
+    ssize_t SendV(const struct iovec* iov, int iovcnt, std::error_code& ec)
     {
-        std::string error_msg = "";
-        ssize_t received = ::recv(fd_, data, size, flag);
-        if (received  == -1) {
-            std::cout << ". Recv() args: fd: " << fd_
-                      << ", size: " << size << "\n";
-            error_msg = std::strerror(errno);
+        struct msghdr msg = {};
+        msg.msg_iov    = const_cast<struct iovec*>(iov);
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t sent = ::sendmsg(fd_, &msg, 0);
+        if (sent == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kError) << "SendV() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt;
+        } else {
+            ec.clear();
         }
-        return { received, error_msg };
+        return sent;
     }
 
+    ssize_t SendAll(const struct iovec* iov,
+                    int                 iovcnt,
+                    int                 timeout_ms,
+                    std::error_code&    ec)
+    {
+        timeout_ms   = socket_io::SendTimeout(timeout_ms, options_);
+        ssize_t sent = socket_io::SendAll(fd_, iov, iovcnt, timeout_ms, ec);
+        if (sent == -1) {
+            VHAL_LOG(kError) << "SendAll() failed: " << ec.message()
+                             << ", fd: " << fd_
+                             << ", iovcnt: " << iovcnt
+                             << ", timeout_ms: " << timeout_ms;
+        }
+        return sent;
+    }
+
+    ssize_t Recv(uint8_t* data, size_t size, int flag, std::error_code& ec)
+    {
+        ssize_t received = ::recv(fd_, data, size, flag);
+        if (received == -1) {
+            ec = socket_io::LastError();
+            VHAL_LOG(kWarning) << "Recv() failed: " << ec.message()
+                               << ", fd: " << fd_
+                               << ", size: " << size;
+        } else {
+            ec.clear();
+        }
+        return received;
+    }
 
     void Close() {
         connected_ = false;
@@ -114,9 +152,18 @@ public:
     }
 
 private:
+    void ApplyOptions()
+    {
+        auto errors = socket_io::ApplySocketOptions(fd_, options_, false);
+        if (!errors.empty()) {
+            VHAL_LOG(kWarning) << "Socket options not applied: " << errors;
+        }
+    }
+
     int  fd_ = -1;
     bool connected_ = false;
     struct sockaddr_vm server_;
+    SocketOptions      options_;
 };
 
 } // namespace client
@@ -0,0 +1,209 @@
+/**
+ * @file test_annexb_packetizer.cc
+ * @brief Access-unit splitting of the sample H.264/H.265 streams.
+ * @version 0.1
+ * @date 2021-08-24
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "annexb_packetizer.h"
+#include "loopback_stream_socket_client.h"
+#include "nal_classifier.h"
+#include "video_sink.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+std::vector<uint8_t>
+ReadFile(const std::string& name)
+{
+    std::ifstream file(std::string(TEST_DATA_DIR) + "/" + name,
+                       std::ios::binary);
+    REQUIRE(file.is_open());
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file),
+                                std::istreambuf_iterator<char>());
+}
+
+std::vector<std::vector<uint8_t>>
+Packetize(VideoSink::VideoCodecType   codec,
+          const std::vector<uint8_t>& stream,
+          size_t                      piece)
+{
+    std::vector<std::vector<uint8_t>> units;
+    auto emit = [&units](const uint8_t* au, size_t size) {
+        units.emplace_back(au, au + size);
+    };
+    AnnexBPacketizer packetizer(codec);
+    for (size_t offset = 0; offset < stream.size(); offset += piece) {
+        packetizer.Push(stream.data() + offset,
+                        std::min(piece, stream.size() - offset),
+                        emit);
+    }
+    packetizer.Flush(emit);
+    REQUIRE(packetizer.Buffered() == 0);
+    return units;
+}
+
+// Pictures starting in au, found byte by byte rather than with memchr().
+int
+CountPictures(VideoSink::VideoCodecType codec, const std::vector<uint8_t>& au)
+{
+    int pictures = 0;
+    for (size_t i = 0; i + 5 < au.size(); i++) {
+        if (au[i] != 0 || au[i + 1] != 0 || au[i + 2] != 1) {
+            continue;
+        }
+        const uint8_t* nal = &au[i + 3];
+        if (codec == VideoSink::VideoCodecType::kH264) {
+            uint8_t type = nal[0] & 0x1f;
+            if ((type == 1 || type == 2 || type == 5) && (nal[1] & 0x80)) {
+                pictures++;
+            }
+        } else if (((nal[0] >> 1) & 0x3f) <= 31 && (nal[2] & 0x80)) {
+            pictures++;
+        }
+    }
+    return pictures;
+}
+
+void
+CheckStream(VideoSink::VideoCodecType codec, const std::string& name)
+{
+    auto stream = ReadFile(name);
+    auto units  = Packetize(codec, stream, stream.size());
+    REQUIRE(units.size() > 10);
+
+    // Nothing lost, nothing added, one picture each.
+    std::vector<uint8_t> joined;
+    for (const auto& au : units) {
+        REQUIRE(CountPictures(codec, au) == 1);
+        joined.insert(joined.end(), au.begin(), au.end());
+    }
+    REQUIRE(joined == stream);
+    REQUIRE(ClassifyAnnexBFrame(codec, units[0].data(), units[0].size()) ==
+            FrameClass::kKeyframe);
+
+    // Piece boundaries must not matter, not even inside a start code.
+    REQUIRE(Packetize(codec, stream, 4096) == units);
+    REQUIRE(Packetize(codec, stream, 4093) == units);
+}
+
+} // namespace
+
+TEST_CASE("H264File", "[annexb_packetizer]")
+{
+    CheckStream(VideoSink::VideoCodecType::kH264, "video-480p.h264");
+}
+
+TEST_CASE("H265File", "[annexb_packetizer]")
+{
+    CheckStream(VideoSink::VideoCodecType::kH265, "video-480p.h265");
+    auto stream = ReadFile("video-480p.h265");
+    REQUIRE(Packetize(VideoSink::VideoCodecType::kH265, stream, 1) ==
+            Packetize(VideoSink::VideoCodecType::kH265, stream, stream.size()));
+}
+
+TEST_CASE("OnlyAnnexBCodecs", "[annexb_packetizer]")
+{
+    REQUIRE_THROWS_AS(AnnexBPacketizer(VideoSink::VideoCodecType::kMJPEG),
+                      std::invalid_argument);
+}
+
+TEST_CASE("SendAccessUnitsSendsWholePictures", "[annexb_packetizer]")
+{
+    auto stream = ReadFile("video-480p.h265");
+    auto units  = Packetize(VideoSink::VideoCodecType::kH265, stream, 4096);
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    std::vector<size_t>     received;
+    std::thread             reader;
+    int                     peer = -1;
+    {
+        VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(
+                         [&](int fd) {
+                             std::lock_guard<std::mutex> lock(mutex);
+                             if (peer >= 0) {
+                                 close(fd);
+                                 return;
+                             }
+                             peer   = fd;
+                             reader = std::thread([&, fd]() {
+                                 VideoSink::camera_header_t header;
+                                 while (::recv(fd, &header, sizeof(header),
+                                               MSG_WAITALL) == sizeof(header)) {
+                                     std::vector<uint8_t> data(header.size);
+                                     if (::recv(fd, data.data(), data.size(),
+                                                MSG_WAITALL) !=
+                                         ssize_t(data.size())) {
+                                         break;
+                                     }
+                                     std::lock_guard<std::mutex> lock(mutex);
+                                     received.push_back(data.size());
+                                     cv.notify_all();
+                                 }
+                             });
+                         }),
+                       [](const VideoSink::camera_config_cmd_t&) {});
+        auto deadline = steady_clock::now() + seconds(5);
+        while (!sink.IsConnected() && steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(milliseconds(2));
+        }
+        REQUIRE(sink.IsConnected());
+
+        REQUIRE(std::get<0>(sink.SendAccessUnits(stream.data(), 16)) == -1);
+        sink.SetFrameCodec(VideoSink::VideoCodecType::kH265);
+        for (size_t offset = 0; offset < stream.size(); offset += 4096) {
+            size_t piece = std::min<size_t>(4096, stream.size() - offset);
+            REQUIRE(std::get<0>(sink.SendAccessUnits(
+                      stream.data() + offset, piece)) == ssize_t(piece));
+        }
+        REQUIRE(std::get<0>(sink.FlushAccessUnits()) ==
+                ssize_t(units.back().size()));
+
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(cv.wait_for(lock, seconds(5), [&]() {
+            return received.size() >= units.size();
+        }));
+    }
+    ::shutdown(peer, SHUT_RDWR);
+    reader.join();
+    close(peer);
+
+    std::vector<size_t> sizes;
+    for (const auto& au : units) {
+        sizes.push_back(au.size());
+    }
+    REQUIRE(received == sizes);
+}
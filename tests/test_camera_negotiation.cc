@@ -0,0 +1,227 @@
+/**
+ * @file test_camera_negotiation.cc
+ * @brief Capability request / camera info exchange with deadlines.
+ * @version 0.1
+ * @date 2021-08-20
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// Plays the Camera VHal: answers REQUST_CAPABILITY and CAMERA_INFO, or not.
+class NegotiationPeer
+{
+public:
+    enum class Reply
+    {
+        kAnswer,
+        kNack,
+        kSilent,
+    };
+
+    ~NegotiationPeer()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        for (int fd : fds_) {
+            close(fd);
+        }
+    }
+
+    LoopbackStreamSocketClient::PeerCallback Callback()
+    {
+        return [this](int fd) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fds_.push_back(fd);
+            threads_.emplace_back([this, fd]() { Serve(fd); });
+        };
+    }
+
+    void SetReply(Reply reply) { reply_ = reply; }
+
+    // Drop the current connection; the sink reconnects.
+    void Disconnect()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ::shutdown(fds_.back(), SHUT_RDWR);
+    }
+
+private:
+    static bool ReadAll(int fd, void* data, size_t size)
+    {
+        return ::recv(fd, data, size, MSG_WAITALL) == ssize_t(size);
+    }
+
+    void Serve(int fd)
+    {
+        VideoSink::camera_header_t header;
+        while (ReadAll(fd, &header, sizeof(header))) {
+            std::vector<uint8_t> body(header.size);
+            if (!body.empty() && !ReadAll(fd, body.data(), body.size())) {
+                return;
+            }
+            if (reply_ == Reply::kSilent) {
+                continue;
+            }
+            if (header.type ==
+                VideoSink::camera_packet_type_t::REQUST_CAPABILITY) {
+                struct
+                {
+                    VideoSink::camera_header_t     header;
+                    VideoSink::camera_capability_t capability;
+                } reply = {};
+                reply.header.type = VideoSink::camera_packet_type_t::CAPABILITY;
+                reply.header.size = sizeof(reply.capability);
+                reply.capability.codec_type = VideoSink::VideoCodecType::kH265;
+                reply.capability.maxNumberOfCameras = 2;
+                ::send(fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+            } else if (header.type ==
+                       VideoSink::camera_packet_type_t::CAMERA_INFO) {
+                struct
+                {
+                    VideoSink::camera_header_t header;
+                    VideoSink::CameraAck       ack;
+                } reply = {};
+                reply.header.type = VideoSink::camera_packet_type_t::ACK;
+                reply.header.size = sizeof(reply.ack);
+                reply.ack         = reply_ == Reply::kNack
+                                      ? VideoSink::NACK_CONFIG
+                                      : VideoSink::ACK_CONFIG;
+                ::send(fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+            }
+        }
+    }
+
+    std::atomic<Reply>       reply_ = Reply::kAnswer;
+    std::mutex               mutex_;
+    std::vector<int>         fds_;
+    std::vector<std::thread> threads_;
+};
+
+std::vector<VideoSink::camera_info_t>
+OneCamera()
+{
+    std::vector<VideoSink::camera_info_t> camera_info(1);
+    camera_info[0].cameraId   = 0;
+    camera_info[0].codec_type = VideoSink::VideoCodecType::kH265;
+    camera_info[0].resolution = VideoSink::FrameResolution::k1080p;
+    return camera_info;
+}
+
+} // namespace
+
+TEST_CASE("CapabilityAndAck", "[camera_negotiation]")
+{
+    NegotiationPeer peer;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    REQUIRE_FALSE(sink.GetCachedCameraCapability());
+
+    auto capability = sink.GetCameraCapabilty();
+    REQUIRE(capability);
+    REQUIRE(capability->codec_type == VideoSink::VideoCodecType::kH265);
+    REQUIRE(capability->maxNumberOfCameras == 2);
+    REQUIRE(sink.SetCameraCapabilty(OneCamera()));
+
+    auto cached = sink.GetCachedCameraCapability();
+    REQUIRE(cached);
+    REQUIRE(cached->maxNumberOfCameras == 2);
+
+    // Requests issued back to back are answered in order.
+    auto first  = sink.RequestCameraCapability(seconds(5));
+    auto second = sink.SendCameraInfo(OneCamera(), seconds(5));
+    REQUIRE(first.get());
+    REQUIRE(second.get());
+}
+
+TEST_CASE("NackIsFailure", "[camera_negotiation]")
+{
+    NegotiationPeer peer;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    peer.SetReply(NegotiationPeer::Reply::kNack);
+    REQUIRE_FALSE(sink.SendCameraInfo(OneCamera(), seconds(5)).get());
+}
+
+TEST_CASE("LostAckTimesOut", "[camera_negotiation]")
+{
+    NegotiationPeer peer;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    peer.SetReply(NegotiationPeer::Reply::kSilent);
+
+    std::promise<bool> acked;
+    auto               start = steady_clock::now();
+    sink.SendCameraInfo(OneCamera(), milliseconds(100), [&acked](bool ok) {
+        acked.set_value(ok);
+    });
+    auto result = acked.get_future();
+    REQUIRE(result.wait_for(seconds(5)) == std::future_status::ready);
+    REQUIRE_FALSE(result.get());
+    REQUIRE(steady_clock::now() - start >= milliseconds(100));
+
+    // The next request is not stuck behind the lost one.
+    peer.SetReply(NegotiationPeer::Reply::kAnswer);
+    REQUIRE(sink.RequestCameraCapability(seconds(5)).get());
+}
+
+TEST_CASE("ReconnectFailsPendingKeepsCache", "[camera_negotiation]")
+{
+    NegotiationPeer peer;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    REQUIRE(sink.GetCameraCapabilty());
+
+    peer.SetReply(NegotiationPeer::Reply::kSilent);
+    auto pending = sink.RequestCameraCapability(seconds(30));
+    std::this_thread::sleep_for(milliseconds(20));
+    peer.Disconnect();
+
+    REQUIRE(pending.wait_for(seconds(5)) == std::future_status::ready);
+    REQUIRE_FALSE(pending.get());
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    auto cached = sink.GetCachedCameraCapability();
+    REQUIRE(cached);
+    REQUIRE(cached->codec_type == VideoSink::VideoCodecType::kH265);
+}
@@ -0,0 +1,190 @@
+/**
+ * @file test_camera_stream.cc
+ * @brief Per-camera streams of one VideoSink sharing the socket.
+ * @version 0.1
+ * @date 2021-08-19
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// Plays the Camera VHal: reassembles CAMERA_STREAM_DATA frames and records
+// the order in which they complete.
+class StreamPeer
+{
+public:
+    ~StreamPeer()
+    {
+        if (fd_ >= 0) {
+            ::shutdown(fd_, SHUT_RDWR);
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    LoopbackStreamSocketClient::PeerCallback Callback()
+    {
+        return [this](int fd) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (fd_ >= 0) {
+                close(fd);
+                return;
+            }
+            fd_ = fd;
+            cv_.notify_all();
+        };
+    }
+
+    // Start reading; until then the sink's writes pile up in the socket.
+    void Start()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        REQUIRE(cv_.wait_for(lock, seconds(5), [this]() { return fd_ >= 0; }));
+        thread_ = std::thread([this]() { ReadLoop(); });
+    }
+
+    bool WaitFrames(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(
+          lock, seconds(5), [this, count]() { return done_.size() >= count; });
+    }
+
+    std::vector<uint32_t> Order()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return done_;
+    }
+
+    std::vector<uint8_t> Frame(uint32_t camera_id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return frames_[camera_id];
+    }
+
+private:
+    bool ReadAll(void* data, size_t size)
+    {
+        return ::recv(fd_, data, size, MSG_WAITALL) == ssize_t(size);
+    }
+
+    void ReadLoop()
+    {
+        VideoSink::camera_header_t       header;
+        VideoSink::camera_stream_chunk_t chunk;
+        while (ReadAll(&header, sizeof(header))) {
+            REQUIRE(header.type ==
+                    VideoSink::camera_packet_type_t::CAMERA_STREAM_DATA);
+            REQUIRE(ReadAll(&chunk, sizeof(chunk)));
+            std::vector<uint8_t> data(header.size - sizeof(chunk));
+            REQUIRE(ReadAll(data.data(), data.size()));
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& frame = frames_[chunk.cameraId];
+            REQUIRE(frame.size() == chunk.offset);
+            frame.insert(frame.end(), data.begin(), data.end());
+            if (frame.size() == chunk.frame_size) {
+                done_.push_back(chunk.cameraId);
+                cv_.notify_all();
+            }
+        }
+    }
+
+    std::mutex                                mutex_;
+    std::condition_variable                   cv_;
+    int                                       fd_ = -1;
+    std::thread                               thread_;
+    std::map<uint32_t, std::vector<uint8_t>> frames_;
+    std::vector<uint32_t>                     done_;
+};
+
+} // namespace
+
+TEST_CASE("OneStreamPerCamera", "[camera_stream]")
+{
+    StreamPeer peer;
+    VideoSink  sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    auto front = sink.OpenCameraStream(1);
+    REQUIRE(front);
+    REQUIRE(front->CameraId() == 1);
+    REQUIRE_FALSE(sink.OpenCameraStream(1));
+    front.reset();
+    REQUIRE(sink.OpenCameraStream(1));
+}
+
+TEST_CASE("LargeFrameDoesNotBlockOtherCamera", "[camera_stream]")
+{
+    StreamPeer peer;
+    VideoSink  sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    auto deadline = steady_clock::now() + seconds(5);
+    while (!sink.IsConnected() && steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(2));
+    }
+    REQUIRE(sink.IsConnected());
+
+    auto back  = sink.OpenCameraStream(0);
+    auto front = sink.OpenCameraStream(1);
+
+    // 4 MB is far more than the socket buffers hold, so the back camera's
+    // sender is stuck in the middle of it when the front camera's frame
+    // comes in.
+    std::vector<uint8_t> large(4 << 20);
+    for (size_t i = 0; i < large.size(); i++) {
+        large[i] = uint8_t(i * 7);
+    }
+    std::vector<uint8_t> small(4096, 0xf0);
+    REQUIRE(std::get<0>(back->SendDataPacket(large.data(), large.size())) ==
+            ssize_t(large.size()));
+    std::this_thread::sleep_for(milliseconds(50));
+    REQUIRE(std::get<0>(front->SendDataPacket(small.data(), small.size())) ==
+            ssize_t(small.size()));
+    std::this_thread::sleep_for(milliseconds(20));
+
+    peer.Start();
+    REQUIRE(peer.WaitFrames(2));
+    REQUIRE(peer.Order() == std::vector<uint32_t>{ 1, 0 });
+    REQUIRE(peer.Frame(0) == large);
+    REQUIRE(peer.Frame(1) == small);
+    REQUIRE(back->GetDroppedFrameCount() == 0);
+    REQUIRE(front->GetDroppedFrameCount() == 0);
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_congestion_estimator.cc
+ * @brief Congestion verdicts, suggested rates and the VideoSink monitor.
+ * @version 0.1
+ * @date 2021-08-30
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "congestion_estimator.h"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// Accepts connections and never reads: the socket fills up.
+class StalledPeer
+{
+public:
+    ~StalledPeer()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+            close(fd);
+        }
+    }
+
+    LoopbackStreamSocketClient::PeerCallback Callback()
+    {
+        return [this](int fd) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fds_.push_back(fd);
+        };
+    }
+
+private:
+    std::mutex       mutex_;
+    std::vector<int> fds_;
+};
+
+// 200 ms in which 1 Mbit went out without trouble.
+CongestionEstimator::Sample
+ClearSample()
+{
+    CongestionEstimator::Sample sample;
+    sample.interval = milliseconds(200);
+    sample.bytes    = 25000;
+    sample.frames   = 6;
+    return sample;
+}
+
+} // namespace
+
+TEST_CASE("ClearLinkKeepsTheCeiling", "[congestion_estimator]")
+{
+    CongestionEstimator estimator(2000000);
+    auto                report = estimator.Update(ClearSample());
+    REQUIRE_FALSE(report.congested);
+    REQUIRE(report.throughput_bps == 1000000);
+    REQUIRE(report.target_bitrate_bps == 2000000);
+    // Measured 30 fps, not paced.
+    REQUIRE(report.target_frame_rate == 30);
+}
+
+TEST_CASE("EachSignalMeansCongestion", "[congestion_estimator]")
+{
+    auto sample = ClearSample();
+    SECTION("Blocked in writes")
+    {
+        sample.send_blocked = milliseconds(30);
+    }
+    SECTION("Queue half full")
+    {
+        sample.queue_depth    = 2;
+        sample.queue_capacity = 4;
+    }
+    SECTION("Socket backlog")
+    {
+        sample.socket_backlog = CongestionEstimator::kMinBacklog + 1;
+    }
+    CongestionEstimator estimator(2000000);
+    REQUIRE(estimator.Update(sample).congested);
+
+    // Below any of the thresholds.
+    CongestionEstimator calm(2000000);
+    auto                quiet = ClearSample();
+    quiet.send_blocked        = milliseconds(10);
+    quiet.queue_depth         = 1;
+    quiet.queue_capacity      = 4;
+    quiet.socket_backlog      = CongestionEstimator::kMinBacklog;
+    REQUIRE_FALSE(calm.Update(quiet).congested);
+}
+
+TEST_CASE("BacksOffThenRecovers", "[congestion_estimator]")
+{
+    CongestionEstimator estimator(2000000);
+    auto                congested = ClearSample();
+    congested.send_blocked        = milliseconds(100);
+    congested.frame_rate          = 30;
+
+    // Below what got through.
+    auto report = estimator.Update(congested);
+    REQUIRE(report.target_bitrate_bps == 850000);
+    REQUIRE(report.target_frame_rate == 13);
+    report = estimator.Update(congested);
+    REQUIRE(report.target_bitrate_bps == 722500);
+
+    // Never below a tenth of the ceiling, even if nothing gets through.
+    congested.bytes = 0;
+    for (int i = 0; i < 20; i++) {
+        report = estimator.Update(congested);
+    }
+    REQUIRE(report.target_bitrate_bps == 200000);
+
+    // Held for a while once clear, then raised by 5% of the ceiling.
+    for (int i = 1; i < CongestionEstimator::kClearIntervals; i++) {
+        REQUIRE(estimator.Update(ClearSample()).target_bitrate_bps == 200000);
+    }
+    REQUIRE(estimator.Update(ClearSample()).target_bitrate_bps == 300000);
+    REQUIRE(estimator.Update(ClearSample()).target_bitrate_bps == 400000);
+}
+
+TEST_CASE("CeilingFollowsThroughputWithoutMax", "[congestion_estimator]")
+{
+    CongestionEstimator estimator(0);
+    REQUIRE(estimator.Update({}).target_bitrate_bps == 0);
+    REQUIRE(estimator.Update(ClearSample()).target_bitrate_bps == 1000000);
+    // A faster interval raises the ceiling; the target climbs towards it.
+    auto faster  = ClearSample();
+    faster.bytes = 50000;
+    REQUIRE(estimator.Update(faster).target_bitrate_bps == 1100000);
+}
+
+TEST_CASE("MonitorSeesAStalledVHal", "[congestion_estimator]")
+{
+    StalledPeer peer;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+
+    std::mutex                               mutex;
+    std::condition_variable                  cv;
+    std::vector<VideoSink::CongestionReport> reports;
+    REQUIRE_FALSE(sink.EnableCongestionMonitor(milliseconds(0), 0, {}));
+    REQUIRE(sink.EnableCongestionMonitor(
+      milliseconds(20), 0, [&](const VideoSink::CongestionReport& report) {
+          std::lock_guard<std::mutex> lock(mutex);
+          reports.push_back(report);
+          cv.notify_all();
+      }));
+    REQUIRE_FALSE(sink.EnableCongestionMonitor(
+      milliseconds(20), 0, [](const VideoSink::CongestionReport&) {}));
+
+    // Fill the socket until a write would block.
+    sink.SetSendTimeout(100);
+    std::vector<uint8_t> frame(64 * 1024, 1);
+    while (std::get<0>(sink.SendDataPacket(frame.data(), frame.size())) != -1) {
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    REQUIRE(cv.wait_for(lock, seconds(5), [&]() {
+        return std::any_of(reports.begin(), reports.end(),
+                           [](const VideoSink::CongestionReport& report) {
+                               return report.congested &&
+                                      report.socket_backlog > 0 &&
+                                      report.target_bitrate_bps > 0;
+                           });
+    }));
+}
@@ -0,0 +1,221 @@
+/**
+ * @file test_event_loop.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-11
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "event_loop.h"
+#include "sensor_interface.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+int
+ThreadCount()
+{
+    int  count = 0;
+    DIR* dir   = opendir("/proc/self/task");
+    while (struct dirent* entry = readdir(dir)) {
+        count += entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return count;
+}
+
+// Listening end of one sensors-socket<N>.
+class SensorVhal
+{
+public:
+    SensorVhal(const std::string& dir, int instance)
+      : path_{ dir + "/sensors-socket" + std::to_string(instance) }
+    {
+        listen_fd_              = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr = {};
+        addr.sun_family         = AF_UNIX;
+        strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+        REQUIRE(::bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        REQUIRE(::listen(listen_fd_, 1) == 0);
+    }
+
+    ~SensorVhal()
+    {
+        Drop();
+        close(listen_fd_);
+        unlink(path_.c_str());
+    }
+
+    bool Accept()
+    {
+        struct pollfd pfd = { listen_fd_, POLLIN, 0 };
+        if (::poll(&pfd, 1, 5000) != 1) {
+            return false;
+        }
+        conn_ = ::accept(listen_fd_, nullptr, nullptr);
+        return conn_ >= 0;
+    }
+
+    bool SendEnable(int32_t period_ns)
+    {
+        SensorInterface::CtrlPacket packet = { SENSOR_TYPE_ACCELEROMETER,
+                                               1,
+                                               period_ns };
+        return ::send(conn_, &packet, sizeof(packet), 0) == sizeof(packet);
+    }
+
+    void Drop()
+    {
+        if (conn_ >= 0) {
+            close(conn_);
+            conn_ = -1;
+        }
+    }
+
+private:
+    std::string path_;
+    int         listen_fd_ = -1;
+    int         conn_      = -1;
+};
+
+struct Received
+{
+    std::mutex                 mutex;
+    std::set<std::thread::id>  threads;
+    std::vector<int32_t>       periods;
+
+    void Add(int32_t period)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+        periods.push_back(period);
+    }
+
+    size_t Wait(size_t count)
+    {
+        auto deadline = steady_clock::now() + seconds(5);
+        while (steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (periods.size() >= count) {
+                    return periods.size();
+                }
+            }
+            std::this_thread::sleep_for(milliseconds(5));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        return periods.size();
+    }
+};
+
+std::string
+MakeTempDir()
+{
+    char tmpl[] = "/tmp/vhal-loop-XXXXXX";
+    REQUIRE(mkdtemp(tmpl) != nullptr);
+    return tmpl;
+}
+
+} // namespace
+
+TEST_CASE("ObjectsShareLoopThreads", "[event_loop]")
+{
+    constexpr int kInstances = 16;
+    auto          dir        = MakeTempDir();
+    {
+        auto loop = std::make_shared<EventLoop>(2);
+        REQUIRE(loop->ThreadCount() == 2);
+
+        std::vector<std::unique_ptr<SensorVhal>> vhals;
+        for (int i = 0; i < kInstances; i++) {
+            vhals.push_back(std::make_unique<SensorVhal>(dir, i));
+        }
+
+        Received received;
+        int      threads_before = ThreadCount();
+        std::vector<std::unique_ptr<SensorInterface>> sensors;
+        for (int i = 0; i < kInstances; i++) {
+            sensors.push_back(std::make_unique<SensorInterface>(
+              UnixConnectionInfo{ dir, i, loop }));
+            sensors.back()->RegisterCallback(
+              [&received](const SensorInterface::CtrlPacket& packet) {
+                  received.Add(packet.samplingPeriod_ns);
+              });
+        }
+        REQUIRE(ThreadCount() == threads_before);
+
+        for (int i = 0; i < kInstances; i++) {
+            REQUIRE(vhals[i]->Accept());
+            REQUIRE(vhals[i]->SendEnable(i));
+        }
+        REQUIRE(received.Wait(kInstances) == kInstances);
+        REQUIRE(received.threads.size() <= 2);
+
+        // A dropped VHAL connection is re-established on the loop.
+        vhals[3]->Drop();
+        REQUIRE(vhals[3]->Accept());
+        REQUIRE(vhals[3]->SendEnable(100));
+        REQUIRE(received.Wait(kInstances + 1) == kInstances + 1);
+        REQUIRE(received.periods.back() == 100);
+
+        sensors.clear();
+    }
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("ThreadPerObjectWithoutLoop", "[event_loop]")
+{
+    auto dir = MakeTempDir();
+    {
+        SensorVhal vhal(dir, 0);
+        Received   received;
+        int        threads_before = ThreadCount();
+
+        SensorInterface sensor(UnixConnectionInfo{ dir, 0 });
+        sensor.RegisterCallback(
+          [&received](const SensorInterface::CtrlPacket& packet) {
+              received.Add(packet.samplingPeriod_ns);
+          });
+        REQUIRE(ThreadCount() == threads_before + 1);
+
+        REQUIRE(vhal.Accept());
+        REQUIRE(vhal.SendEnable(42));
+        REQUIRE(received.Wait(1) == 1);
+        REQUIRE(received.periods[0] == 42);
+    }
+    rmdir(dir.c_str());
+}
@@ -0,0 +1,201 @@
+/**
+ * @file test_frame_buffer.cc
+ * @brief FrameBuffer ownership, pool recycling and sending without a copy.
+ * @version 0.1
+ * @date 2021-08-26
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "frame_buffer.h"
+#include "frame_queue.h"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// FrameBuffer over a static byte that counts its releases.
+FrameBuffer
+CountedBuffer(uint8_t& byte, int& releases)
+{
+    return FrameBuffer(&byte, 1, [&releases](uint8_t*) { releases++; });
+}
+
+} // namespace
+
+TEST_CASE("ReleasedOnceByTheLastOwner", "[frame_buffer]")
+{
+    uint8_t byte     = 7;
+    int     releases = 0;
+    {
+        FrameBuffer first = CountedBuffer(byte, releases);
+        FrameBuffer second(std::move(first));
+        REQUIRE_FALSE(first);
+        REQUIRE(second.Data() == &byte);
+        REQUIRE(second.Size() == 1);
+
+        FrameBuffer third;
+        third = std::move(second);
+        REQUIRE(releases == 0);
+
+        // Assigning over a buffer releases it.
+        third = CountedBuffer(byte, releases);
+        REQUIRE(releases == 1);
+    }
+    REQUIRE(releases == 2);
+
+    auto heap = FrameBuffer::Allocate(16);
+    REQUIRE(heap.Capacity() == 16);
+    heap.SetSize(32);
+    REQUIRE(heap.Size() == 16);
+    heap.Reset();
+    REQUIRE_FALSE(heap);
+}
+
+TEST_CASE("PoolRecyclesBuffers", "[frame_buffer]")
+{
+    FrameBufferPool pool(64, 2);
+    auto            a = pool.Acquire();
+    auto            b = pool.Acquire();
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(a.Size() == 64);
+    REQUIRE(pool.Available() == 0);
+    REQUIRE_FALSE(pool.Acquire());
+
+    uint8_t* data = a.Data();
+    a.Reset();
+    REQUIRE(pool.Available() == 1);
+    REQUIRE(pool.Acquire().Data() == data);
+    REQUIRE(pool.Available() == 1);
+}
+
+TEST_CASE("BuffersOutliveThePool", "[frame_buffer]")
+{
+    FrameBuffer frame;
+    {
+        FrameBufferPool pool(64, 1);
+        frame = pool.Acquire();
+    }
+    // Still valid memory; ASan/valgrind would flag a use after free here.
+    memset(frame.Data(), 0xab, frame.Size());
+    frame.Reset();
+}
+
+TEST_CASE("QueueReleasesDroppedBuffers", "[frame_buffer]")
+{
+    uint8_t    bytes[3] = { 1, 2, 3 };
+    int        releases = 0;
+    FrameQueue queue(2, SendQueuePolicy::kDropOldest);
+    for (auto& byte : bytes) {
+        REQUIRE(queue.Push(CountedBuffer(byte, releases)));
+    }
+    // The oldest went back to its owner as it was dropped.
+    REQUIRE(releases == 1);
+
+    std::vector<uint8_t> frame;
+    FrameBuffer          buffer;
+    REQUIRE(queue.Pop(frame, nullptr, &buffer));
+    REQUIRE(buffer.Data() == &bytes[1]);
+    buffer.Reset();
+    REQUIRE(releases == 2);
+
+    // Without a FrameBuffer to take it, the frame is copied out.
+    REQUIRE(queue.Pop(frame));
+    REQUIRE(frame == std::vector<uint8_t>{ 3 });
+    REQUIRE(releases == 3);
+}
+
+TEST_CASE("SendDataPacketTakesOwnership", "[frame_buffer]")
+{
+    std::mutex                        mutex;
+    std::condition_variable           cv;
+    std::vector<std::vector<uint8_t>> received;
+    std::thread                       reader;
+    int                               peer = -1;
+
+    FrameBufferPool pool(1024, 2);
+    {
+        VideoSink sink(std::make_unique<LoopbackStreamSocketClient>([&](int fd) {
+                           std::lock_guard<std::mutex> lock(mutex);
+                           if (peer >= 0) {
+                               close(fd);
+                               return;
+                           }
+                           peer   = fd;
+                           reader = std::thread([&, fd]() {
+                               VideoSink::camera_header_t header;
+                               while (::recv(fd, &header, sizeof(header),
+                                             MSG_WAITALL) == sizeof(header)) {
+                                   std::vector<uint8_t> data(header.size);
+                                   if (::recv(fd, data.data(), data.size(),
+                                              MSG_WAITALL) != ssize_t(data.size())) {
+                                       break;
+                                   }
+                                   std::lock_guard<std::mutex> lock(mutex);
+                                   received.push_back(std::move(data));
+                                   cv.notify_all();
+                               }
+                           });
+                       }),
+                       [](const VideoSink::camera_config_cmd_t&) {});
+        REQUIRE(sink.WaitForReconnect(seconds(5)));
+
+        // Synchronous: back in the pool as soon as the call returns.
+        auto frame = pool.Acquire();
+        memset(frame.Data(), 1, frame.Size());
+        frame.SetSize(100);
+        REQUIRE(std::get<0>(sink.SendDataPacket(std::move(frame))) == 100);
+        REQUIRE(pool.Available() == 2);
+
+        // Async: queued without a copy and released by the sender thread.
+        REQUIRE(sink.EnableAsyncSend(4, SendQueuePolicy::kBlock));
+        for (uint8_t value = 2; value < 12; value++) {
+            do {
+                frame = pool.Acquire();
+            } while (!frame);
+            memset(frame.Data(), value, frame.Size());
+            REQUIRE(std::get<0>(sink.SendDataPacket(std::move(frame))) == 1024);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(cv.wait_for(lock, seconds(5), [&]() { return received.size() == 11; }));
+    }
+    ::shutdown(peer, SHUT_RDWR);
+    reader.join();
+    close(peer);
+
+    REQUIRE(pool.Available() == 2);
+    REQUIRE(received[0] == std::vector<uint8_t>(100, 1));
+    for (uint8_t value = 2; value < 12; value++) {
+        REQUIRE(received[value - 1] == std::vector<uint8_t>(1024, value));
+    }
+}
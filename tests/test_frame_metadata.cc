@@ -0,0 +1,280 @@
+/**
+ * @file test_frame_metadata.cc
+ * @brief Negotiation and wire format of CAMERA_DATA_EXT frame metadata.
+ * @version 0.1
+ * @date 2021-08-25
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+struct DataPacket
+{
+    VideoSink::camera_packet_type_t    type;
+    VideoSink::camera_frame_metadata_t metadata = {};
+    std::vector<uint8_t>               frame;
+};
+
+// Plays the Camera VHal: advertises features, acks camera info and keeps
+// the data packets it receives.
+class MetadataPeer
+{
+public:
+    explicit MetadataPeer(uint32_t features) : features_{ features } {}
+
+    ~MetadataPeer()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        for (int fd : fds_) {
+            close(fd);
+        }
+    }
+
+    LoopbackStreamSocketClient::PeerCallback Callback()
+    {
+        return [this](int fd) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fds_.push_back(fd);
+            threads_.emplace_back([this, fd]() { Serve(fd); });
+        };
+    }
+
+    // Drop the current connection; the sink reconnects.
+    void Disconnect()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ::shutdown(fds_.back(), SHUT_RDWR);
+    }
+
+    std::vector<DataPacket> WaitForPackets(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, seconds(5), [&]() { return packets_.size() >= count; });
+        return packets_;
+    }
+
+private:
+    static bool ReadAll(int fd, void* data, size_t size)
+    {
+        return ::recv(fd, data, size, MSG_WAITALL) == ssize_t(size);
+    }
+
+    void Serve(int fd)
+    {
+        VideoSink::camera_header_t header;
+        while (ReadAll(fd, &header, sizeof(header))) {
+            std::vector<uint8_t> body(header.size);
+            if (!body.empty() && !ReadAll(fd, body.data(), body.size())) {
+                return;
+            }
+            if (header.type ==
+                VideoSink::camera_packet_type_t::REQUST_CAPABILITY) {
+                struct
+                {
+                    VideoSink::camera_header_t     header;
+                    VideoSink::camera_capability_t capability;
+                } reply = {};
+                reply.header.type = VideoSink::camera_packet_type_t::CAPABILITY;
+                reply.header.size = sizeof(reply.capability);
+                reply.capability.maxNumberOfCameras = 1;
+                reply.capability.features           = features_;
+                ::send(fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+            } else if (header.type ==
+                       VideoSink::camera_packet_type_t::CAMERA_INFO) {
+                struct
+                {
+                    VideoSink::camera_header_t header;
+                    VideoSink::CameraAck       ack;
+                } reply = {};
+                reply.header.type = VideoSink::camera_packet_type_t::ACK;
+                reply.header.size = sizeof(reply.ack);
+                reply.ack         = VideoSink::ACK_CONFIG;
+                ::send(fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+            } else {
+                DataPacket packet{ header.type };
+                size_t     offset = 0;
+                if (header.type ==
+                    VideoSink::camera_packet_type_t::CAMERA_DATA_EXT) {
+                    if (body.size() < sizeof(packet.metadata)) {
+                        return;
+                    }
+                    memcpy(&packet.metadata, body.data(), sizeof(packet.metadata));
+                    offset = sizeof(packet.metadata);
+                }
+                packet.frame.assign(body.begin() + offset, body.end());
+                std::lock_guard<std::mutex> lock(mutex_);
+                packets_.push_back(std::move(packet));
+                cv_.notify_all();
+            }
+        }
+    }
+
+    const uint32_t           features_;
+    std::mutex               mutex_;
+    std::condition_variable  cv_;
+    std::vector<int>         fds_;
+    std::vector<std::thread> threads_;
+    std::vector<DataPacket>  packets_;
+};
+
+std::vector<VideoSink::camera_info_t>
+OneCamera(uint32_t features)
+{
+    std::vector<VideoSink::camera_info_t> camera_info(1);
+    camera_info[0].codec_type = VideoSink::VideoCodecType::kH264;
+    camera_info[0].resolution = VideoSink::FrameResolution::k1080p;
+    camera_info[0].features   = features;
+    return camera_info;
+}
+
+// SPS, PPS, IDR slice; then a P slice.
+const std::vector<uint8_t> kIdr = { 0, 0, 0, 1, 0x67, 0x42, 0, 0, 1, 0x68,
+                                    0xce, 0, 0, 0, 1, 0x65, 0x88, 0x84 };
+const std::vector<uint8_t> kP   = { 0, 0, 0, 1, 0x41, 0x9a, 0x02 };
+
+} // namespace
+
+TEST_CASE("MetadataOnceNegotiated", "[frame_metadata]")
+{
+    MetadataPeer peer(VideoSink::kFeatureFrameMetadata);
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    sink.SetFrameCodec(VideoSink::VideoCodecType::kH264);
+
+    // Not negotiated yet: plain CAMERA_DATA.
+    REQUIRE(std::get<0>(sink.SendDataPacket(kP.data(), kP.size())) ==
+            ssize_t(kP.size()));
+
+    auto capability = sink.GetCameraCapabilty();
+    REQUIRE(capability);
+    REQUIRE(capability->features == VideoSink::kFeatureFrameMetadata);
+    REQUIRE(sink.SetCameraCapabilty(OneCamera(VideoSink::kFeatureFrameMetadata)));
+    REQUIRE(sink.IsFrameMetadataEnabled());
+
+    REQUIRE(std::get<0>(sink.SendDataPacket(kIdr.data(), kIdr.size(), 1000)) ==
+            ssize_t(kIdr.size()));
+    REQUIRE(std::get<0>(sink.SendDataPacket(
+              kP.data(), kP.size(), 2000, VideoSink::kFrameDiscontinuity)) ==
+            ssize_t(kP.size()));
+    REQUIRE(std::get<0>(sink.SendDataPacket(kP.data(), kP.size())) ==
+            ssize_t(kP.size()));
+
+    auto packets = peer.WaitForPackets(4);
+    REQUIRE(packets.size() == 4);
+    REQUIRE(packets[0].type == VideoSink::camera_packet_type_t::CAMERA_DATA);
+    REQUIRE(packets[0].frame == kP);
+    for (size_t i = 1; i < packets.size(); i++) {
+        REQUIRE(packets[i].type ==
+                VideoSink::camera_packet_type_t::CAMERA_DATA_EXT);
+        REQUIRE(packets[i].metadata.sequence == packets[1].metadata.sequence + i - 1);
+    }
+
+    // First frame on the connection that carries metadata.
+    REQUIRE(packets[1].frame == kIdr);
+    REQUIRE(packets[1].metadata.capture_timestamp_ns == 1000);
+    REQUIRE(packets[1].metadata.flags ==
+            (VideoSink::kFrameKeyframe | VideoSink::kFrameDiscontinuity));
+    // The caller's flags are kept.
+    REQUIRE(packets[2].frame == kP);
+    REQUIRE(packets[2].metadata.capture_timestamp_ns == 2000);
+    REQUIRE(packets[2].metadata.flags == VideoSink::kFrameDiscontinuity);
+    // Stamped with the time of the call.
+    REQUIRE(packets[3].metadata.flags == 0);
+    REQUIRE(packets[3].metadata.capture_timestamp_ns > 2000);
+    REQUIRE(packets[3].metadata.send_timestamp_ns >=
+            packets[3].metadata.capture_timestamp_ns);
+}
+
+TEST_CASE("BothSidesMustAgree", "[frame_metadata]")
+{
+    SECTION("VHal without the feature")
+    {
+        MetadataPeer peer(0);
+        VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                       [](const VideoSink::camera_config_cmd_t&) {});
+        REQUIRE(sink.WaitForReconnect(seconds(5)));
+        REQUIRE(sink.GetCameraCapabilty());
+        REQUIRE(sink.SetCameraCapabilty(OneCamera(VideoSink::kFeatureFrameMetadata)));
+        REQUIRE_FALSE(sink.IsFrameMetadataEnabled());
+    }
+    SECTION("Client not asking")
+    {
+        MetadataPeer peer(VideoSink::kFeatureFrameMetadata);
+        VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                       [](const VideoSink::camera_config_cmd_t&) {});
+        REQUIRE(sink.WaitForReconnect(seconds(5)));
+        REQUIRE(sink.GetCameraCapabilty());
+        REQUIRE(sink.SetCameraCapabilty(OneCamera(0)));
+        REQUIRE_FALSE(sink.IsFrameMetadataEnabled());
+
+        REQUIRE(std::get<0>(sink.SendDataPacket(kP.data(), kP.size(), 1000)) ==
+                ssize_t(kP.size()));
+        auto packets = peer.WaitForPackets(1);
+        REQUIRE(packets.size() == 1);
+        REQUIRE(packets[0].type == VideoSink::camera_packet_type_t::CAMERA_DATA);
+        REQUIRE(packets[0].frame == kP);
+    }
+}
+
+TEST_CASE("ReconnectRenegotiates", "[frame_metadata]")
+{
+    MetadataPeer peer(VideoSink::kFeatureFrameMetadata);
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    REQUIRE(sink.GetCameraCapabilty());
+    REQUIRE(sink.SetCameraCapabilty(OneCamera(VideoSink::kFeatureFrameMetadata)));
+    REQUIRE(sink.IsFrameMetadataEnabled());
+
+    peer.Disconnect();
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    REQUIRE_FALSE(sink.IsFrameMetadataEnabled());
+    REQUIRE(sink.SetCameraCapabilty(OneCamera(VideoSink::kFeatureFrameMetadata)));
+    REQUIRE(sink.IsFrameMetadataEnabled());
+
+    REQUIRE(std::get<0>(sink.SendDataPacket(kP.data(), kP.size(), 1000)) ==
+            ssize_t(kP.size()));
+    auto packets = peer.WaitForPackets(1);
+    REQUIRE(packets.size() == 1);
+    REQUIRE(packets[0].metadata.flags == VideoSink::kFrameDiscontinuity);
+}
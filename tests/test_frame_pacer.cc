@@ -0,0 +1,131 @@
+/**
+ * @file test_frame_pacer.cc
+ * @brief FramePacer deadlines, skipping and VideoSink::SetFrameRate().
+ * @version 0.1
+ * @date 2021-08-18
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "frame_pacer.h"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+TEST_CASE("WorkBetweenFramesDoesNotDrift", "[frame_pacer]")
+{
+    FramePacer pacer(100);
+    auto       start = steady_clock::now();
+    for (int i = 0; i < 21; i++) {
+        REQUIRE(pacer.WaitNextFrame());
+        // Half a period of "capture and encode" per frame; a relative
+        // sleep would add it to every period.
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    auto elapsed = steady_clock::now() - start;
+    // 20 periods after the first frame, plus the work after the last one.
+    REQUIRE(elapsed >= milliseconds(200));
+    REQUIRE(elapsed < milliseconds(280));
+
+    auto stats = pacer.GetStats();
+    REQUIRE(stats.frames == 21);
+    REQUIRE(stats.skipped == 0);
+    REQUIRE(stats.max_jitter >= stats.mean_jitter);
+}
+
+TEST_CASE("LateFramesSkipTheirDeadlines", "[frame_pacer]")
+{
+    FramePacer pacer(100);
+    REQUIRE(pacer.WaitNextFrame());
+    std::this_thread::sleep_for(milliseconds(35));
+    REQUIRE_FALSE(pacer.WaitNextFrame());
+    auto stats = pacer.GetStats();
+    REQUIRE(stats.skipped >= 2);
+
+    // Back on schedule, not bursting through the missed slots.
+    auto start = steady_clock::now();
+    REQUIRE(pacer.WaitNextFrame());
+    REQUIRE(steady_clock::now() - start > milliseconds(2));
+}
+
+TEST_CASE("ZeroFpsDoesNotPace", "[frame_pacer]")
+{
+    FramePacer pacer(0);
+    auto       start = steady_clock::now();
+    for (int i = 0; i < 1000; i++) {
+        REQUIRE(pacer.WaitNextFrame());
+    }
+    REQUIRE(steady_clock::now() - start < milliseconds(100));
+
+    pacer.SetFrameRate(50);
+    REQUIRE(pacer.GetFrameRate() == 50);
+    start = steady_clock::now();
+    pacer.WaitNextFrame();
+    pacer.WaitNextFrame();
+    REQUIRE(steady_clock::now() - start >= milliseconds(20));
+}
+
+TEST_CASE("VideoSinkPacesFrames", "[frame_pacer]")
+{
+    std::atomic<int> peer = -1;
+    std::thread      drain;
+    VideoSink        sink(std::make_unique<LoopbackStreamSocketClient>(
+                     [&](int fd) {
+                         if (peer >= 0) {
+                             // Reconnect after the test hung up.
+                             close(fd);
+                             return;
+                         }
+                         peer  = fd;
+                         drain = std::thread([fd]() {
+                             std::vector<uint8_t> buf(65536);
+                             while (::recv(fd, buf.data(), buf.size(), 0) > 0) {
+                             }
+                         });
+                     }),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    auto deadline = steady_clock::now() + seconds(5);
+    while (!sink.IsConnected() && steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(2));
+    }
+    REQUIRE(sink.IsConnected());
+
+    sink.SetFrameRate(100);
+    std::vector<uint8_t> frame(4096, 0x11);
+    auto                 start = steady_clock::now();
+    for (int i = 0; i < 11; i++) {
+        auto [sent, error_msg] = sink.SendDataPacket(frame.data(), frame.size());
+        REQUIRE(sent == ssize_t(frame.size()));
+    }
+    REQUIRE(steady_clock::now() - start >= milliseconds(100));
+    REQUIRE(sink.GetPacingStats().frames == 11);
+
+    ::shutdown(peer, SHUT_RDWR);
+    drain.join();
+    close(peer);
+}
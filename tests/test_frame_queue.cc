@@ -0,0 +1,213 @@
+/**
+ * @file test_frame_queue.cc
+ * @brief FrameQueue policies, and VideoSink async mode against a stalled
+ *        peer.
+ * @version 0.1
+ * @date 2021-08-17
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "frame_queue.h"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+void
+PushFrames(FrameQueue& queue, uint8_t first, uint8_t count)
+{
+    for (uint8_t i = first; i < first + count; i++) {
+        queue.Push(&i, 1);
+    }
+}
+
+bool
+PushFrame(FrameQueue& queue, uint8_t id, FrameClass frame_class)
+{
+    return queue.Push(&id, 1, frame_class);
+}
+
+std::vector<uint8_t>
+PopAll(FrameQueue& queue)
+{
+    std::vector<uint8_t> order;
+    std::vector<uint8_t> frame;
+    while (queue.Size() > 0 && queue.Pop(frame)) {
+        order.push_back(frame[0]);
+    }
+    return order;
+}
+
+} // namespace
+
+TEST_CASE("DropOldestKeepsTheNewest", "[frame_queue]")
+{
+    FrameQueue queue(3, SendQueuePolicy::kDropOldest);
+    PushFrames(queue, 0, 5);
+    REQUIRE(queue.Dropped() == 2);
+    REQUIRE(PopAll(queue) == std::vector<uint8_t>{ 2, 3, 4 });
+}
+
+TEST_CASE("DropNewestKeepsTheOldest", "[frame_queue]")
+{
+    FrameQueue queue(3, SendQueuePolicy::kDropNewest);
+    PushFrames(queue, 0, 3);
+    uint8_t late = 9;
+    REQUIRE_FALSE(queue.Push(&late, 1));
+    REQUIRE(queue.Dropped() == 1);
+    REQUIRE(PopAll(queue) == std::vector<uint8_t>{ 0, 1, 2 });
+}
+
+TEST_CASE("LatestOnlyKeepsOneFrame", "[frame_queue]")
+{
+    FrameQueue queue(8, SendQueuePolicy::kLatestOnly);
+    PushFrames(queue, 0, 4);
+    REQUIRE(queue.Dropped() == 3);
+    REQUIRE(PopAll(queue) == std::vector<uint8_t>{ 3 });
+}
+
+TEST_CASE("BlockWaitsForRoom", "[frame_queue]")
+{
+    FrameQueue queue(1, SendQueuePolicy::kBlock);
+    PushFrames(queue, 0, 1);
+    std::atomic<bool> pushed = false;
+    std::thread       producer([&]() {
+        uint8_t next = 1;
+        queue.Push(&next, 1);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(milliseconds(50));
+    REQUIRE_FALSE(pushed);
+
+    std::vector<uint8_t> frame;
+    REQUIRE(queue.Pop(frame));
+    REQUIRE(frame[0] == 0);
+    producer.join();
+    REQUIRE(pushed);
+    REQUIRE(queue.Dropped() == 0);
+    REQUIRE(queue.Pop(frame));
+    REQUIRE(frame[0] == 1);
+}
+
+TEST_CASE("CloseWakesUpBlockedCallers", "[frame_queue]")
+{
+    FrameQueue           queue(1, SendQueuePolicy::kBlock);
+    std::vector<uint8_t> frame;
+    std::thread          consumer([&]() { REQUIRE_FALSE(queue.Pop(frame)); });
+    std::this_thread::sleep_for(milliseconds(20));
+    queue.Close();
+    consumer.join();
+    uint8_t byte = 0;
+    REQUIRE_FALSE(queue.Push(&byte, 1));
+}
+
+TEST_CASE("AsyncSendDoesNotWaitForAStalledVhal", "[frame_queue]")
+{
+    std::atomic<int> peer = -1;
+    VideoSink        sink(std::make_unique<LoopbackStreamSocketClient>(
+                     [&peer](int fd) { peer = fd; }),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.EnableAsyncSend(2, SendQueuePolicy::kLatestOnly));
+    REQUIRE_FALSE(sink.EnableAsyncSend(2, SendQueuePolicy::kBlock));
+    auto deadline = steady_clock::now() + seconds(5);
+    while (!sink.IsConnected() && steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(2));
+    }
+    REQUIRE(sink.IsConnected());
+
+    // The peer never reads, so the socket buffers fill up after a few
+    // frames and the sender thread blocks; the producer must not.
+    std::vector<uint8_t> frame(1 << 20, 0x42);
+    auto                 start = steady_clock::now();
+    for (int i = 0; i < 50; i++) {
+        auto [sent, error_msg] = sink.SendDataPacket(frame.data(), frame.size());
+        REQUIRE(sent == ssize_t(frame.size()));
+    }
+    REQUIRE(steady_clock::now() - start < seconds(2));
+    REQUIRE(sink.GetDroppedFrameCount() > 0);
+
+    ::shutdown(peer, SHUT_RDWR);
+    close(peer);
+}
+
+TEST_CASE("NonReferenceFramesGoFirst", "[frame_queue]")
+{
+    FrameQueue queue(3, SendQueuePolicy::kDropOldest);
+    PushFrame(queue, 0, FrameClass::kKeyframe);
+    PushFrame(queue, 1, FrameClass::kNonReference);
+    PushFrame(queue, 2, FrameClass::kReference);
+    REQUIRE(PushFrame(queue, 3, FrameClass::kReference));
+    REQUIRE(queue.Dropped() == 1);
+    REQUIRE(PopAll(queue) == std::vector<uint8_t>{ 0, 2, 3 });
+}
+
+TEST_CASE("DroppedReferenceWaitsForKeyframe", "[frame_queue]")
+{
+    FrameQueue queue(2, SendQueuePolicy::kDropOldest);
+    PushFrame(queue, 0, FrameClass::kKeyframe);
+    PushFrame(queue, 1, FrameClass::kReference);
+    // Queue full of pictures something may predict from: the new one goes,
+    // and so does everything that may predict from it.
+    REQUIRE_FALSE(PushFrame(queue, 2, FrameClass::kReference));
+    REQUIRE(PopAll(queue) == std::vector<uint8_t>{ 0, 1 });
+    REQUIRE_FALSE(PushFrame(queue, 3, FrameClass::kReference));
+    REQUIRE_FALSE(PushFrame(queue, 4, FrameClass::kNonReference));
+    REQUIRE(PushFrame(queue, 5, FrameClass::kParameterSets));
+    REQUIRE(PushFrame(queue, 6, FrameClass::kKeyframe));
+    REQUIRE(PushFrame(queue, 7, FrameClass::kReference));
+    REQUIRE(queue.Dropped() == 3);
+    REQUIRE(PopAll(queue) == std::vector<uint8_t>{ 5, 6, 7 });
+}
+
+TEST_CASE("KeyframeReplacesQueuedPictures", "[frame_queue]")
+{
+    FrameQueue queue(2, SendQueuePolicy::kLatestOnly);
+    PushFrame(queue, 0, FrameClass::kKeyframe);
+    REQUIRE_FALSE(PushFrame(queue, 1, FrameClass::kReference));
+    PushFrame(queue, 2, FrameClass::kParameterSets);
+    PushFrame(queue, 3, FrameClass::kParameterSets);
+    REQUIRE(PushFrame(queue, 4, FrameClass::kKeyframe));
+    REQUIRE(PopAll(queue) == std::vector<uint8_t>{ 2, 3, 4 });
+}
+
+TEST_CASE("BlockNeverDropsEncodedFrames", "[frame_queue]")
+{
+    FrameQueue queue(1, SendQueuePolicy::kBlock);
+    PushFrame(queue, 0, FrameClass::kKeyframe);
+    std::thread consumer([&queue]() {
+        std::this_thread::sleep_for(milliseconds(20));
+        std::vector<uint8_t> frame;
+        queue.Pop(frame);
+    });
+    REQUIRE(PushFrame(queue, 1, FrameClass::kReference));
+    consumer.join();
+    REQUIRE(queue.Dropped() == 0);
+    REQUIRE(PopAll(queue) == std::vector<uint8_t>{ 1 });
+}
@@ -0,0 +1,259 @@
+/**
+ * @file test_framed_reader.cc
+ * @brief FramedReader over a real socket, and control messages split across
+ *        writes.
+ * @version 0.1
+ * @date 2021-08-12
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "framed_reader.h"
+#include "sensor_interface.h"
+#include "tcp_stream_socket_client.h"
+#include "unix_stream_socket_client.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+using CtrlPacket = SensorInterface::CtrlPacket;
+
+namespace {
+
+// Listening Unix socket at <dir>/<name>.
+class UnixServer
+{
+public:
+    UnixServer(const std::string& dir, const std::string& name)
+      : path_{ dir + "/" + name }
+    {
+        listen_fd_              = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr = {};
+        addr.sun_family         = AF_UNIX;
+        strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+        REQUIRE(::bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        REQUIRE(::listen(listen_fd_, 1) == 0);
+    }
+
+    ~UnixServer()
+    {
+        if (conn_ >= 0) {
+            close(conn_);
+        }
+        close(listen_fd_);
+        unlink(path_.c_str());
+    }
+
+    const std::string& Path() const { return path_; }
+
+    bool Accept()
+    {
+        struct pollfd pfd = { listen_fd_, POLLIN, 0 };
+        if (::poll(&pfd, 1, 5000) != 1) {
+            return false;
+        }
+        conn_ = ::accept(listen_fd_, nullptr, nullptr);
+        return conn_ >= 0;
+    }
+
+    void Write(const void* data, size_t size)
+    {
+        REQUIRE(::send(conn_, data, size, 0) == ssize_t(size));
+    }
+
+private:
+    std::string path_;
+    int         listen_fd_ = -1;
+    int         conn_      = -1;
+};
+
+std::string
+MakeTempDir()
+{
+    char tmpl[] = "/tmp/vhal-reader-XXXXXX";
+    REQUIRE(mkdtemp(tmpl) != nullptr);
+    return tmpl;
+}
+
+std::vector<uint8_t>
+Packets(int count)
+{
+    std::vector<uint8_t> bytes(count * sizeof(CtrlPacket));
+    for (int i = 0; i < count; i++) {
+        CtrlPacket packet = { SENSOR_TYPE_ACCELEROMETER, 1, i };
+        memcpy(bytes.data() + i * sizeof(packet), &packet, sizeof(packet));
+    }
+    return bytes;
+}
+
+// Fill() once there is something to read, like the talker does on POLLIN.
+ssize_t
+FillWhenReadable(IStreamSocketClient& client, FramedReader& reader, size_t max = 0)
+{
+    struct pollfd pfd = { client.GetNativeSocketFd(), POLLIN, 0 };
+    REQUIRE(::poll(&pfd, 1, 5000) == 1);
+    return std::get<0>(reader.Fill(max));
+}
+
+} // namespace
+
+TEST_CASE("SplitFramesWaitForTheRest", "[framed_reader]")
+{
+    auto dir = MakeTempDir();
+    {
+        UnixServer             server(dir, "sock");
+        UnixStreamSocketClient client(server.Path());
+        REQUIRE(std::get<0>(client.Connect()));
+        REQUIRE(server.Accept());
+
+        FramedReader reader(client);
+        auto         bytes = Packets(4);
+        // Three whole packets and half of the fourth in one go.
+        size_t first = 3 * sizeof(CtrlPacket) + sizeof(CtrlPacket) / 2;
+        server.Write(bytes.data(), first);
+        REQUIRE(FillWhenReadable(client, reader) == ssize_t(first));
+
+        CtrlPacket packet;
+        for (int i = 0; i < 3; i++) {
+            REQUIRE(reader.Next(packet));
+            REQUIRE(packet.samplingPeriod_ns == i);
+        }
+        REQUIRE_FALSE(reader.Next(packet));
+        REQUIRE(reader.Buffered() == sizeof(CtrlPacket) / 2);
+
+        server.Write(bytes.data() + first, bytes.size() - first);
+        REQUIRE(FillWhenReadable(client, reader) > 0);
+        REQUIRE(reader.Next(packet));
+        REQUIRE(packet.samplingPeriod_ns == 3);
+        REQUIRE(reader.Buffered() == 0);
+    }
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("FillCompactsAndRespectsMax", "[framed_reader]")
+{
+    auto dir = MakeTempDir();
+    {
+        UnixServer             server(dir, "sock");
+        UnixStreamSocketClient client(server.Path());
+        REQUIRE(std::get<0>(client.Connect()));
+        REQUIRE(server.Accept());
+
+        // Room for exactly two packets.
+        FramedReader reader(client, 2 * sizeof(CtrlPacket));
+        auto         bytes = Packets(3);
+        server.Write(bytes.data(), bytes.size());
+
+        REQUIRE(FillWhenReadable(client, reader) == 2 * sizeof(CtrlPacket));
+        CtrlPacket packet;
+        REQUIRE(reader.Next(packet));
+        // The free space is in front of the second packet now.
+        REQUIRE(FillWhenReadable(client, reader, 1) == 1);
+        REQUIRE(reader.Buffered() == sizeof(CtrlPacket) + 1);
+        REQUIRE(FillWhenReadable(client, reader) == sizeof(CtrlPacket) - 1);
+        REQUIRE(reader.Next(packet));
+        REQUIRE(packet.samplingPeriod_ns == 1);
+        REQUIRE(reader.Next(packet));
+        REQUIRE(packet.samplingPeriod_ns == 2);
+
+        reader.Reset();
+        REQUIRE(reader.Buffered() == 0);
+    }
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("TcpRecvDontWaitReturnsWhatIsQueued", "[framed_reader]")
+{
+    int listen_fd           = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    REQUIRE(::bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    REQUIRE(::listen(listen_fd, 1) == 0);
+    socklen_t len = sizeof(addr);
+    REQUIRE(::getsockname(listen_fd, (struct sockaddr*)&addr, &len) == 0);
+
+    TcpStreamSocketClient client("127.0.0.1", ntohs(addr.sin_port));
+    REQUIRE(std::get<0>(client.Connect()));
+    int conn = ::accept(listen_fd, nullptr, nullptr);
+    REQUIRE(conn >= 0);
+
+    FramedReader reader(client);
+    auto         bytes = Packets(2);
+    REQUIRE(::send(conn, bytes.data(), bytes.size(), 0) == ssize_t(bytes.size()));
+    REQUIRE(FillWhenReadable(client, reader) == ssize_t(bytes.size()));
+
+    // Blocking Recv() still waits for the whole buffer.
+    std::thread writer([conn, &bytes]() {
+        std::this_thread::sleep_for(milliseconds(50));
+        REQUIRE(::send(conn, bytes.data(), 1, 0) == 1);
+        std::this_thread::sleep_for(milliseconds(50));
+        REQUIRE(::send(conn, bytes.data() + 1, bytes.size() - 1, 0) ==
+                ssize_t(bytes.size() - 1));
+    });
+    std::vector<uint8_t> received(bytes.size());
+    REQUIRE(std::get<0>(client.Recv(received.data(), received.size())) ==
+            ssize_t(bytes.size()));
+    writer.join();
+    REQUIRE(received == bytes);
+
+    close(conn);
+    close(listen_fd);
+}
+
+TEST_CASE("SensorPacketSplitAcrossWrites", "[framed_reader]")
+{
+    auto dir = MakeTempDir();
+    {
+        UnixServer              server(dir, "sensors-socket0");
+        std::atomic<int>        count = 0;
+        std::atomic<int32_t>    last  = -1;
+        SensorInterface         sensor(UnixConnectionInfo{ dir, 0 });
+        sensor.RegisterCallback([&](const CtrlPacket& packet) {
+            last = packet.samplingPeriod_ns;
+            count++;
+        });
+        REQUIRE(server.Accept());
+
+        auto bytes = Packets(3);
+        server.Write(bytes.data(), 5);
+        std::this_thread::sleep_for(milliseconds(50));
+        server.Write(bytes.data() + 5, bytes.size() - 5);
+
+        auto deadline = steady_clock::now() + seconds(5);
+        while (count < 3 && steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(milliseconds(5));
+        }
+        REQUIRE(count == 3);
+        REQUIRE(last == 2);
+    }
+    rmdir(dir.c_str());
+}
@@ -0,0 +1,197 @@
+/**
+ * @file test_latency_histogram.cc
+ * @brief Latency percentiles and the VideoSink::GetStats() counters.
+ * @version 0.1
+ * @date 2021-08-27
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "latency_histogram.h"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// Drains data packets and answers REQUST_CAPABILITY.
+class StatsPeer
+{
+public:
+    ~StatsPeer()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        for (int fd : fds_) {
+            close(fd);
+        }
+    }
+
+    LoopbackStreamSocketClient::PeerCallback Callback()
+    {
+        return [this](int fd) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fds_.push_back(fd);
+            threads_.emplace_back([fd]() { Serve(fd); });
+        };
+    }
+
+    // Drop the current connection; the sink reconnects.
+    void Disconnect()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ::shutdown(fds_.back(), SHUT_RDWR);
+    }
+
+private:
+    static void Serve(int fd)
+    {
+        VideoSink::camera_header_t header;
+        while (::recv(fd, &header, sizeof(header), MSG_WAITALL) ==
+               sizeof(header)) {
+            std::vector<uint8_t> body(header.size);
+            if (!body.empty() && ::recv(fd, body.data(), body.size(),
+                                        MSG_WAITALL) != ssize_t(body.size())) {
+                return;
+            }
+            if (header.type ==
+                VideoSink::camera_packet_type_t::REQUST_CAPABILITY) {
+                struct
+                {
+                    VideoSink::camera_header_t     header;
+                    VideoSink::camera_capability_t capability;
+                } reply = {};
+                reply.header.type = VideoSink::camera_packet_type_t::CAPABILITY;
+                reply.header.size = sizeof(reply.capability);
+                ::send(fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+            }
+        }
+    }
+
+    std::mutex               mutex_;
+    std::vector<int>         fds_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace
+
+TEST_CASE("Percentiles", "[latency_histogram]")
+{
+    LatencyHistogram histogram;
+    REQUIRE(histogram.Summary().count == 0);
+
+    // 1..1000 us.
+    for (int i = 1; i <= 1000; i++) {
+        histogram.Record(microseconds(i));
+    }
+    auto summary = histogram.Summary();
+    REQUIRE(summary.count == 1000);
+    REQUIRE(summary.max == microseconds(1000));
+    REQUIRE(summary.mean == nanoseconds(500500));
+    // Never below the true value, at most one bucket (12.5%) above.
+    REQUIRE(summary.p50 >= microseconds(500));
+    REQUIRE(summary.p50 <= microseconds(563));
+    REQUIRE(summary.p99 >= microseconds(990));
+    REQUIRE(summary.p99 <= microseconds(1000));
+}
+
+TEST_CASE("SmallAndHugeValues", "[latency_histogram]")
+{
+    LatencyHistogram histogram;
+    histogram.Record(nanoseconds(0));
+    histogram.Record(nanoseconds(-5));
+    histogram.Record(nanoseconds(3));
+    auto summary = histogram.Summary();
+    REQUIRE(summary.count == 3);
+    REQUIRE(summary.p50 == nanoseconds(0));
+    REQUIRE(summary.max == nanoseconds(3));
+
+    histogram.Record(minutes(10));
+    REQUIRE(histogram.Summary().max == minutes(10));
+    REQUIRE(histogram.Summary().p99 == minutes(10));
+}
+
+TEST_CASE("ConcurrentRecords", "[latency_histogram]")
+{
+    LatencyHistogram         histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&histogram, t]() {
+            for (int i = 0; i < 10000; i++) {
+                histogram.Record(nanoseconds(t * 10000 + i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto summary = histogram.Summary();
+    REQUIRE(summary.count == 40000);
+    REQUIRE(summary.max == nanoseconds(39999));
+}
+
+TEST_CASE("VideoSinkStats", "[latency_histogram]")
+{
+    StatsPeer peer;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+
+    auto stats = sink.GetStats();
+    REQUIRE(stats.frames_sent == 0);
+    REQUIRE(stats.send_latency.count == 0);
+    REQUIRE(stats.reconnects == 0);
+
+    std::vector<uint8_t> frame(1000, 1);
+    for (int i = 0; i < 10; i++) {
+        REQUIRE(std::get<0>(sink.SendDataPacket(frame.data(), frame.size())) ==
+                ssize_t(frame.size()));
+    }
+    REQUIRE(sink.GetCameraCapabilty());
+
+    peer.Disconnect();
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+
+    stats = sink.GetStats();
+    REQUIRE(stats.frames_sent == 10);
+    REQUIRE(stats.bytes_sent == 10000);
+    REQUIRE(stats.send_errors == 0);
+    REQUIRE(stats.frames_dropped == 0);
+    REQUIRE(stats.queue_depth == 0);
+    REQUIRE(stats.reconnects == 1);
+    REQUIRE(stats.send_latency.count == 10);
+    REQUIRE(stats.send_latency.max >= stats.send_latency.p99);
+    REQUIRE(stats.send_blocked >= stats.send_latency.max);
+    REQUIRE(stats.capability_rtt.count == 1);
+    REQUIRE(stats.capability_rtt.max > nanoseconds(0));
+}
@@ -0,0 +1,178 @@
+/**
+ * @file test_log.cc
+ * @brief The library logger: levels, rate limit, sink and AIC_LOG.
+ * @version 0.1
+ * @date 2021-09-01
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "receiver_log.h"
+#include "vhal_log.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace vhal::client;
+
+namespace {
+
+// Collects what reaches the sink; restores the logger's defaults when done.
+class CapturedLog
+{
+public:
+    CapturedLog()
+    {
+        Log::SetSink([this](const LogRecord& record) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            records_.push_back(record);
+        });
+    }
+
+    ~CapturedLog()
+    {
+        Log::Flush();
+        Log::SetSink(nullptr);
+        Log::SetLevel(LogLevel::kInfo);
+        Log::SetRateLimit(20);
+    }
+
+    std::vector<LogRecord> Records()
+    {
+        Log::Flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return records_;
+    }
+
+private:
+    std::mutex             mutex_;
+    std::vector<LogRecord> records_;
+};
+
+int
+Evaluated(int& count)
+{
+    return ++count;
+}
+
+} // namespace
+
+TEST_CASE("SinkReceivesRecords", "[log]")
+{
+    CapturedLog log;
+    VHAL_LOG(kWarning) << "socket " << 7 << " closed\n";
+    VHAL_LOG(kError) << "failed";
+
+    auto records = log.Records();
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].level == LogLevel::kWarning);
+    REQUIRE(records[0].message == "socket 7 closed");
+    REQUIRE(std::string(records[0].function).size() > 0);
+    REQUIRE(records[0].line > 0);
+    REQUIRE(records[0].thread_id > 0);
+    REQUIRE(records[0].suppressed == 0);
+    REQUIRE(records[1].message == "failed");
+}
+
+TEST_CASE("LevelFiltersAndSkipsTheMessage", "[log]")
+{
+    CapturedLog log;
+    int         evaluated = 0;
+
+    REQUIRE(Log::GetLevel() == LogLevel::kInfo);
+    VHAL_LOG(kDebug) << Evaluated(evaluated);
+    VHAL_LOG(kInfo) << Evaluated(evaluated);
+    Log::SetLevel(LogLevel::kError);
+    VHAL_LOG(kWarning) << Evaluated(evaluated);
+    VHAL_LOG(kError) << Evaluated(evaluated);
+    Log::SetLevel(LogLevel::kNone);
+    VHAL_LOG(kError) << Evaluated(evaluated);
+
+    // Filtered statements do not evaluate their operands.
+    REQUIRE(evaluated == 2);
+    auto records = log.Records();
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].message == "1");
+    REQUIRE(records[1].message == "2");
+}
+
+TEST_CASE("RateLimitCountsSuppressed", "[log]")
+{
+    CapturedLog log;
+    Log::SetRateLimit(5);
+
+    auto burst = [](int count) {
+        for (int i = 0; i < count; i++) {
+            VHAL_LOG(kInfo) << "burst " << i;
+        }
+    };
+    // Both bursts normally land in the same second; if a second boundary
+    // falls in between, the second burst starts a fresh window.
+    burst(50);
+    auto records = log.Records();
+    REQUIRE(records.size() >= 5);
+    REQUIRE(records.size() <= 10);
+    REQUIRE(records[0].message == "burst 0");
+
+    // Another call site has its own budget.
+    VHAL_LOG(kInfo) << "other site";
+    records = log.Records();
+    REQUIRE(records.back().message == "other site");
+    REQUIRE(records.back().suppressed == 0);
+
+    Log::SetRateLimit(0);
+    burst(1);
+    records = log.Records();
+    // The next message admitted reports what was refused before it.
+    REQUIRE(records.back().message == "burst 0");
+    REQUIRE(records.back().suppressed > 0);
+}
+
+TEST_CASE("FlushDeliversEverything", "[log]")
+{
+    CapturedLog log;
+    Log::SetRateLimit(0);
+    uint64_t dropped = Log::Dropped();
+
+    for (int i = 0; i < 1000; i++) {
+        VHAL_LOG(kInfo) << i;
+    }
+    auto records = log.Records();
+    REQUIRE(records.size() + (Log::Dropped() - dropped) == 1000);
+    for (size_t i = 1; i < records.size(); i++) {
+        REQUIRE(std::stoi(records[i].message) >
+                std::stoi(records[i - 1].message));
+    }
+}
+
+TEST_CASE("AicLogGoesThroughTheLogger", "[log]")
+{
+    CapturedLog log;
+    Log::SetLevel(LogLevel::kDebug);
+
+    AIC_LOG(LIBVHAL_ERROR, "GPS unknown command. cmd = %c", 'x');
+    AIC_LOG(LIBVHAL_DEBUG, "type: %d code: %d", 1, 2);
+    // LIBVHAL_INFO has never been printed.
+    AIC_LOG(LIBVHAL_INFO, "quiet");
+
+    auto records = log.Records();
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].level == LogLevel::kError);
+    REQUIRE(records[0].message == "GPS unknown command. cmd = x");
+    REQUIRE(records[1].level == LogLevel::kDebug);
+    REQUIRE(records[1].message == "type: 1 code: 2");
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_loopback_transport.cc
+ * @brief VHAL client objects running on LoopbackStreamSocketClient.
+ * @version 0.1
+ * @date 2021-08-13
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "audio_sink.h"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// Collects the peer ends handed out by LoopbackStreamSocketClient.
+class Peers
+{
+public:
+    ~Peers()
+    {
+        for (int fd : fds_) {
+            close(fd);
+        }
+    }
+
+    LoopbackStreamSocketClient::PeerCallback Callback()
+    {
+        return [this](int fd) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fds_.push_back(fd);
+            cv_.notify_all();
+        };
+    }
+
+    // Wait for the count-th connection and return its peer fd.
+    int Wait(size_t count = 1)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        REQUIRE(cv_.wait_for(
+          lock, seconds(5), [this, count]() { return fds_.size() >= count; }));
+        return fds_[count - 1];
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    std::vector<int>        fds_;
+};
+
+template<typename Pred>
+bool
+WaitFor(Pred pred)
+{
+    auto deadline = steady_clock::now() + seconds(5);
+    while (!pred()) {
+        if (steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(milliseconds(2));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("NullClientIsRejected", "[loopback]")
+{
+    REQUIRE_THROWS_AS(
+      VideoSink(std::unique_ptr<IStreamSocketClient>(),
+                [](const VideoSink::camera_config_cmd_t&) {}),
+      std::invalid_argument);
+}
+
+TEST_CASE("VideoSinkOverLoopback", "[loopback]")
+{
+    Peers                         peers;
+    std::atomic<int>              commands = 0;
+    VideoSink::camera_config_cmd_t last;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peers.Callback()),
+                   [&](const VideoSink::camera_config_cmd_t& cmd) {
+                       last = cmd;
+                       commands++;
+                   });
+    int vhal = peers.Wait();
+    REQUIRE(WaitFor([&]() { return sink.IsConnected(); }));
+
+    // Camera VHal -> client: open camera.
+    VideoSink::camera_header_t     header = {
+        VideoSink::camera_packet_type_t::CAMERA_CONFIG,
+        sizeof(VideoSink::camera_config_cmd_t)
+    };
+    VideoSink::camera_config_cmd_t cmd;
+    cmd.cmd = VideoSink::camera_cmd_t::CMD_OPEN;
+    REQUIRE(::send(vhal, &header, sizeof(header), 0) == sizeof(header));
+    REQUIRE(::send(vhal, &cmd, sizeof(cmd), 0) == sizeof(cmd));
+    REQUIRE(WaitFor([&]() { return commands == 1; }));
+    REQUIRE(last.cmd == VideoSink::camera_cmd_t::CMD_OPEN);
+
+    // Client -> Camera VHal: one frame.
+    std::vector<uint8_t> frame(100000, 0x5a);
+    auto [sent, error_msg] = sink.SendDataPacket(frame.data(), frame.size());
+    REQUIRE(sent == ssize_t(frame.size()));
+    VideoSink::camera_header_t data_header;
+    REQUIRE(::recv(vhal, &data_header, sizeof(data_header), MSG_WAITALL) ==
+            sizeof(data_header));
+    REQUIRE(data_header.type == VideoSink::camera_packet_type_t::CAMERA_DATA);
+    REQUIRE(data_header.size == frame.size());
+    std::vector<uint8_t> received(frame.size());
+    REQUIRE(::recv(vhal, received.data(), received.size(), MSG_WAITALL) ==
+            ssize_t(received.size()));
+    REQUIRE(received == frame);
+
+    // Hanging up makes the sink reconnect through a new socketpair.
+    ::shutdown(vhal, SHUT_RDWR);
+    peers.Wait(2);
+}
+
+TEST_CASE("AudioSinkOverLoopback", "[loopback]")
+{
+    using namespace vhal::client::audio;
+
+    Peers                  peers;
+    std::atomic<int>       messages = 0;
+    std::atomic<uint32_t>  data_size = 0;
+    AudioSink sink(std::make_unique<LoopbackStreamSocketClient>(peers.Callback()));
+    sink.RegisterCallback([&](const CtrlMessage& msg) {
+        data_size = msg.data_size;
+        messages++;
+    });
+    int vhal = peers.Wait();
+
+    CtrlMessage msg;
+    msg.cmd       = Command::kData;
+    msg.data_size = 960;
+    REQUIRE(::send(vhal, &msg, sizeof(msg), 0) == sizeof(msg));
+    REQUIRE(WaitFor([&]() { return messages == 1; }));
+    REQUIRE(data_size == 960);
+}
+
+TEST_CASE("ErrorCodeOverloads", "[loopback]")
+{
+    Peers                      peers;
+    LoopbackStreamSocketClient client(peers.Callback());
+    REQUIRE(std::get<0>(client.Connect()));
+    int vhal = peers.Wait();
+
+    std::error_code ec = std::make_error_code(std::errc::io_error);
+    uint8_t         data[64] = {};
+    REQUIRE(client.SendAll(data, sizeof(data), -1, ec) == sizeof(data));
+    REQUIRE_FALSE(ec);
+    REQUIRE(::recv(vhal, data, sizeof(data), MSG_WAITALL) == sizeof(data));
+
+    REQUIRE(client.Recv(data, sizeof(data), MSG_DONTWAIT, ec) == -1);
+    REQUIRE(ec == std::errc::resource_unavailable_try_again);
+
+    ::shutdown(vhal, SHUT_RDWR);
+    REQUIRE(client.SendAll(data, sizeof(data), -1, ec) == -1);
+    REQUIRE(ec == std::errc::broken_pipe);
+
+    // The IOResult overloads format the same error lazily.
+    auto [sent, error_msg] = client.SendAll(data, sizeof(data));
+    REQUIRE(sent == -1);
+    REQUIRE(error_msg == std::make_error_code(std::errc::broken_pipe).message());
+}
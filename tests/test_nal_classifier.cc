@@ -0,0 +1,93 @@
+/**
+ * @file test_nal_classifier.cc
+ * @brief Annex-B frame classification for GOP-aware dropping.
+ * @version 0.1
+ * @date 2021-08-23
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "nal_classifier.h"
+#include <vector>
+
+using namespace vhal::client;
+
+namespace {
+
+FrameClass
+Classify(VideoSink::VideoCodecType codec, const std::vector<uint8_t>& frame)
+{
+    return ClassifyAnnexBFrame(codec, frame.data(), frame.size());
+}
+
+constexpr auto kH264 = VideoSink::VideoCodecType::kH264;
+constexpr auto kH265 = VideoSink::VideoCodecType::kH265;
+
+} // namespace
+
+TEST_CASE("H264", "[nal_classifier]")
+{
+    // SPS, PPS, IDR slice.
+    REQUIRE(Classify(kH264,
+                     { 0, 0, 0, 1, 0x67, 0x42, 0, 0, 1, 0x68, 0xce,
+                       0, 0, 0, 1, 0x65, 0x88, 0x84 }) ==
+            FrameClass::kKeyframe);
+    // AUD, then a P slice with nal_ref_idc 2.
+    REQUIRE(Classify(kH264, { 0, 0, 0, 1, 0x09, 0xf0, 0, 0, 1, 0x41, 0x9a }) ==
+            FrameClass::kReference);
+    // B slice with nal_ref_idc 0.
+    REQUIRE(Classify(kH264, { 0, 0, 1, 0x01, 0x9e }) ==
+            FrameClass::kNonReference);
+    REQUIRE(Classify(kH264, { 0, 0, 0, 1, 0x67, 0x42, 0, 0, 1, 0x68, 0xce }) ==
+            FrameClass::kParameterSets);
+    // SEI only.
+    REQUIRE(Classify(kH264, { 0, 0, 1, 0x06, 0x05 }) ==
+            FrameClass::kNonReference);
+}
+
+TEST_CASE("H265", "[nal_classifier]")
+{
+    // VPS, SPS, PPS, IDR_W_RADL.
+    REQUIRE(Classify(kH265,
+                     { 0, 0, 0, 1, 0x40, 0x01, 0, 0, 1, 0x42, 0x01,
+                       0, 0, 1, 0x44, 0x01, 0, 0, 1, 0x26, 0x01 }) ==
+            FrameClass::kKeyframe);
+    // CRA_NUT.
+    REQUIRE(Classify(kH265, { 0, 0, 1, 0x2a, 0x01 }) == FrameClass::kKeyframe);
+    // TRAIL_R.
+    REQUIRE(Classify(kH265, { 0, 0, 1, 0x02, 0x01 }) == FrameClass::kReference);
+    // TRAIL_N.
+    REQUIRE(Classify(kH265, { 0, 0, 1, 0x00, 0x01 }) ==
+            FrameClass::kNonReference);
+    // RASL_N.
+    REQUIRE(Classify(kH265, { 0, 0, 1, 0x10, 0x01 }) ==
+            FrameClass::kNonReference);
+    REQUIRE(Classify(kH265, { 0, 0, 1, 0x40, 0x01, 0, 0, 1, 0x42, 0x01 }) ==
+            FrameClass::kParameterSets);
+}
+
+TEST_CASE("Opaque", "[nal_classifier]")
+{
+    std::vector<uint8_t> idr = { 0, 0, 1, 0x65, 0x88 };
+    REQUIRE(Classify(VideoSink::VideoCodecType::kMJPEG, idr) ==
+            FrameClass::kOpaque);
+    REQUIRE(Classify(VideoSink::VideoCodecType(0), idr) == FrameClass::kOpaque);
+    // Length-prefixed (AVCC), not Annex-B.
+    REQUIRE(Classify(kH264, { 0, 0, 0, 2, 0x65, 0x88 }) == FrameClass::kOpaque);
+    REQUIRE(Classify(kH264, {}) == FrameClass::kOpaque);
+    REQUIRE(Classify(kH264, { 0, 0, 1 }) == FrameClass::kOpaque);
+}
@@ -0,0 +1,226 @@
+/**
+ * @file test_raw_frame.cc
+ * @brief SendRawFrame(): strided planes on the wire and resolution checks.
+ * @version 0.1
+ * @date 2021-08-28
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// Plays the Camera VHal: opens the camera at a resolution and keeps the
+// data packets it receives.
+class RawFramePeer
+{
+public:
+    ~RawFramePeer()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        for (int fd : fds_) {
+            close(fd);
+        }
+    }
+
+    LoopbackStreamSocketClient::PeerCallback Callback()
+    {
+        return [this](int fd) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fds_.push_back(fd);
+            threads_.emplace_back([this, fd]() { Serve(fd); });
+        };
+    }
+
+    void Open(VideoSink::FrameResolution resolution)
+    {
+        struct
+        {
+            VideoSink::camera_header_t     header;
+            VideoSink::camera_config_cmd_t cmd;
+        } open;
+        open.header.type = VideoSink::camera_packet_type_t::CAMERA_CONFIG;
+        open.header.size = sizeof(open.cmd);
+        open.cmd.cmd     = VideoSink::camera_cmd_t::CMD_OPEN;
+        open.cmd.camera_config.resolution = resolution;
+        std::lock_guard<std::mutex> lock(mutex_);
+        ::send(fds_.back(), &open, sizeof(open), MSG_NOSIGNAL);
+    }
+
+    std::vector<std::vector<uint8_t>> WaitForFrames(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, seconds(5), [&]() { return frames_.size() >= count; });
+        return frames_;
+    }
+
+private:
+    void Serve(int fd)
+    {
+        VideoSink::camera_header_t header;
+        while (::recv(fd, &header, sizeof(header), MSG_WAITALL) ==
+               sizeof(header)) {
+            std::vector<uint8_t> body(header.size);
+            if (!body.empty() && ::recv(fd, body.data(), body.size(),
+                                        MSG_WAITALL) != ssize_t(body.size())) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            frames_.push_back(std::move(body));
+            cv_.notify_all();
+        }
+    }
+
+    std::mutex                        mutex_;
+    std::condition_variable           cv_;
+    std::vector<int>                  fds_;
+    std::vector<std::thread>          threads_;
+    std::vector<std::vector<uint8_t>> frames_;
+};
+
+// A plane of rows x bytes, each row padded to stride with 0xee; row r is
+// filled with base + r.
+std::vector<uint8_t>
+PaddedPlane(size_t rows, size_t bytes, size_t stride, uint8_t base)
+{
+    std::vector<uint8_t> plane(rows * stride, 0xee);
+    for (size_t row = 0; row < rows; row++) {
+        std::fill_n(plane.begin() + row * stride, bytes, uint8_t(base + row));
+    }
+    return plane;
+}
+
+// The same plane without padding.
+std::vector<uint8_t>
+PackedPlane(size_t rows, size_t bytes, uint8_t base)
+{
+    return PaddedPlane(rows, bytes, bytes, base);
+}
+
+void
+Append(std::vector<uint8_t>& to, const std::vector<uint8_t>& from)
+{
+    to.insert(to.end(), from.begin(), from.end());
+}
+
+} // namespace
+
+TEST_CASE("PlanesArePackedOnTheWire", "[raw_frame]")
+{
+    RawFramePeer peer;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+
+    const uint32_t width = 640, height = 480;
+    auto           y     = PaddedPlane(height, width, 704, 0);
+    auto           u     = PaddedPlane(height / 2, width / 2, 384, 10);
+    auto           v     = PaddedPlane(height / 2, width / 2, 352, 20);
+    auto           uv    = PaddedPlane(height / 2, width, 768, 30);
+
+    VideoSink::RawFrame i420;
+    i420.width     = width;
+    i420.height    = height;
+    i420.planes[0] = { y.data(), 704 };
+    i420.planes[1] = { u.data(), 384 };
+    i420.planes[2] = { v.data(), 352 };
+    REQUIRE(std::get<0>(sink.SendRawFrame(i420)) == width * height * 3 / 2);
+
+    // Contiguous luma, padded chroma.
+    auto packed_y = PackedPlane(height, width, 0);
+    VideoSink::RawFrame nv12;
+    nv12.format    = VideoSink::PixelFormat::kNV12;
+    nv12.width     = width;
+    nv12.height    = height;
+    nv12.planes[0] = { packed_y.data(), width };
+    nv12.planes[1] = { uv.data(), 768 };
+    REQUIRE(std::get<0>(sink.SendRawFrame(nv12)) == width * height * 3 / 2);
+
+    std::vector<uint8_t> expected_i420 = packed_y;
+    Append(expected_i420, PackedPlane(height / 2, width / 2, 10));
+    Append(expected_i420, PackedPlane(height / 2, width / 2, 20));
+    std::vector<uint8_t> expected_nv12 = packed_y;
+    Append(expected_nv12, PackedPlane(height / 2, width, 30));
+
+    auto frames = peer.WaitForFrames(2);
+    REQUIRE(frames.size() == 2);
+    REQUIRE(frames[0] == expected_i420);
+    REQUIRE(frames[1] == expected_nv12);
+}
+
+TEST_CASE("RejectsFramesThatDontMatch", "[raw_frame]")
+{
+    RawFramePeer peer;
+    VideoSink sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+
+    std::vector<uint8_t> y(4 * 2, 1), uv(4, 2);
+    VideoSink::RawFrame  small;
+    small.format    = VideoSink::PixelFormat::kNV21;
+    small.width     = 4;
+    small.height    = 2;
+    small.planes[0] = { y.data(), 4 };
+    small.planes[1] = { uv.data(), 4 };
+
+    // Nothing negotiated yet: any consistent geometry goes.
+    REQUIRE(std::get<0>(sink.SendRawFrame(small)) == 12);
+    REQUIRE(peer.WaitForFrames(1).size() == 1);
+
+    auto bad_stride      = small;
+    bad_stride.planes[1] = { uv.data(), 2 };
+    REQUIRE(std::get<0>(sink.SendRawFrame(bad_stride)) == -1);
+    auto odd   = small;
+    odd.height = 3;
+    REQUIRE(std::get<0>(sink.SendRawFrame(odd)) == -1);
+    auto missing   = small;
+    missing.format = VideoSink::PixelFormat::kI420;
+    REQUIRE(std::get<0>(sink.SendRawFrame(missing)) == -1);
+
+    peer.Open(VideoSink::FrameResolution::k720p);
+    auto deadline = steady_clock::now() + seconds(5);
+    IOResult result;
+    do {
+        std::this_thread::sleep_for(milliseconds(1));
+        result = sink.SendRawFrame(small);
+    } while (std::get<0>(result) != -1 && steady_clock::now() < deadline);
+    REQUIRE(std::get<0>(result) == -1);
+    REQUIRE(std::get<1>(result).find("1280x720") != std::string::npos);
+    // Rejected frames never reach the socket, the connection is intact.
+    REQUIRE(sink.IsConnected());
+}
@@ -0,0 +1,116 @@
+/**
+ * @file test_reconnect_policy.cc
+ * @brief
+ * @version 0.1
+ * @date 2021-08-10
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "reconnect_policy.h"
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+extern "C"
+{
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+TEST_CASE("BackoffDoublesUpToMax", "[backoff]")
+{
+    ReconnectPolicy policy("", milliseconds(1), milliseconds(8));
+    REQUIRE(policy.NextDelay() == milliseconds(1));
+
+    milliseconds expected[] = { milliseconds(2), milliseconds(4),
+                                milliseconds(8), milliseconds(8) };
+    for (auto delay : expected) {
+        REQUIRE(policy.WaitBeforeRetry());
+        REQUIRE(policy.NextDelay() == delay);
+    }
+    REQUIRE(policy.Failures() == 4);
+
+    policy.Reset();
+    REQUIRE(policy.Failures() == 0);
+    REQUIRE(policy.NextDelay() == milliseconds(1));
+}
+
+TEST_CASE("WaitIsJitteredWithinDelay", "[backoff]")
+{
+    ReconnectPolicy policy("", milliseconds(40), milliseconds(40));
+    auto            start = steady_clock::now();
+    REQUIRE(policy.WaitBeforeRetry());
+    auto waited = steady_clock::now() - start;
+    REQUIRE(waited >= milliseconds(20));
+    REQUIRE(waited < milliseconds(200));
+}
+
+TEST_CASE("LoggingIsRateLimited", "[backoff]")
+{
+    ReconnectPolicy policy("", milliseconds(0), milliseconds(0));
+    int             logged = 0;
+    for (int i = 0; i < 100; i++) {
+        logged += policy.ShouldLog();
+        policy.WaitBeforeRetry();
+    }
+    // Failures 1, 2, 4, 8, 16, 32, 64.
+    REQUIRE(logged == 7);
+}
+
+TEST_CASE("CancelWakesWaiter", "[backoff]")
+{
+    ReconnectPolicy policy("", seconds(10), seconds(10));
+    std::thread     canceller([&policy]() {
+        std::this_thread::sleep_for(milliseconds(20));
+        policy.Cancel();
+    });
+    auto start = steady_clock::now();
+    REQUIRE(policy.WaitBeforeRetry() == false);
+    REQUIRE(steady_clock::now() - start < seconds(5));
+    canceller.join();
+}
+
+TEST_CASE("SocketCreationWakesWaiter", "[inotify]")
+{
+    char tmpl[] = "/tmp/vhal-reconnect-XXXXXX";
+    REQUIRE(mkdtemp(tmpl) != nullptr);
+    std::string dir  = tmpl;
+    std::string path = dir + "/camera-socket0";
+
+    ReconnectPolicy policy(path, seconds(10), seconds(10));
+    std::thread     creator([&dir, &path]() {
+        std::this_thread::sleep_for(milliseconds(20));
+        // Unrelated files must not end the wait.
+        close(open((dir + "/other").c_str(), O_CREAT | O_WRONLY, 0600));
+        std::this_thread::sleep_for(milliseconds(20));
+        close(open(path.c_str(), O_CREAT | O_WRONLY, 0600));
+    });
+    auto start = steady_clock::now();
+    REQUIRE(policy.WaitBeforeRetry());
+    auto waited = steady_clock::now() - start;
+    REQUIRE(waited >= milliseconds(30));
+    REQUIRE(waited < seconds(5));
+    creator.join();
+
+    unlink(path.c_str());
+    unlink((dir + "/other").c_str());
+    rmdir(dir.c_str());
+}
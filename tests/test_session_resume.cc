@@ -0,0 +1,292 @@
+/**
+ * @file test_session_resume.cc
+ * @brief Negotiation and open state replayed after a reconnect.
+ * @version 0.1
+ * @date 2021-08-31
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "loopback_stream_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+
+namespace {
+
+// Plays the Camera VHal: answers capability requests, acks camera info
+// and sends open/close commands on request.
+class ResumePeer
+{
+public:
+    ~ResumePeer()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        for (int fd : fds_) {
+            close(fd);
+        }
+    }
+
+    LoopbackStreamSocketClient::PeerCallback Callback()
+    {
+        return [this](int fd) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fds_.push_back(fd);
+            threads_.emplace_back([this, fd]() { Serve(fd); });
+        };
+    }
+
+    // Drop the current connection; the sink reconnects.
+    void Disconnect()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ::shutdown(fds_.back(), SHUT_RDWR);
+    }
+
+    void Send(VideoSink::camera_cmd_t cmd, VideoSink::FrameResolution resolution)
+    {
+        struct
+        {
+            VideoSink::camera_header_t     header;
+            VideoSink::camera_config_cmd_t cmd;
+        } msg;
+        msg.header.type = VideoSink::camera_packet_type_t::CAMERA_CONFIG;
+        msg.header.size = sizeof(msg.cmd);
+        msg.cmd.cmd     = cmd;
+        msg.cmd.camera_config.resolution = resolution;
+        std::lock_guard<std::mutex> lock(mutex_);
+        ::send(fds_.back(), &msg, sizeof(msg), MSG_NOSIGNAL);
+    }
+
+    int CapabilityRequests()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capability_requests_;
+    }
+
+    std::vector<std::vector<VideoSink::camera_info_t>> CameraInfos()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return camera_infos_;
+    }
+
+private:
+    static bool ReadAll(int fd, void* data, size_t size)
+    {
+        return ::recv(fd, data, size, MSG_WAITALL) == ssize_t(size);
+    }
+
+    void Serve(int fd)
+    {
+        VideoSink::camera_header_t header;
+        while (ReadAll(fd, &header, sizeof(header))) {
+            std::vector<uint8_t> body(header.size);
+            if (!body.empty() && !ReadAll(fd, body.data(), body.size())) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (header.type ==
+                VideoSink::camera_packet_type_t::REQUST_CAPABILITY) {
+                capability_requests_++;
+                struct
+                {
+                    VideoSink::camera_header_t     header;
+                    VideoSink::camera_capability_t capability;
+                } reply = {};
+                reply.header.type = VideoSink::camera_packet_type_t::CAPABILITY;
+                reply.header.size = sizeof(reply.capability);
+                reply.capability.maxNumberOfCameras = 1;
+                ::send(fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+            } else if (header.type ==
+                       VideoSink::camera_packet_type_t::CAMERA_INFO) {
+                auto info = reinterpret_cast<const VideoSink::camera_info_t*>(
+                  body.data());
+                camera_infos_.emplace_back(
+                  info, info + body.size() / sizeof(*info));
+                struct
+                {
+                    VideoSink::camera_header_t header;
+                    VideoSink::CameraAck       ack;
+                } reply = {};
+                reply.header.type = VideoSink::camera_packet_type_t::ACK;
+                reply.header.size = sizeof(reply.ack);
+                reply.ack         = VideoSink::ACK_CONFIG;
+                ::send(fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+            }
+        }
+    }
+
+    std::mutex                                         mutex_;
+    std::vector<int>                                   fds_;
+    std::vector<std::thread>                           threads_;
+    int                                                capability_requests_ = 0;
+    std::vector<std::vector<VideoSink::camera_info_t>> camera_infos_;
+};
+
+// Collects the ResumeEvents and camera commands a sink reports.
+struct Events
+{
+    std::mutex                           mutex;
+    std::condition_variable              cv;
+    std::vector<VideoSink::ResumeEvent>  resumes;
+    std::vector<VideoSink::camera_cmd_t> cmds;
+
+    VideoSink::CameraCallback OnCommand()
+    {
+        return [this](const VideoSink::camera_config_cmd_t& cmd) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cmds.push_back(cmd.cmd);
+            cv.notify_all();
+        };
+    }
+
+    VideoSink::ResumeCallback OnResume()
+    {
+        return [this](const VideoSink::ResumeEvent& event) {
+            std::lock_guard<std::mutex> lock(mutex);
+            resumes.push_back(event);
+            cv.notify_all();
+        };
+    }
+
+    bool WaitFor(size_t commands, size_t resumed)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, seconds(5), [&]() {
+            return cmds.size() >= commands && resumes.size() >= resumed;
+        });
+    }
+};
+
+std::vector<VideoSink::camera_info_t>
+OneCamera()
+{
+    std::vector<VideoSink::camera_info_t> camera_info(1);
+    camera_info[0].cameraId   = 7;
+    camera_info[0].codec_type = VideoSink::VideoCodecType::kI420;
+    camera_info[0].resolution = VideoSink::FrameResolution::k720p;
+    return camera_info;
+}
+
+} // namespace
+
+TEST_CASE("ReplaysNegotiationAfterReconnect", "[session_resume]")
+{
+    ResumePeer peer;
+    Events     events;
+    VideoSink  sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   events.OnCommand());
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    sink.EnableSessionResume(events.OnResume());
+
+    REQUIRE(sink.GetCameraCapabilty());
+    REQUIRE(sink.SetCameraCapabilty(OneCamera()));
+    peer.Send(VideoSink::CMD_OPEN, VideoSink::FrameResolution::k720p);
+    REQUIRE(events.WaitFor(1, 0));
+
+    peer.Disconnect();
+    REQUIRE(events.WaitFor(1, 1));
+    {
+        std::lock_guard<std::mutex> lock(events.mutex);
+        const auto&                 event = events.resumes[0];
+        REQUIRE(event.acked);
+        REQUIRE(event.capability);
+        REQUIRE(event.capability->maxNumberOfCameras == 1);
+        REQUIRE(event.camera_open);
+        REQUIRE(event.camera_config.resolution ==
+                VideoSink::FrameResolution::k720p);
+    }
+    REQUIRE(peer.CapabilityRequests() == 2);
+    auto infos = peer.CameraInfos();
+    REQUIRE(infos.size() == 2);
+    REQUIRE(infos[1].size() == 1);
+    REQUIRE(infos[1][0].cameraId == 7);
+    REQUIRE(infos[1][0].resolution == VideoSink::FrameResolution::k720p);
+
+    // Still open at 720p on the new connection.
+    std::vector<uint8_t> y(8), uv(4);
+    VideoSink::RawFrame  frame;
+    frame.format    = VideoSink::PixelFormat::kNV12;
+    frame.width     = 4;
+    frame.height    = 2;
+    frame.planes[0] = { y.data(), 4 };
+    frame.planes[1] = { uv.data(), 4 };
+    REQUIRE(std::get<0>(sink.SendRawFrame(frame)) == -1);
+
+    // One event per reconnect, and again on the next one.
+    peer.Disconnect();
+    REQUIRE(events.WaitFor(1, 2));
+    std::this_thread::sleep_for(milliseconds(50));
+    std::lock_guard<std::mutex> lock(events.mutex);
+    REQUIRE(events.resumes.size() == 2);
+}
+
+TEST_CASE("CloseIsCarriedOver", "[session_resume]")
+{
+    ResumePeer peer;
+    Events     events;
+    VideoSink  sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   events.OnCommand());
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    sink.EnableSessionResume(events.OnResume());
+    REQUIRE(sink.SetCameraCapabilty(OneCamera()));
+    peer.Send(VideoSink::CMD_OPEN, VideoSink::FrameResolution::k720p);
+    peer.Send(VideoSink::CMD_CLOSE, VideoSink::FrameResolution::k720p);
+    REQUIRE(events.WaitFor(2, 0));
+
+    peer.Disconnect();
+    REQUIRE(events.WaitFor(2, 1));
+    std::lock_guard<std::mutex> lock(events.mutex);
+    REQUIRE(events.resumes[0].acked);
+    REQUIRE_FALSE(events.resumes[0].camera_open);
+}
+
+TEST_CASE("NothingToResumeBeforeAnAck", "[session_resume]")
+{
+    ResumePeer peer;
+    Events     events;
+    VideoSink  sink(std::make_unique<LoopbackStreamSocketClient>(peer.Callback()),
+                   events.OnCommand());
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    sink.EnableSessionResume(events.OnResume());
+
+    peer.Disconnect();
+    REQUIRE(sink.WaitForReconnect(seconds(5)));
+    std::this_thread::sleep_for(milliseconds(50));
+    REQUIRE(peer.CapabilityRequests() == 0);
+    REQUIRE(peer.CameraInfos().empty());
+    std::lock_guard<std::mutex> lock(events.mutex);
+    REQUIRE(events.resumes.empty());
+}
@@ -0,0 +1,229 @@
+/**
+ * @file test_shm_frame_ring.cc
+ * @brief VideoSink shared-memory ring against a stand-in Camera VHal.
+ * @version 0.1
+ * @date 2021-08-09
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "video_sink.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+extern "C"
+{
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using Header = VideoSink::camera_header_t;
+
+namespace {
+
+/**
+ * Plays the Camera VHal end of the socket: receives the ring memfd, maps it
+ * and consumes frames the way the Android side would.
+ */
+class ShmConsumer
+{
+public:
+    explicit ShmConsumer(const std::string& dir)
+      : path_{ dir + "/camera-socket0" }
+    {}
+
+    ~ShmConsumer()
+    {
+        if (base_ != nullptr) {
+            munmap(base_, len_);
+        }
+        if (conn_ >= 0) {
+            close(conn_);
+        }
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+        }
+        unlink(path_.c_str());
+    }
+
+    bool Listen()
+    {
+        listen_fd_              = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr = {};
+        addr.sun_family         = AF_UNIX;
+        strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+        return ::bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+               ::listen(listen_fd_, 1) == 0;
+    }
+
+    bool Accept()
+    {
+        conn_ = ::accept(listen_fd_, nullptr, nullptr);
+        return conn_ >= 0;
+    }
+
+    // Receive CAMERA_SHM_RING and map the memfd that comes with it.
+    bool ReceiveRing()
+    {
+        Header header;
+        char   control[CMSG_SPACE(sizeof(int))];
+        struct iovec  iov = { &header, sizeof(header) };
+        struct msghdr msg = {};
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(conn_, &msg, MSG_WAITALL) != sizeof(header) ||
+            header.type != VideoSink::CAMERA_SHM_RING ||
+            header.size != sizeof(info_)) {
+            return false;
+        }
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        if (cm == nullptr || cm->cmsg_type != SCM_RIGHTS) {
+            return false;
+        }
+        int fd;
+        memcpy(&fd, CMSG_DATA(cm), sizeof(fd));
+        if (!RecvAll(&info_, sizeof(info_))) {
+            close(fd);
+            return false;
+        }
+        len_  = info_.data_offset + size_t(info_.slot_stride) * info_.slot_count;
+        void* base = mmap(nullptr, len_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            return false;
+        }
+        base_ = static_cast<uint8_t*>(base);
+        return true;
+    }
+
+    // Receive one CAMERA_SHM_DATA descriptor, copy the frame out and free
+    // the slot.
+    bool ReceiveFrame(std::vector<uint8_t>& frame)
+    {
+        Header                            header;
+        VideoSink::camera_shm_slot_desc_t desc;
+        if (!RecvAll(&header, sizeof(header)) ||
+            header.type != VideoSink::CAMERA_SHM_DATA ||
+            !RecvAll(&desc, sizeof(desc)) || desc.slot >= info_.slot_count ||
+            State(desc.slot).load() != VideoSink::SHM_SLOT_READY) {
+            return false;
+        }
+        const uint8_t* data =
+          base_ + info_.data_offset + size_t(desc.slot) * info_.slot_stride;
+        frame.assign(data, data + desc.size);
+        State(desc.slot).store(VideoSink::SHM_SLOT_FREE);
+        return true;
+    }
+
+    const VideoSink::camera_shm_ring_info_t& Info() const { return info_; }
+
+private:
+    bool RecvAll(void* data, size_t size)
+    {
+        return ::recv(conn_, data, size, MSG_WAITALL) == ssize_t(size);
+    }
+
+    std::atomic<uint32_t>& State(uint32_t slot)
+    {
+        return reinterpret_cast<std::atomic<uint32_t>*>(
+          base_ + sizeof(VideoSink::camera_shm_ring_info_t))[slot];
+    }
+
+    std::string                       path_;
+    int                               listen_fd_ = -1;
+    int                               conn_      = -1;
+    uint8_t*                          base_      = nullptr;
+    size_t                            len_       = 0;
+    VideoSink::camera_shm_ring_info_t info_      = {};
+};
+
+std::string
+MakeTempDir()
+{
+    char tmpl[] = "/tmp/vhal-shm-XXXXXX";
+    REQUIRE(mkdtemp(tmpl) != nullptr);
+    return tmpl;
+}
+
+} // namespace
+
+TEST_CASE("SharedMemoryRingNeedsUnixTransport", "[shm]")
+{
+    VideoSink sink(TcpConnectionInfo{ "127.0.0.1", 1 },
+                   [](const VideoSink::camera_config_cmd_t&) {});
+    REQUIRE(sink.EnableSharedMemoryRing(4, 4096) == false);
+}
+
+TEST_CASE("SharedMemoryRingDeliversFrames", "[shm]")
+{
+    auto dir = MakeTempDir();
+    {
+        VideoSink sink(UnixConnectionInfo{ dir, 0 },
+                       [](const VideoSink::camera_config_cmd_t&) {});
+        REQUIRE(sink.EnableSharedMemoryRing(4, 64 * 1024));
+
+        ShmConsumer vhal(dir);
+        REQUIRE(vhal.Listen());
+        REQUIRE(vhal.Accept());
+        REQUIRE(vhal.ReceiveRing());
+        REQUIRE(vhal.Info().magic == VideoSink::kShmRingMagic);
+        REQUIRE(vhal.Info().slot_count == 4);
+        REQUIRE(vhal.Info().slot_size == 64 * 1024);
+
+        // Copying path.
+        std::vector<uint8_t> frame(50000);
+        for (size_t i = 0; i < frame.size(); i++) {
+            frame[i] = uint8_t(i * 7);
+        }
+        auto [sent, error_msg] = sink.SendDataPacket(frame.data(), frame.size());
+        REQUIRE(sent == ssize_t(frame.size()));
+        std::vector<uint8_t> received;
+        REQUIRE(vhal.ReceiveFrame(received));
+        REQUIRE(received == frame);
+
+        // Render straight into the slot.
+        for (int n = 0; n < 10; n++) {
+            VideoSink::SharedFrameSlot slot;
+            REQUIRE(sink.AcquireSharedFrameSlot(slot));
+            REQUIRE(slot.capacity == 64 * 1024);
+            memset(slot.data, n, 1000 + n);
+            auto [sent, error_msg] = sink.CommitSharedFrameSlot(slot, 1000 + n);
+            REQUIRE(sent == 1000 + n);
+            REQUIRE(vhal.ReceiveFrame(received));
+            REQUIRE(received == std::vector<uint8_t>(1000 + n, uint8_t(n)));
+        }
+
+        // Slots the VHAL has not consumed yet cannot be reused.
+        VideoSink::SharedFrameSlot slots[4];
+        for (auto& slot : slots) {
+            REQUIRE(sink.AcquireSharedFrameSlot(slot));
+        }
+        VideoSink::SharedFrameSlot extra;
+        REQUIRE(sink.AcquireSharedFrameSlot(extra) == false);
+        REQUIRE(std::get<0>(sink.CommitSharedFrameSlot(slots[0], 0)) == 0);
+        REQUIRE(sink.AcquireSharedFrameSlot(extra));
+        REQUIRE(extra.index == slots[0].index);
+    }
+    rmdir(dir.c_str());
+}
@@ -0,0 +1,135 @@
+/**
+ * @file test_socket_options.cc
+ * @brief SocketOptions applied by the stream socket clients on Connect().
+ * @version 0.1
+ * @date 2021-08-12
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "tcp_stream_socket_client.h"
+#include "unix_stream_socket_client.h"
+#include <cstring>
+#include <string>
+extern "C"
+{
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+
+namespace {
+
+int
+GetIntOption(int fd, int level, int name)
+{
+    int       value = 0;
+    socklen_t len   = sizeof(value);
+    REQUIRE(::getsockopt(fd, level, name, &value, &len) == 0);
+    return value;
+}
+
+} // namespace
+
+TEST_CASE("TcpClientAppliesOptions", "[socket_options]")
+{
+    int listen_fd           = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    REQUIRE(::bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    REQUIRE(::listen(listen_fd, 1) == 0);
+    socklen_t len = sizeof(addr);
+    REQUIRE(::getsockname(listen_fd, (struct sockaddr*)&addr, &len) == 0);
+
+    SocketOptions options;
+    options.send_buffer_size = 64 * 1024;
+    options.recv_buffer_size = 32 * 1024;
+    options.tcp_nodelay      = true;
+    options.priority         = 5;
+    options.send_timeout_ms  = 1500;
+
+    TcpStreamSocketClient client("127.0.0.1", ntohs(addr.sin_port), options);
+    REQUIRE(std::get<0>(client.Connect()));
+    int fd = client.GetNativeSocketFd();
+
+    // The kernel doubles the requested buffer sizes for bookkeeping.
+    REQUIRE(GetIntOption(fd, SOL_SOCKET, SO_SNDBUF) == 2 * 64 * 1024);
+    REQUIRE(GetIntOption(fd, SOL_SOCKET, SO_RCVBUF) == 2 * 32 * 1024);
+    REQUIRE(GetIntOption(fd, IPPROTO_TCP, TCP_NODELAY) != 0);
+    REQUIRE(GetIntOption(fd, SOL_SOCKET, SO_PRIORITY) == 5);
+
+    struct timeval tv = {};
+    len               = sizeof(tv);
+    REQUIRE(::getsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, &len) == 0);
+    REQUIRE(tv.tv_sec == 1);
+    REQUIRE(tv.tv_usec == 500000);
+
+    close(listen_fd);
+}
+
+TEST_CASE("DefaultsLeaveSocketAlone", "[socket_options]")
+{
+    int listen_fd           = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    REQUIRE(::bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    REQUIRE(::listen(listen_fd, 1) == 0);
+    socklen_t len = sizeof(addr);
+    REQUIRE(::getsockname(listen_fd, (struct sockaddr*)&addr, &len) == 0);
+
+    TcpStreamSocketClient client("127.0.0.1", ntohs(addr.sin_port));
+    REQUIRE(std::get<0>(client.Connect()));
+    REQUIRE(GetIntOption(client.GetNativeSocketFd(), IPPROTO_TCP, TCP_NODELAY) ==
+            0);
+
+    close(listen_fd);
+}
+
+TEST_CASE("TcpOnlyOptionsIgnoredOnUnix", "[socket_options]")
+{
+    char tmpl[] = "/tmp/vhal-opts-XXXXXX";
+    REQUIRE(mkdtemp(tmpl) != nullptr);
+    std::string path = std::string(tmpl) + "/sock";
+
+    int listen_fd           = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {};
+    addr.sun_family         = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    REQUIRE(::bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    REQUIRE(::listen(listen_fd, 1) == 0);
+
+    SocketOptions options;
+    options.send_buffer_size = 128 * 1024;
+    options.tcp_nodelay      = true;
+    options.tcp_quickack     = true;
+
+    UnixStreamSocketClient client(path, options);
+    REQUIRE(std::get<0>(client.Connect()));
+    REQUIRE(GetIntOption(client.GetNativeSocketFd(), SOL_SOCKET, SO_SNDBUF) ==
+            2 * 128 * 1024);
+
+    close(listen_fd);
+    unlink(path.c_str());
+    rmdir(tmpl);
+}
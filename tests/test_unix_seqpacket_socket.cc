@@ -0,0 +1,221 @@
+/**
+ * @file test_unix_seqpacket_socket.cc
+ * @brief UnixSeqpacketSocketClient, and VideoSink/SensorInterface on
+ *        SOCK_SEQPACKET sockets.
+ * @version 0.1
+ * @date 2021-08-16
+ *
+ * Copyright (c) 2021 Intel Corporation
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this
+                          // in one cpp file
+#include "catch.hpp"
+#include "sensor_interface.h"
+#include "unix_seqpacket_socket_client.h"
+#include "video_sink.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+extern "C"
+{
+#include <sys/poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+using namespace vhal::client;
+using namespace std::chrono;
+using CtrlPacket = SensorInterface::CtrlPacket;
+
+namespace {
+
+// Listening SOCK_SEQPACKET socket at <dir>/<name>.
+class SeqpacketServer
+{
+public:
+    SeqpacketServer(const std::string& dir, const std::string& name)
+      : path_{ dir + "/" + name }
+    {
+        listen_fd_              = ::socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        struct sockaddr_un addr = {};
+        addr.sun_family         = AF_UNIX;
+        strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+        REQUIRE(::bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        REQUIRE(::listen(listen_fd_, 1) == 0);
+    }
+
+    ~SeqpacketServer()
+    {
+        if (conn_ >= 0) {
+            close(conn_);
+        }
+        close(listen_fd_);
+        unlink(path_.c_str());
+    }
+
+    const std::string& Path() const { return path_; }
+
+    bool Accept()
+    {
+        struct pollfd pfd = { listen_fd_, POLLIN, 0 };
+        if (::poll(&pfd, 1, 5000) != 1) {
+            return false;
+        }
+        conn_ = ::accept(listen_fd_, nullptr, nullptr);
+        return conn_ >= 0;
+    }
+
+    int Fd() const { return conn_; }
+
+private:
+    std::string path_;
+    int         listen_fd_ = -1;
+    int         conn_      = -1;
+};
+
+std::string
+MakeTempDir()
+{
+    char tmpl[] = "/tmp/vhal-seqpacket-XXXXXX";
+    REQUIRE(mkdtemp(tmpl) != nullptr);
+    return tmpl;
+}
+
+template<typename Pred>
+bool
+WaitFor(Pred pred)
+{
+    auto deadline = steady_clock::now() + seconds(5);
+    while (!pred()) {
+        if (steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(milliseconds(2));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("MessagesKeepTheirBoundaries", "[seqpacket]")
+{
+    auto dir = MakeTempDir();
+    {
+        SeqpacketServer           server(dir, "sock");
+        UnixSeqpacketSocketClient client(server.Path());
+        REQUIRE(std::get<0>(client.Connect()));
+        REQUIRE(server.Accept());
+
+        // Two sends, two messages, even though both are queued before the
+        // peer reads.
+        uint8_t         first[3]  = { 1, 2, 3 };
+        uint8_t         second[5] = { 4, 5, 6, 7, 8 };
+        std::error_code ec;
+        REQUIRE(client.SendAll(first, sizeof(first), -1, ec) == sizeof(first));
+        REQUIRE(client.SendAll(second, sizeof(second), -1, ec) == sizeof(second));
+        uint8_t buf[64];
+        REQUIRE(::recv(server.Fd(), buf, sizeof(buf), 0) == sizeof(first));
+        REQUIRE(::recv(server.Fd(), buf, sizeof(buf), 0) == sizeof(second));
+        REQUIRE(buf[0] == 4);
+
+        // One Recv() returns one message.
+        REQUIRE(::send(server.Fd(), first, sizeof(first), 0) == sizeof(first));
+        REQUIRE(::send(server.Fd(), second, sizeof(second), 0) == sizeof(second));
+        REQUIRE(client.Recv(buf, sizeof(buf), 0, ec) == sizeof(first));
+        REQUIRE(client.Recv(buf, sizeof(buf), 0, ec) == sizeof(second));
+
+        // A buffer too small for the message is an error, not half a frame.
+        REQUIRE(::send(server.Fd(), second, sizeof(second), 0) == sizeof(second));
+        REQUIRE(client.Recv(buf, 2, 0, ec) == -1);
+        REQUIRE(ec == std::errc::message_size);
+    }
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("VideoSinkSendsOneMessagePerFrame", "[seqpacket]")
+{
+    auto dir = MakeTempDir();
+    {
+        SeqpacketServer    server(dir, "camera-socket0");
+        UnixConnectionInfo info;
+        info.socket_dir          = dir;
+        info.android_instance_id = 0;
+        info.seqpacket           = true;
+        VideoSink sink(info, [](const VideoSink::camera_config_cmd_t&) {});
+        REQUIRE(server.Accept());
+        REQUIRE(WaitFor([&]() { return sink.IsConnected(); }));
+
+        std::vector<uint8_t> frame(32768, 0x5a);
+        auto [sent, error_msg] = sink.SendDataPacket(frame.data(), frame.size());
+        REQUIRE(sent == ssize_t(frame.size()));
+
+        // Header and payload arrive in a single recv().
+        std::vector<uint8_t> message(sizeof(VideoSink::camera_header_t) +
+                                     frame.size() + 1);
+        REQUIRE(::recv(server.Fd(), message.data(), message.size(), 0) ==
+                ssize_t(message.size() - 1));
+        VideoSink::camera_header_t header;
+        memcpy(&header, message.data(), sizeof(header));
+        REQUIRE(header.type == VideoSink::camera_packet_type_t::CAMERA_DATA);
+        REQUIRE(header.size == frame.size());
+        REQUIRE(message[sizeof(header)] == 0x5a);
+    }
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("SensorInterfaceOverSeqpacket", "[seqpacket]")
+{
+    auto dir = MakeTempDir();
+    {
+        SeqpacketServer      server(dir, "sensors-socket0");
+        std::atomic<int>     count = 0;
+        std::atomic<int32_t> last  = -1;
+        UnixConnectionInfo   info;
+        info.socket_dir          = dir;
+        info.android_instance_id = 0;
+        info.seqpacket           = true;
+        SensorInterface sensor(info);
+        sensor.RegisterCallback([&](const CtrlPacket& packet) {
+            last = packet.samplingPeriod_ns;
+            count++;
+        });
+        REQUIRE(server.Accept());
+
+        for (int i = 0; i < 3; i++) {
+            CtrlPacket packet = { SENSOR_TYPE_ACCELEROMETER, 1, i };
+            REQUIRE(::send(server.Fd(), &packet, sizeof(packet), 0) ==
+                    sizeof(packet));
+        }
+        REQUIRE(WaitFor([&]() { return count == 3; }));
+        REQUIRE(last == 2);
+
+        // Event header and values arrive as one message.
+        SensorInterface::SensorDataPacket event = {};
+        event.type     = SENSOR_TYPE_ACCELEROMETER;
+        event.fdata[0] = 1.0f;
+        ssize_t sent   = 0;
+        REQUIRE(WaitFor([&]() {
+            sent = std::get<0>(sensor.SendDataPacket(&event));
+            return sent > 0;
+        }));
+        uint8_t buf[256];
+        REQUIRE(::recv(server.Fd(), buf, sizeof(buf), 0) == sent);
+    }
+    rmdir(dir.c_str());
+}